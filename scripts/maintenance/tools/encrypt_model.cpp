@@ -1,42 +1,44 @@
 #include <QCoreApplication>
+#include <QCommandLineParser>
 #include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
 #include <QByteArray>
-#include <QCryptographicHash>
-#include <QDataStream>
-#include <QRandomGenerator>
 #include <QDebug>
 
-// 简单的XOR加密函数
-QByteArray xorEncrypt(const QByteArray &data, const QByteArray &key)
-{
-    QByteArray result;
-    result.resize(data.size());
-
-    for (int i = 0; i < data.size(); ++i)
-    {
-        result[i] = data[i] ^ key[i % key.size()];
-    }
-
-    return result;
-}
+#include "ModelContainer.h"
 
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
 
-    if (argc < 3 || argc > 4)
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Encrypt an ONNX model into the chunked, integrity-checked container.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("input", "Plain ONNX model.");
+    parser.addPositionalArgument("output", "Encrypted output file.");
+    parser.addPositionalArgument("key", "Plain-text key (or set MEDAPP_MODEL_KEY environment variable).", "[key]");
+    const QCommandLineOption metadataOption(QStringList() << "m" << "metadata",
+                                            "JSON file describing input shape, output layout, classes and thresholds.",
+                                            "file");
+    const QCommandLineOption chunkOption("chunk-size", "Chunk size in KiB (default 4096).", "KiB");
+    parser.addOption(metadataOption);
+    parser.addOption(chunkOption);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() < 2 || args.size() > 3)
     {
-        qDebug() << "Usage: encrypt_model <input.onnx> <output.encrypted> [plain-text-key]";
-        qDebug() << "       (or set MEDAPP_MODEL_KEY environment variable)";
+        qDebug().noquote() << parser.helpText();
         return 1;
     }
 
-    QString inputFile = argv[1];
-    QString outputFile = argv[2];
+    QString inputFile = args[0];
+    QString outputFile = args[1];
     QString keyString;
-    if (argc == 4)
+    if (args.size() == 3)
     {
-        keyString = argv[3];
+        keyString = args[2];
     }
     else
     {
@@ -50,7 +52,42 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    // 读取原始模型文件
+    quint32 chunkSize = ModelContainer::kDefaultChunkSize;
+    if (parser.isSet(chunkOption))
+    {
+        bool ok = false;
+        const uint kib = parser.value(chunkOption).toUInt(&ok);
+        if (!ok || kib == 0)
+        {
+            qDebug() << "Invalid chunk size:" << parser.value(chunkOption);
+            return 1;
+        }
+        chunkSize = kib * 1024u;
+    }
+
+    // 元数据先校验再写入，压缩为单行 JSON
+    QByteArray metadata;
+    QString error;
+    if (parser.isSet(metadataOption))
+    {
+        QFile metaFile(parser.value(metadataOption));
+        if (!metaFile.open(QIODevice::ReadOnly))
+        {
+            qDebug() << "Failed to open metadata file:" << metaFile.fileName();
+            return 1;
+        }
+        const QByteArray raw = metaFile.readAll();
+        ModelContainer::Metadata parsed;
+        if (!ModelContainer::parseMetadata(raw, parsed, &error))
+        {
+            qDebug().noquote() << "Invalid metadata:" << error;
+            return 1;
+        }
+        metadata = QJsonDocument::fromJson(raw).toJson(QJsonDocument::Compact);
+        qDebug() << "Metadata:" << (parsed.segmentation ? "segment" : "detect") << parsed.numClasses << "classes";
+    }
+
+    // 读取原始模型文件（按块流式处理，不整体载入内存）
     QFile file(inputFile);
     if (!file.open(QIODevice::ReadOnly))
     {
@@ -58,38 +95,44 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    QByteArray modelData = file.readAll();
-    file.close();
-
     // 使用程序特定的密钥
-    QByteArray key = QCryptographicHash::hash(
-        keyString.toUtf8(),
-        QCryptographicHash::Sha256);
+    const QByteArray key = ModelContainer::deriveKey(keyString);
 
-    // 使用XOR加密（简单但有效）
-    QByteArray encryptedData = xorEncrypt(modelData, key);
-
-    // 添加文件头标识（4字节魔数 + 4字节版本）
-    QByteArray header;
-    QDataStream headerStream(&header, QIODevice::WriteOnly);
-    headerStream << quint32(0x4D594F4C); // "MYOL" 魔数
-    headerStream << quint32(0x00010000); // 版本 1.0.0
-
-    // 保存加密后的文件（包含文件头）
-    QFile outFile(outputFile);
+    // 写入临时文件，成功后再替换，避免中途失败留下半个模型
+    QSaveFile outFile(outputFile);
     if (!outFile.open(QIODevice::WriteOnly))
     {
         qDebug() << "Failed to create output file:" << outputFile;
         return 1;
     }
 
-    outFile.write(header);
-    outFile.write(encryptedData);
-    outFile.close();
+    if (!ModelContainer::write(file, outFile, key, metadata, chunkSize, &error))
+    {
+        qDebug().noquote() << "Encryption failed:" << error;
+        outFile.cancelWriting();
+        return 1;
+    }
+    const qint64 originalSize = file.size();
+    file.close();
+    if (!outFile.commit())
+    {
+        qDebug() << "Failed to write output file:" << outputFile << outFile.errorString();
+        return 1;
+    }
 
     qDebug() << "Model encrypted successfully!";
-    qDebug() << "Original size:" << modelData.size() << "bytes";
-    qDebug() << "Encrypted size:" << encryptedData.size() + 8 << "bytes";
+    qDebug() << "Original size:" << originalSize << "bytes";
+    qDebug() << "Encrypted size:" << QFile(outputFile).size() << "bytes";
+
+    // 回读校验，确认每个块都能正确解密
+    QByteArray roundTrip;
+    ModelContainer::ReadInfo info;
+    if (!ModelContainer::read(outputFile, key, roundTrip, &info, &error))
+    {
+        qDebug().noquote() << "Verification failed:" << error;
+        return 1;
+    }
+    qDebug() << "Verified" << info.chunkCount << "chunks";
 
     return 0;
 }
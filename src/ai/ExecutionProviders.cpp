@@ -0,0 +1,295 @@
+#include "ExecutionProviders.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    struct ProviderName
+    {
+        const char *config;
+        const char *ort;
+    };
+
+    // 配置名与 ONNX Runtime 注册名的对应关系
+    constexpr std::array<ProviderName, 5> kProviders{{{"cpu", "CPUExecutionProvider"},
+                                                      {"dnnl", "DnnlExecutionProvider"},
+                                                      {"xnnpack", "XnnpackExecutionProvider"},
+                                                      {"openvino", "OpenVINOExecutionProvider"},
+                                                      {"cuda", "CUDAExecutionProvider"}}};
+
+    QString tuningFilePath()
+    {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+        QDir().mkpath(dir);
+        return QDir(dir).filePath(QStringLiteral("provider_tuning.ini"));
+    }
+
+    // 调优结果的失效条件：模型、CPU 架构与逻辑核心数、ORT 版本任一变化
+    QString tuningGroup(const QByteArray &modelFingerprint)
+    {
+        QString ortVersion = QStringLiteral("none");
+#ifdef HAVE_ORT
+        ortVersion = QString::fromStdString(Ort::GetVersionString());
+#endif
+        return QStringLiteral("%1_%2x%3_ort%4")
+            .arg(QString::fromLatin1(modelFingerprint.toHex().left(16)))
+            .arg(QSysInfo::currentCpuArchitecture())
+            .arg(QThread::idealThreadCount())
+            .arg(ortVersion);
+    }
+}
+
+namespace ExecutionProviders
+{
+    QStringList available()
+    {
+        QStringList result;
+#ifdef HAVE_ORT
+        try
+        {
+            for (const std::string &name : Ort::GetAvailableProviders())
+            {
+                for (const ProviderName &p : kProviders)
+                {
+                    if (name == p.ort)
+                        result << QString::fromLatin1(p.config);
+                }
+            }
+        }
+        catch (const Ort::Exception &)
+        {
+        }
+#endif
+        if (!result.contains(QStringLiteral("cpu")))
+            result << QStringLiteral("cpu");
+        return result;
+    }
+
+    bool isAvailable(const QString &provider)
+    {
+        static const QStringList compiled = available();
+        return compiled.contains(provider);
+    }
+
+    QStringList parseList(const QString &configured)
+    {
+        QStringList result;
+        for (const QString &part : configured.split(QLatin1Char(','), Qt::SkipEmptyParts))
+        {
+            const QString name = part.trimmed().toLower();
+            if (name.isEmpty() || name == QStringLiteral("auto") || result.contains(name))
+                continue;
+            result << name;
+        }
+        return result;
+    }
+
+    bool loadTuned(const QByteArray &modelFingerprint, Choice &out)
+    {
+        if (modelFingerprint.isEmpty())
+            return false;
+        QSettings settings(tuningFilePath(), QSettings::IniFormat);
+        settings.beginGroup(tuningGroup(modelFingerprint));
+        const QString provider = settings.value("Provider").toString();
+        if (provider.isEmpty())
+            return false;
+        out.provider = provider;
+        out.threads = settings.value("Threads", 0).toInt();
+        return true;
+    }
+
+    void saveTuned(const QByteArray &modelFingerprint, const Measurement &best)
+    {
+        if (modelFingerprint.isEmpty())
+            return;
+        QSettings settings(tuningFilePath(), QSettings::IniFormat);
+        settings.beginGroup(tuningGroup(modelFingerprint));
+        settings.setValue("Provider", best.choice.provider);
+        settings.setValue("Threads", best.choice.threads);
+        settings.setValue("MedianMs", best.medianMs);
+        settings.endGroup();
+        settings.sync();
+    }
+
+    std::vector<int> candidateThreadCounts()
+    {
+        const int ideal = std::max(1, QThread::idealThreadCount());
+        std::vector<int> counts{ideal, ideal / 2, 4, 2};
+        counts.erase(std::remove_if(counts.begin(), counts.end(), [ideal](int n)
+                                    { return n < 1 || n > ideal; }),
+                     counts.end());
+        std::sort(counts.begin(), counts.end(), std::greater<int>());
+        counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+        return counts;
+    }
+
+#ifdef HAVE_ORT
+    bool append(Ort::SessionOptions &opts, const Choice &choice, int gpuDeviceId, QString *error)
+    {
+        if (!isAvailable(choice.provider))
+        {
+            if (error)
+                *error = QStringLiteral("当前 ONNX Runtime 未编入 %1 提供程序").arg(choice.provider);
+            return false;
+        }
+
+        const std::string threads = std::to_string(std::max(0, choice.threads));
+        try
+        {
+            if (choice.provider == QStringLiteral("xnnpack"))
+            {
+                // XNNPACK 使用自己的线程池，ORT 算子内线程设为 1 避免两套线程池争抢核心
+                opts.SetIntraOpNumThreads(1);
+                opts.AddConfigEntry("session.intra_op.allow_spinning", "0");
+                opts.AppendExecutionProvider("XNNPACK", {{"intra_op_num_threads", threads}});
+                return true;
+            }
+
+            if (choice.threads > 0)
+                opts.SetIntraOpNumThreads(choice.threads);
+
+            if (choice.provider == QStringLiteral("dnnl"))
+            {
+                const OrtApi &api = Ort::GetApi();
+                OrtDnnlProviderOptions *dnnl = nullptr;
+                Ort::ThrowOnError(api.CreateDnnlProviderOptions(&dnnl));
+                const char *keys[] = {"use_arena"};
+                const char *values[] = {"1"};
+                OrtStatus *status = api.UpdateDnnlProviderOptions(dnnl, keys, values, 1);
+                if (!status)
+                    status = api.SessionOptionsAppendExecutionProvider_Dnnl(opts, dnnl);
+                api.ReleaseDnnlProviderOptions(dnnl);
+                Ort::ThrowOnError(status);
+            }
+            else if (choice.provider == QStringLiteral("openvino"))
+            {
+                std::unordered_map<std::string, std::string> ov{{"device_type", "CPU"}};
+                if (choice.threads > 0)
+                    ov["num_of_threads"] = threads;
+                opts.AppendExecutionProvider_OpenVINO_V2(ov);
+            }
+            else if (choice.provider == QStringLiteral("cuda"))
+            {
+                OrtCUDAProviderOptions cuda{};
+                cuda.device_id = gpuDeviceId;
+                opts.AppendExecutionProvider_CUDA(cuda);
+            }
+            return true;
+        }
+        catch (const Ort::Exception &e)
+        {
+            if (error)
+                *error = QString::fromUtf8(e.what());
+            return false;
+        }
+    }
+
+    std::vector<Measurement> benchmark(Ort::Env &env, const QByteArray &model, const std::vector<Choice> &candidates,
+                                       int inputWidth, int inputHeight, int runs, int budgetMs,
+                                       const std::atomic_bool *cancel)
+    {
+        std::vector<Measurement> results;
+        QElapsedTimer budget;
+        budget.start();
+        for (const Choice &choice : candidates)
+        {
+            Measurement m;
+            m.choice = choice;
+            if (cancel && cancel->load())
+            {
+                m.error = QStringLiteral("调优已取消，未测试");
+                results.push_back(m);
+                continue;
+            }
+            if (budget.elapsed() > budgetMs)
+            {
+                m.error = QStringLiteral("超出调优时间预算，未测试");
+                results.push_back(m);
+                continue;
+            }
+            try
+            {
+                Ort::SessionOptions opts;
+                opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+                if (!append(opts, choice, 0, &m.error))
+                {
+                    results.push_back(m);
+                    continue;
+                }
+                Ort::Session session(env, model.constData(), static_cast<size_t>(model.size()), opts);
+
+                Ort::AllocatorWithDefaultOptions alloc;
+                Ort::AllocatedStringPtr inputName = session.GetInputNameAllocated(0, alloc);
+                std::vector<Ort::AllocatedStringPtr> outputPtrs;
+                std::vector<const char *> outputNames;
+                for (size_t i = 0; i < session.GetOutputCount(); ++i)
+                {
+                    outputPtrs.emplace_back(session.GetOutputNameAllocated(i, alloc));
+                    outputNames.push_back(outputPtrs.back().get());
+                }
+
+                std::vector<int64_t> shape = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+                if (shape.size() != 4)
+                    shape = {1, 3, inputHeight, inputWidth};
+                shape[0] = 1;
+                if (shape[1] <= 0)
+                    shape[1] = 3;
+                if (shape[2] <= 0)
+                    shape[2] = inputHeight;
+                if (shape[3] <= 0)
+                    shape[3] = inputWidth;
+                // letterbox 填充色，接近真实输入的数值分布；float16 / 8 位输入只需形状与类型正确，填零即可
+                const size_t count = static_cast<size_t>(shape[1] * shape[2] * shape[3]);
+                const ONNXTensorElementDataType inputType = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetElementType();
+                Ort::MemoryInfo mem = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+                std::vector<float> data;
+                std::vector<uint8_t> raw;
+                Ort::Value input{nullptr};
+                if (inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16)
+                {
+                    raw.assign(count * 2, 0);
+                    input = Ort::Value::CreateTensor(mem, raw.data(), raw.size(), shape.data(), shape.size(), inputType);
+                }
+                else if (inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 || inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8)
+                {
+                    raw.assign(count, 0);
+                    input = Ort::Value::CreateTensor(mem, raw.data(), raw.size(), shape.data(), shape.size(), inputType);
+                }
+                else
+                {
+                    data.assign(count, 114.f / 255.f);
+                    input = Ort::Value::CreateTensor<float>(mem, data.data(), data.size(), shape.data(), shape.size());
+                }
+                const char *inputNames[] = {inputName.get()};
+
+                // 首次运行包含内核选择与内存分配，不计时
+                session.Run(Ort::RunOptions{nullptr}, inputNames, &input, 1, outputNames.data(), outputNames.size());
+                std::vector<double> times;
+                for (int r = 0; r < std::max(1, runs); ++r)
+                {
+                    QElapsedTimer t;
+                    t.start();
+                    session.Run(Ort::RunOptions{nullptr}, inputNames, &input, 1, outputNames.data(), outputNames.size());
+                    times.push_back(t.nsecsElapsed() / 1e6);
+                }
+                std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+                m.medianMs = times[times.size() / 2];
+            }
+            catch (const Ort::Exception &e)
+            {
+                m.error = QString::fromUtf8(e.what());
+            }
+            results.push_back(m);
+        }
+        return results;
+    }
+#endif
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+
+#ifdef HAVE_ORT
+#include <onnxruntime_cxx_api.h>
+#endif
+
+/**
+ * @brief ONNX Runtime 执行提供程序的选择与本机调优
+ * @details 配置名均为小写：cpu / dnnl（oneDNN）/ xnnpack / openvino / cuda。
+ *          只有当前 ONNX Runtime 构建中编入的提供程序才会被使用，其余在加载时跳过并回退。
+ *          调优结果按（模型指纹，本机 CPU 架构与核心数，ORT 版本）缓存在本机数据目录，
+ *          只在首次加载某个模型时测一次。
+ */
+namespace ExecutionProviders
+{
+    struct Choice
+    {
+        QString provider{QStringLiteral("cpu")};
+        int threads{0}; // <= 0 表示运行时默认
+    };
+
+    struct Measurement
+    {
+        Choice choice;
+        double medianMs{0.0};
+        QString error; // 非空表示该组合无法创建会话或运行失败
+    };
+
+    // 当前 ONNX Runtime 构建中可用的提供程序（配置名）
+    QStringList available();
+    bool isAvailable(const QString &provider);
+
+    // 解析配置列表：逗号分隔，去重、转小写；"auto" 或空返回空列表
+    QStringList parseList(const QString &configured);
+
+    // 调优缓存
+    bool loadTuned(const QByteArray &modelFingerprint, Choice &out);
+    void saveTuned(const QByteArray &modelFingerprint, const Measurement &best);
+
+    // 调优候选线程数：全部逻辑核心、一半核心、4、2（去重，从大到小）
+    std::vector<int> candidateThreadCounts();
+
+#ifdef HAVE_ORT
+    /**
+     * @brief 在会话选项上启用提供程序并设置线程数
+     * @return 提供程序未编入或初始化失败时返回 false
+     */
+    bool append(Ort::SessionOptions &opts, const Choice &choice, int gpuDeviceId, QString *error = nullptr);
+
+    /**
+     * @brief 对每个组合创建会话并以零输入计时，返回每个组合的中位耗时
+     * @param inputWidth 动态输入尺寸时使用的宽高
+     * @param budgetMs 总时间预算，超出后跳过剩余组合
+     * @param cancel 可选，置位后跳过剩余组合
+     */
+    std::vector<Measurement> benchmark(Ort::Env &env, const QByteArray &model, const std::vector<Choice> &candidates,
+                                       int inputWidth, int inputHeight, int runs = 5, int budgetMs = 30000,
+                                       const std::atomic_bool *cancel = nullptr);
+#endif
+}
@@ -3,18 +3,32 @@
 #include <QDebug>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <optional>
 #include <cfloat>
 #include <climits>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <QFile>
+#include <QDir>
 #include <QFileInfo>
 #include <QByteArray>
+#include <QElapsedTimer>
 #include <QCryptographicHash>
 #include <QDataStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QMutex>
+#include <QSet>
 #include <QVector>
+#include <QFloat16>
 #include "core/AppConfig.h"
 #include "core/ErrorHandler.h"
+#include "ExecutionProviders.h"
+#include "MaskContours.h"
+#include "ModelContainer.h"
 
 #ifdef HAVE_ORT
 #include <onnxruntime_cxx_api.h>
@@ -25,6 +39,48 @@ namespace
 
     inline float sigmoid(float x) { return 1.f / (1.f + std::exp(-x)); }
 
+    // sigmoid 的反函数，用于在 logit 空间直接比较置信度阈值
+    inline float logit(float p)
+    {
+        if (p <= 0.f)
+            return -FLT_MAX;
+        if (p >= 1.f)
+            return FLT_MAX;
+        return std::log(p / (1.f - p));
+    }
+
+    // 已加载模型元数据中的类别（检测 / 分割各一份）；读取只需一次指针加载，发布过的表不释放
+    struct ClassLabels
+    {
+        QStringList names;
+        QVector<QColor> colors; // 与 names 对齐，无效颜色表示使用默认调色板
+    };
+    std::atomic<const ClassLabels *> g_classLabels[2]{};
+    std::mutex g_classLabelsMutex;
+    std::vector<std::unique_ptr<ClassLabels>> g_classLabelsRetained;
+
+    const ClassLabels *publishedLabels(bool segmentation)
+    {
+        return g_classLabels[segmentation ? 1 : 0].load(std::memory_order_acquire);
+    }
+
+    void publishLabels(bool segmentation, const QStringList &names, const QStringList &colors)
+    {
+        const ClassLabels *published = nullptr;
+        if (!names.isEmpty())
+        {
+            auto labels = std::make_unique<ClassLabels>();
+            labels->names = names;
+            labels->colors.resize(names.size());
+            for (int i = 0; i < names.size() && i < colors.size(); ++i)
+                labels->colors[i] = QColor(colors[i]);
+            std::lock_guard<std::mutex> lock(g_classLabelsMutex);
+            g_classLabelsRetained.push_back(std::move(labels));
+            published = g_classLabelsRetained.back().get();
+        }
+        g_classLabels[segmentation ? 1 : 0].store(published, std::memory_order_release);
+    }
+
     struct Box
     {
         float x1, y1, x2, y2, score;
@@ -32,6 +88,8 @@ namespace
         std::vector<float> maskCoeffs;
         double maskAreaPixels{0.0};
         bool hasMask{false};
+        QVector<QPolygonF> contours;
+        double contourAreaPixels{0.0};
     };
 
     inline float IoU(const Box &a, const Box &b)
@@ -132,6 +190,114 @@ namespace
         return res;
     }
 
+    constexpr int kInputStride = 32; // YOLO 最大下采样倍数，网络输入边长须为其整数倍
+
+    // 动态空间维度模型的矩形最小填充：长边缩放到目标尺寸，短边只补到下一个 stride 倍数
+    static QSize minimalPadSize(int srcW, int srcH, int targetW, int targetH, int stride)
+    {
+        const float gain = std::min((float)targetH / srcH, (float)targetW / srcW);
+        const int unpadW = std::max(1, static_cast<int>(std::round(srcW * gain)));
+        const int unpadH = std::max(1, static_cast<int>(std::round(srcH * gain)));
+        const auto roundUp = [stride](int v)
+        { return (v + stride - 1) / stride * stride; };
+        return QSize(std::min(targetW, roundUp(unpadW)), std::min(targetH, roundUp(unpadH)));
+    }
+
+    // 切片矩形：步长为 tile * (1 - overlap)，末行/末列与图像边缘对齐
+    static std::vector<QRect> tileGrid(int width, int height, int tile, float overlap)
+    {
+        const int step = std::max(1, static_cast<int>(std::lround(tile * (1.f - overlap))));
+        const auto starts = [&](int length)
+        {
+            std::vector<int> s;
+            for (int p = 0;; p += step)
+            {
+                if (p + tile >= length)
+                {
+                    s.push_back(std::max(0, length - tile));
+                    break;
+                }
+                s.push_back(p);
+            }
+            return s;
+        };
+        std::vector<QRect> tiles;
+        for (int y : starts(height))
+        {
+            for (int x : starts(width))
+                tiles.emplace_back(x, y, std::min(tile, width), std::min(tile, height));
+        }
+        return tiles;
+    }
+
+    // 跨切片合并：同类按分数从高到低，IoU 超过阈值即为重复；
+    // 被切片边界截断的目标与完整目标 IoU 偏低，改用交集 / 较小框面积（IoS）判断，并把保留框扩展为两者并集
+    static std::vector<InferenceEngine::Detection> mergeTileDetections(std::vector<InferenceEngine::Detection> dets, float iouThr)
+    {
+        constexpr float kMergeIos = 0.7f;
+        std::sort(dets.begin(), dets.end(), [](const auto &a, const auto &b)
+                  { return a.score > b.score; });
+        std::vector<InferenceEngine::Detection> keep;
+        keep.reserve(dets.size());
+        for (auto &d : dets)
+        {
+            bool duplicate = false;
+            for (auto &k : keep)
+            {
+                if (k.cls != d.cls)
+                    continue;
+                const float w = std::max(0.f, std::min(k.x2, d.x2) - std::max(k.x1, d.x1));
+                const float h = std::max(0.f, std::min(k.y2, d.y2) - std::max(k.y1, d.y1));
+                const float inter = w * h;
+                if (inter <= 0.f)
+                    continue;
+                const float areaK = (k.x2 - k.x1) * (k.y2 - k.y1);
+                const float areaD = (d.x2 - d.x1) * (d.y2 - d.y1);
+                if (inter / std::max(1e-6f, areaK + areaD - inter) > iouThr)
+                {
+                    duplicate = true;
+                    break;
+                }
+                if (inter / std::max(1e-6f, std::min(areaK, areaD)) > kMergeIos)
+                {
+                    k.x1 = std::min(k.x1, d.x1);
+                    k.y1 = std::min(k.y1, d.y1);
+                    k.x2 = std::max(k.x2, d.x2);
+                    k.y2 = std::max(k.y2, d.y2);
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (!duplicate)
+                keep.push_back(std::move(d));
+            if (keep.size() >= 300)
+                break;
+        }
+        return keep;
+    }
+
+    // 检测摘要："Detections: N  [类别:数量 ...]"
+    static QString detectionSummary(const std::vector<InferenceEngine::Detection> &dets, int classCount)
+    {
+        classCount = std::max(1, classCount);
+        std::vector<int> counts(static_cast<size_t>(classCount), 0);
+        for (const auto &d : dets)
+            ++counts[static_cast<size_t>(std::clamp(d.cls, 0, classCount - 1))];
+        QStringList parts;
+        for (int k = 0; k < classCount; ++k)
+            parts << QStringLiteral("%1:%2").arg(InferenceEngine::className(k)).arg(counts[static_cast<size_t>(k)]);
+        return QStringLiteral("Detections: %1  [%2]").arg((int)dets.size()).arg(parts.join(QStringLiteral("  ")));
+    }
+
+    // NORMAL 类别号：模型元数据带类别名时按名字查找，否则为默认的 3
+    static int normalClassIndex(int classCount)
+    {
+        for (int k = 0; k < classCount; ++k)
+            if (InferenceEngine::className(k).compare(QStringLiteral("NORMAL"), Qt::CaseInsensitive) == 0)
+                return k;
+        return 3;
+    }
+
     // 缩放框回到原始图像尺寸
     static void scale_boxes_back(std::vector<Box> &boxes, float r, int dw, int dh, int imgW, int imgH)
     {
@@ -149,24 +315,6 @@ namespace
         }
     }
 
-    // XOR解密（简单保护）
-    static QByteArray xorDecrypt(const QByteArray &data, const QByteArray &key)
-    {
-        if (key.isEmpty())
-        {
-            LOG_WARNING("XOR解密密钥为空", "Inference", 5004);
-            return data; // 密钥为空时返回原始数据
-        }
-
-        QByteArray result = data;
-        const int keyLen = key.size();
-        for (int i = 0; i < data.size(); ++i)
-            result[i] = data[i] ^ key[i % keyLen];
-        return result;
-    }
-    constexpr quint32 kModelMagic = 0x4D594F4C; // "MYOL"
-    constexpr int kModelHeaderSize = 8;
-
     struct DetectionPreprocessResult
     {
         std::vector<float> tensor;
@@ -217,6 +365,189 @@ namespace
         return result;
     }
 
+    // 原始像素 -> 8 位显示值的查找表，窗宽窗位算法与 DicomUtils 的显示路径一致
+    static std::vector<uint8_t> buildWindowLut(const InferenceEngine::PixelView &view)
+    {
+        const bool is16 = view.bitsAllocated > 8;
+        auto modality = [&](uint32_t raw) -> double
+        {
+            double v = raw;
+            if (is16 && view.isSigned)
+                v = static_cast<int16_t>(static_cast<uint16_t>(raw));
+            else if (!is16 && view.isSigned)
+                v = static_cast<int8_t>(static_cast<uint8_t>(raw));
+            return view.intercept + view.slope * v;
+        };
+
+        double wc = view.windowCenter;
+        double ww = view.windowWidth;
+        if (!(ww > 0.0))
+        {
+            double lo = std::numeric_limits<double>::max();
+            double hi = std::numeric_limits<double>::lowest();
+            for (int y = 0; y < view.height; ++y)
+            {
+                const uchar *row = static_cast<const uchar *>(view.data) + y * view.stride;
+                for (int x = 0; x < view.width; ++x)
+                {
+                    const double v = modality(is16 ? reinterpret_cast<const uint16_t *>(row)[x] : row[x]);
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                }
+            }
+            ww = hi - lo;
+            wc = 0.5 * (hi + lo);
+            if (!(ww > 0.0))
+                ww = 1.0;
+        }
+
+        const double low = wc - ww / 2.0;
+        const double high = wc + ww / 2.0;
+        std::vector<uint8_t> lut(is16 ? 65536 : 256);
+        for (size_t raw = 0; raw < lut.size(); ++raw)
+        {
+            const double v = modality(static_cast<uint32_t>(raw));
+            int mapped = (v <= low) ? 0 : (v >= high) ? 255
+                                                      : static_cast<int>(std::round((v - low) / (high - low) * 255.0));
+            mapped = std::clamp(mapped, 0, 255);
+            lut[raw] = static_cast<uint8_t>(view.invert ? 255 - mapped : mapped);
+        }
+        return lut;
+    }
+
+    static QImage pixelViewToImage(const InferenceEngine::PixelView &view)
+    {
+        const std::vector<uint8_t> lut = buildWindowLut(view);
+        const bool is16 = view.bitsAllocated > 8;
+        QImage img(view.width, view.height, QImage::Format_Grayscale8);
+        for (int y = 0; y < view.height; ++y)
+        {
+            const uchar *row = static_cast<const uchar *>(view.data) + y * view.stride;
+            uchar *line = img.scanLine(y);
+            for (int x = 0; x < view.width; ++x)
+                line[x] = lut[is16 ? reinterpret_cast<const uint16_t *>(row)[x] : row[x]];
+        }
+        return img;
+    }
+
+    // 一维重采样权重：缩小时按覆盖面积平均，放大时双线性
+    struct AxisTaps
+    {
+        std::vector<int> first;
+        std::vector<int> offset;
+        std::vector<float> weights;
+    };
+
+    static AxisTaps buildAxisTaps(int srcLen, int dstLen)
+    {
+        AxisTaps taps;
+        taps.first.resize(static_cast<size_t>(dstLen));
+        taps.offset.resize(static_cast<size_t>(dstLen) + 1);
+        const double scale = static_cast<double>(srcLen) / dstLen;
+        for (int d = 0; d < dstLen; ++d)
+        {
+            taps.offset[static_cast<size_t>(d)] = static_cast<int>(taps.weights.size());
+            if (scale > 1.0)
+            {
+                const double a = d * scale;
+                const double b = std::min<double>(srcLen, (d + 1) * scale);
+                const int s0 = static_cast<int>(std::floor(a));
+                const int s1 = std::min(srcLen, static_cast<int>(std::ceil(b)));
+                taps.first[static_cast<size_t>(d)] = s0;
+                for (int i = s0; i < s1; ++i)
+                {
+                    const double cover = std::min<double>(b, i + 1) - std::max<double>(a, i);
+                    taps.weights.push_back(static_cast<float>(cover / (b - a)));
+                }
+            }
+            else
+            {
+                const double c = std::clamp((d + 0.5) * scale - 0.5, 0.0, static_cast<double>(srcLen - 1));
+                const int s0 = static_cast<int>(std::floor(c));
+                const float t = static_cast<float>(c - s0);
+                taps.first[static_cast<size_t>(d)] = s0;
+                taps.weights.push_back(1.f - t);
+                if (s0 + 1 < srcLen)
+                    taps.weights.push_back(t);
+            }
+        }
+        taps.offset[static_cast<size_t>(dstLen)] = static_cast<int>(taps.weights.size());
+        return taps;
+    }
+
+    // 原始灰度像素直接生成 letterbox 张量：取窗、缩放与三通道复制一次完成
+    static DetectionPreprocessResult preprocessPixelView(const InferenceEngine::PixelView &view, int targetW, int targetH)
+    {
+        DetectionPreprocessResult result;
+        result.width = targetW;
+        result.height = targetH;
+
+        // 几何与 letterbox() 保持一致（含偏移取偶）
+        const float gain = std::min((float)targetH / view.height, (float)targetW / view.width);
+        const int unpadW = std::max(1, static_cast<int>(std::round(view.width * gain)));
+        const int unpadH = std::max(1, static_cast<int>(std::round(view.height * gain)));
+        const int drawX = (targetW - unpadW) / 2;
+        const int drawY = (targetH - unpadH) / 2;
+        result.scale = gain;
+        result.padW = drawX + (drawX % 2 != 0 ? 1 : 0);
+        result.padH = drawY + (drawY % 2 != 0 ? 1 : 0);
+
+        const std::vector<uint8_t> lut8 = buildWindowLut(view);
+        std::vector<float> lut(lut8.size());
+        for (size_t i = 0; i < lut8.size(); ++i)
+            lut[i] = lut8[i] / 255.f;
+
+        const size_t plane = static_cast<size_t>(targetW) * static_cast<size_t>(targetH);
+        result.tensor.assign(3 * plane, 114.f / 255.f);
+        float *p0 = result.tensor.data();
+        float *p1 = p0 + plane;
+        float *p2 = p1 + plane;
+
+        const AxisTaps xt = buildAxisTaps(view.width, unpadW);
+        const AxisTaps yt = buildAxisTaps(view.height, unpadH);
+        const bool is16 = view.bitsAllocated > 8;
+        const uchar *base = static_cast<const uchar *>(view.data);
+
+        for (int dy = 0; dy < unpadH; ++dy)
+        {
+            const int ty = drawY + dy;
+            if (ty < 0 || ty >= targetH)
+                continue;
+            const int yBegin = yt.offset[static_cast<size_t>(dy)];
+            const int yEnd = yt.offset[static_cast<size_t>(dy) + 1];
+            for (int dx = 0; dx < unpadW; ++dx)
+            {
+                const int tx = drawX + dx;
+                if (tx < 0 || tx >= targetW)
+                    continue;
+                const int xBegin = xt.offset[static_cast<size_t>(dx)];
+                const int xEnd = xt.offset[static_cast<size_t>(dx) + 1];
+                const int x0 = xt.first[static_cast<size_t>(dx)];
+
+                float acc = 0.f;
+                int sy = yt.first[static_cast<size_t>(dy)];
+                for (int yi = yBegin; yi < yEnd; ++yi, ++sy)
+                {
+                    const uchar *row = base + sy * view.stride;
+                    float rowAcc = 0.f;
+                    int sx = x0;
+                    for (int xi = xBegin; xi < xEnd; ++xi, ++sx)
+                    {
+                        const uint32_t raw = is16 ? reinterpret_cast<const uint16_t *>(row)[sx] : row[sx];
+                        rowAcc += xt.weights[static_cast<size_t>(xi)] * lut[raw];
+                    }
+                    acc += yt.weights[static_cast<size_t>(yi)] * rowAcc;
+                }
+
+                const size_t idx = static_cast<size_t>(ty) * static_cast<size_t>(targetW) + static_cast<size_t>(tx);
+                p0[idx] = acc;
+                p1[idx] = acc;
+                p2[idx] = acc;
+            }
+        }
+        return result;
+    }
+
     static std::vector<float> preprocessSegmentationInput(const QImage &image, int targetW, int targetH)
     {
         QImage rgb = image.convertToFormat(QImage::Format_RGB888);
@@ -225,11 +556,118 @@ namespace
     }
 
 #ifdef HAVE_ORT
-    static Ort::Value createInputTensor(std::vector<float> &tensor, int height, int width)
+    // 张量元素格式：float / float16 / 8 位线性量化（real = (q - zeroPoint) * scale）
+    struct TensorFormat
+    {
+        ONNXTensorElementDataType type{ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT};
+        float scale{1.f};
+        int zeroPoint{0};
+    };
+
+    inline bool isSupportedElementType(ONNXTensorElementDataType type)
+    {
+        return type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT || type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 ||
+               type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 || type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+
+    inline bool isQuantizedElementType(ONNXTensorElementDataType type)
+    {
+        return type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8 || type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+    }
+
+    // 只读张量视图：解码与掩码内核按元素类型读取，量化值在读取时反量化
+    struct TensorView
+    {
+        const void *data{nullptr};
+        TensorFormat format;
+
+        float at(size_t i) const
+        {
+            switch (format.type)
+            {
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+                return static_cast<const qfloat16 *>(data)[i];
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+                return (static_cast<const uint8_t *>(data)[i] - format.zeroPoint) * format.scale;
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+                return (static_cast<const int8_t *>(data)[i] - format.zeroPoint) * format.scale;
+            default:
+                return static_cast<const float *>(data)[i];
+            }
+        }
+
+        // out[i] += coeff * view[offset + i]；类型分派在循环外，内层循环保持可向量化
+        void accumulate(size_t offset, size_t count, float coeff, float *out) const
+        {
+            const auto quantized = [&](const auto *src)
+            {
+                const float cs = coeff * format.scale;
+                const float zp = static_cast<float>(format.zeroPoint);
+                for (size_t i = 0; i < count; ++i)
+                    out[i] += cs * (static_cast<float>(src[i]) - zp);
+            };
+            switch (format.type)
+            {
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+            {
+                const qfloat16 *src = static_cast<const qfloat16 *>(data) + offset;
+                for (size_t i = 0; i < count; ++i)
+                    out[i] += coeff * static_cast<float>(src[i]);
+                break;
+            }
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+                quantized(static_cast<const uint8_t *>(data) + offset);
+                break;
+            case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+                quantized(static_cast<const int8_t *>(data) + offset);
+                break;
+            default:
+            {
+                const float *src = static_cast<const float *>(data) + offset;
+                for (size_t i = 0; i < count; ++i)
+                    out[i] += coeff * src[i];
+                break;
+            }
+            }
+        }
+    };
+
+    inline TensorView tensorView(const Ort::Value &value, TensorFormat format)
+    {
+        format.type = value.GetTensorTypeAndShapeInfo().GetElementType();
+        return {value.GetTensorRawData(), format};
+    }
+
+    // 按模型输入类型构造输入张量；非 float 输入转换到 storage（须在 Run 结束前保持有效）
+    static Ort::Value createInputTensor(std::vector<float> &tensor, int height, int width,
+                                        const TensorFormat &format, std::vector<uint8_t> &storage)
     {
         Ort::MemoryInfo mem = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemTypeDefault);
         std::array<int64_t, 4> shape{1, 3, height, width};
-        return Ort::Value::CreateTensor<float>(mem, tensor.data(), tensor.size(), shape.data(), shape.size());
+        switch (format.type)
+        {
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+            storage.resize(tensor.size() * sizeof(qfloat16));
+            qFloatToFloat16(reinterpret_cast<qfloat16 *>(storage.data()), tensor.data(), static_cast<qsizetype>(tensor.size()));
+            return Ort::Value::CreateTensor(mem, storage.data(), storage.size(), shape.data(), shape.size(), format.type);
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        {
+            const bool isSigned = format.type == ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8;
+            const int lo = isSigned ? -128 : 0;
+            const int hi = isSigned ? 127 : 255;
+            const float inv = 1.f / format.scale;
+            storage.resize(tensor.size());
+            for (size_t i = 0; i < tensor.size(); ++i)
+            {
+                const int q = std::clamp(static_cast<int>(std::lround(tensor[i] * inv)) + format.zeroPoint, lo, hi);
+                storage[i] = static_cast<uint8_t>(q & 0xFF);
+            }
+            return Ort::Value::CreateTensor(mem, storage.data(), storage.size(), shape.data(), shape.size(), format.type);
+        }
+        default:
+            return Ort::Value::CreateTensor<float>(mem, tensor.data(), tensor.size(), shape.data(), shape.size());
+        }
     }
 
     static bool runSingleOutput(Ort::Session &session,
@@ -275,6 +713,8 @@ namespace
         struct LoadInfo
         {
             QByteArray data;
+            QByteArray metadata;
+            QByteArray fingerprint;
             quint32 version{0};
         };
 
@@ -288,72 +728,185 @@ namespace
                 return std::nullopt;
             }
 
-            QFile file(path);
-            if (!file.open(QIODevice::ReadOnly))
-            {
-                if (errorMessage)
-                    *errorMessage = QStringLiteral("无法打开模型文件: %1，错误: %2").arg(path).arg(file.errorString());
-                return std::nullopt;
-            }
-
-            QByteArray fileData = file.readAll();
-            file.close();
-
-            if (fileData.size() < kModelHeaderSize)
+            // 未加装容器头的 .onnx 文件给出更明确的提示
+            QFile probe(path);
+            if (QFileInfo(path).suffix().toLower() == "onnx" && probe.open(QIODevice::ReadOnly))
             {
-                // 增加对未加密文件的检测
-                QFileInfo info(path);
-                if (info.suffix().toLower() == "onnx")
+                quint32 magic = 0;
+                QDataStream(&probe) >> magic;
+                if (magic != ModelContainer::kMagic)
                 {
                     if (errorMessage)
                         *errorMessage = QStringLiteral("检测到未加密的ONNX文件，请先使用encrypt_model工具加密: %1").arg(path);
+                    return std::nullopt;
                 }
-                else
-                {
-                    if (errorMessage)
-                        *errorMessage = QStringLiteral("模型文件过小或损坏: %1，大小: %2字节").arg(path).arg(fileData.size());
-                }
-                return std::nullopt;
             }
+            probe.close();
 
-            QDataStream headerStream(fileData);
-            quint32 magic = 0;
-            quint32 version = 0;
-            headerStream >> magic >> version;
-
-            if (magic != kModelMagic)
-            {
-                if (errorMessage)
-                    *errorMessage = QStringLiteral("模型文件非法或未加密: %1").arg(path);
+            LoadInfo info;
+            ModelContainer::ReadInfo readInfo;
+            QElapsedTimer timer;
+            timer.start();
+            // 校验失败时 errorMessage 已包含首个损坏块的序号与字节范围
+            if (!ModelContainer::read(path, key, info.data, &readInfo, errorMessage))
                 return std::nullopt;
-            }
+            info.version = readInfo.version;
+            info.metadata = readInfo.metadata;
+            info.fingerprint = readInfo.fingerprint;
+
+            if (readInfo.version < ModelContainer::kVersion2)
+                LOG_WARNING(QStringLiteral("模型使用旧版 v1 容器（无完整性校验），建议用 encrypt_model 重新打包: %1").arg(path),
+                            "Inference", 5026);
+            LOG_DEBUG(QStringLiteral("模型解密完成: 版本 0x%1，%2 块，%3 线程，%4 字节，耗时 %5 ms")
+                          .arg(readInfo.version, 8, 16, QLatin1Char('0'))
+                          .arg(readInfo.chunkCount)
+                          .arg(readInfo.threads)
+                          .arg(info.data.size())
+                          .arg(timer.elapsed()),
+                      "Inference");
+            return info;
+        }
+    };
+}
+
+#ifdef HAVE_ORT
+namespace
+{
+    QByteArray modelProtectionKey()
+    {
+        QString keyStr = AppConfig::instance().getModelProtectionKey();
+        if (keyStr.isEmpty())
+        {
+            keyStr = QStringLiteral("MedYOLO11Qt_Model_Protection_Key_2024");
+            LOG_WARNING(QStringLiteral("配置中未找到模型保护密钥，使用默认密钥"), "Inference", 5010);
+        }
+        return ModelContainer::deriveKey(keyStr);
+    }
+
+    // 对本机可用的 CPU 提供程序 × 线程数逐一计时，选出最快组合并写入调优缓存
+    bool tuneProviders(Ort::Env &env, const QByteArray &model, const QByteArray &fingerprint,
+                       int inputWidth, int inputHeight, int fixedThreads, ExecutionProviders::Choice &best,
+                       const std::atomic_bool *cancel)
+    {
+        const std::vector<int> threadCounts = fixedThreads > 0 ? std::vector<int>{fixedThreads}
+                                                               : ExecutionProviders::candidateThreadCounts();
+        std::vector<ExecutionProviders::Choice> candidates;
+        for (const QString &provider : ExecutionProviders::available())
+        {
+            if (provider == QStringLiteral("cuda"))
+                continue;
+            for (int threads : threadCounts)
+                candidates.push_back({provider, threads});
+        }
+
+        LOG_INFO(QStringLiteral("后台调优执行提供程序（%1 个组合）").arg(candidates.size()), "Inference");
+        QElapsedTimer timer;
+        timer.start();
+        const auto results = ExecutionProviders::benchmark(env, model, candidates, inputWidth, inputHeight, 5, 30000, cancel);
+        if (cancel && cancel->load())
+            return false;
 
-            // 添加更多调试信息
-            if (AppConfig::instance().isDebugModeEnabled())
+        const ExecutionProviders::Measurement *fastest = nullptr;
+        double cpuDefaultMs = 0.0;
+        for (const auto &m : results)
+        {
+            if (!m.error.isEmpty())
             {
-                qDebug() << "模型版本:" << version;
-                qDebug() << "加密数据大小:" << fileData.size() - kModelHeaderSize;
+                LOG_DEBUG(QStringLiteral("调优: %1 × %2 线程 跳过: %3").arg(m.choice.provider).arg(m.choice.threads).arg(m.error), "Inference");
+                continue;
             }
+            LOG_DEBUG(QStringLiteral("调优: %1 × %2 线程 %3 ms").arg(m.choice.provider).arg(m.choice.threads).arg(m.medianMs, 0, 'f', 2), "Inference");
+            if (m.choice.provider == QStringLiteral("cpu") && m.choice.threads == threadCounts.front())
+                cpuDefaultMs = m.medianMs;
+            if (!fastest || m.medianMs < fastest->medianMs)
+                fastest = &m;
+        }
+        if (!fastest)
+        {
+            LOG_WARNING(QStringLiteral("执行提供程序调优失败，使用 CPU 默认设置"), "Inference", 5029);
+            return false;
+        }
 
-            QByteArray encryptedPayload = fileData.mid(kModelHeaderSize);
-            LoadInfo info;
-            info.version = version;
-            info.data = xorDecrypt(encryptedPayload, key);
-            return info;
+        ExecutionProviders::saveTuned(fingerprint, *fastest);
+        best = fastest->choice;
+        LOG_INFO(QStringLiteral("调优完成（%1 ms）：%2 × %3 线程，单次 %4 ms（CPU × %5 线程 %6 ms）")
+                     .arg(timer.elapsed())
+                     .arg(best.provider)
+                     .arg(best.threads)
+                     .arg(fastest->medianMs, 0, 'f', 2)
+                     .arg(threadCounts.front())
+                     .arg(cpuDefaultMs, 0, 'f', 2),
+                 "Inference");
+        return true;
+    }
+
+    // 后台调优在独立线程池中串行执行；程序退出时置取消标志，当前组合测完即返回
+    struct TuningJobs
+    {
+        QThreadPool pool;
+        std::atomic_bool cancel{false};
+        QMutex mutex;
+        QSet<QByteArray> running; // 正在调优的模型指纹
+
+        TuningJobs() { pool.setMaxThreadCount(1); }
+        ~TuningJobs()
+        {
+            cancel = true;
+            pool.waitForDone();
         }
     };
+
+    TuningJobs &tuningJobs()
+    {
+        static TuningJobs jobs;
+        return jobs;
+    }
+
+    // 加载不等待调优：本次用默认提供程序，调优结果写入缓存后从下次加载该模型起生效
+    void scheduleProviderTuning(const QByteArray &model, const QByteArray &fingerprint,
+                                int inputWidth, int inputHeight, int fixedThreads)
+    {
+        TuningJobs &jobs = tuningJobs();
+        {
+            QMutexLocker lock(&jobs.mutex);
+            if (jobs.running.contains(fingerprint))
+                return;
+            jobs.running.insert(fingerprint);
+        }
+        jobs.pool.start([&jobs, model, fingerprint, inputWidth, inputHeight, fixedThreads]()
+                        {
+            // 独立环境：调优期间模型可能被卸载或重新加载
+            Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "MedYOLO11Qt-tune");
+            ExecutionProviders::Choice best;
+            tuneProviders(env, model, fingerprint, inputWidth, inputHeight, fixedThreads, best, &jobs.cancel);
+            QMutexLocker lock(&jobs.mutex);
+            jobs.running.remove(fingerprint); });
+    }
 }
 
-#ifdef HAVE_ORT
 struct InferenceEngine::OrtPack
 {
     Ort::Env env{ORT_LOGGING_LEVEL_WARNING, "MedYOLO11Qt"};
     Ort::SessionOptions opts;
+    ExecutionProviders::Choice provider;
+    TensorFormat input;
+    TensorFormat detection;
+    TensorFormat prototype;
+    QByteArray fingerprint; // 模型内容指纹，参与结果缓存键
     std::unique_ptr<Ort::Session> session;
     std::vector<Ort::AllocatedStringPtr> inPtrs;
     std::vector<Ort::AllocatedStringPtr> outPtrs;
     std::vector<const char *> inputNames;
     std::vector<const char *> outputNames;
+
+    // 级联初筛分类模型（可选），与检测会话共用环境与会话选项
+    std::unique_ptr<Ort::Session> triageSession;
+    TensorFormat triageInput;
+    int triageW{0}, triageH{0};
+    QByteArray triageFingerprint;
+    std::vector<Ort::AllocatedStringPtr> triageNamePtrs;
+    std::vector<const char *> triageInputNames;
+    const char *triageOutputName{nullptr};
 };
 #endif
 
@@ -366,15 +919,8 @@ void InferenceEngine::unload()
     m_ort.reset();
 #endif
     m_modelPath.clear();
-    m_isYoloDetect = false;
-    m_hasObj = false;
-    m_numClasses = 0;
-    m_channels = 0;
-    m_detOutputIndex = -1;
-    m_segOutputIndex = -1;
-    m_maskChannels = 0;
-    m_maskWidth = 0;
-    m_maskHeight = 0;
+    m_plan = DecodePlan();
+    m_dynamicInput = false;
 }
 
 bool InferenceEngine::isLoaded() const
@@ -412,14 +958,7 @@ bool InferenceEngine::loadModel(const QString &path)
         unload();
 
         AppConfig &config = AppConfig::instance();
-        QString keyStr = config.getModelProtectionKey();
-        if (keyStr.isEmpty())
-        {
-            keyStr = QStringLiteral("MedYOLO11Qt_Model_Protection_Key_2024");
-            LOG_WARNING(QStringLiteral("配置中未找到模型保护密钥，使用默认密钥"), "Inference", 5010);
-        }
-
-        const QByteArray key = QCryptographicHash::hash(keyStr.toUtf8(), QCryptographicHash::Sha256);
+        const QByteArray key = modelProtectionKey();
 
         QString loadError;
         auto loadInfo = EncryptedModelLoader::load(path, key, &loadError);
@@ -434,17 +973,75 @@ bool InferenceEngine::loadModel(const QString &path)
 
         const QByteArray modelData = loadInfo->data;
 
-        m_ort = std::make_unique<OrtPack>();
-        m_ort->opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        ModelContainer::Metadata meta;
+        const bool hasMetadata = !loadInfo->metadata.isEmpty();
+        if (hasMetadata && !ModelContainer::parseMetadata(loadInfo->metadata, meta, &loadError))
+        {
+            LOG_ERROR(QStringLiteral("模型元数据无效: %1").arg(loadError), "Inference", 5027);
+            return false;
+        }
 
+        m_ort = std::make_unique<OrtPack>();
         const OrtLoggingLevel logLevel = config.isDebugModeEnabled() ? ORT_LOGGING_LEVEL_INFO : ORT_LOGGING_LEVEL_WARNING;
         m_ort->env = Ort::Env(logLevel, "MedYOLO11Qt");
+        m_ort->fingerprint = loadInfo->fingerprint;
+        bool needsTuning = false;
+
+        // 执行提供程序链：UseGPU 且 ONNX Runtime 编入 CUDA 时先试 CUDA；显式配置按顺序尝试；
+        // auto 时用本机调优结果（尚无结果时后台调优，不阻塞本次加载）；最后总以 CPU 兜底
+        const AppConfig::SnapshotPtr snapshot = config.current();
+        const int configuredThreads = snapshot->inferenceThreads;
+        std::vector<ExecutionProviders::Choice> chain;
+        if (snapshot->gpuAcceleration && ExecutionProviders::isAvailable(QStringLiteral("cuda")))
+            chain.push_back({QStringLiteral("cuda"), configuredThreads});
+        const QStringList configuredProviders = ExecutionProviders::parseList(snapshot->executionProviders);
+        if (!configuredProviders.isEmpty())
+        {
+            for (const QString &provider : configuredProviders)
+                chain.push_back({provider, configuredThreads});
+        }
+        else
+        {
+            ExecutionProviders::Choice tuned;
+            if (ExecutionProviders::loadTuned(loadInfo->fingerprint, tuned))
+                chain.push_back(tuned);
+            else
+                needsTuning = snapshot->autoTuneProviders;
+        }
+        chain.push_back({QStringLiteral("cpu"), configuredThreads});
 
-        m_ort->session = std::make_unique<Ort::Session>(
-            m_ort->env,
-            modelData.constData(),
-            static_cast<size_t>(modelData.size()),
-            m_ort->opts);
+        for (const ExecutionProviders::Choice &choice : chain)
+        {
+            Ort::SessionOptions opts;
+            opts.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+            QString providerError;
+            if (!ExecutionProviders::append(opts, choice, snapshot->gpuDeviceId, &providerError))
+            {
+                LOG_WARNING(QStringLiteral("执行提供程序 %1 不可用，尝试下一个: %2").arg(choice.provider, providerError), "Inference", 5029);
+                continue;
+            }
+            try
+            {
+                m_ort->session = std::make_unique<Ort::Session>(
+                    m_ort->env,
+                    modelData.constData(),
+                    static_cast<size_t>(modelData.size()),
+                    opts);
+            }
+            catch (const Ort::Exception &e)
+            {
+                // CPU 兜底也失败时按模型加载异常处理
+                if (&choice == &chain.back())
+                    throw;
+                LOG_WARNING(QStringLiteral("执行提供程序 %1 创建会话失败，尝试下一个: %2")
+                                .arg(choice.provider, QString::fromUtf8(e.what())),
+                            "Inference", 5029);
+                continue;
+            }
+            m_ort->opts = std::move(opts);
+            m_ort->provider = choice;
+            break;
+        }
 
         Ort::AllocatorWithDefaultOptions alloc;
         const size_t ni = m_ort->session->GetInputCount();
@@ -468,105 +1065,228 @@ bool InferenceEngine::loadModel(const QString &path)
             m_ort->outputNames.push_back(m_ort->outPtrs.back().get());
         }
 
-        try
+        // 输入尺寸：会话中的静态形状优先，动态维度时取元数据，仍未知则用 640
+        int sessionInH = 0, sessionInW = 0;
+        ONNXTensorElementDataType inputType = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
         {
             auto ti = m_ort->session->GetInputTypeInfo(0);
             if (ti.GetONNXType() == ONNX_TYPE_TENSOR)
             {
-                auto inf = ti.GetTensorTypeAndShapeInfo();
-                auto sh = inf.GetShape();
-                if (sh.size() >= 4 && std::abs(static_cast<int>(sh[2])) > 0 && std::abs(static_cast<int>(sh[3])) > 0)
+                auto inputInfo = ti.GetTensorTypeAndShapeInfo();
+                inputType = inputInfo.GetElementType();
+                auto sh = inputInfo.GetShape();
+                if (sh.size() >= 4 && sh[2] > 0 && sh[3] > 0)
                 {
-                    m_inH = std::abs(static_cast<int>(sh[2]));
-                    m_inW = std::abs(static_cast<int>(sh[3]));
+                    sessionInH = static_cast<int>(sh[2]);
+                    sessionInW = static_cast<int>(sh[3]);
                 }
             }
         }
-        catch (...)
+        m_inW = m_inH = 640;
+        m_dynamicInput = (sessionInW <= 0);
+        if (sessionInW > 0)
         {
-            m_inH = m_inW = 640;
+            m_inW = sessionInW;
+            m_inH = sessionInH;
+            if (hasMetadata && meta.inputWidth > 0 && (meta.inputWidth != sessionInW || meta.inputHeight != sessionInH))
+                LOG_WARNING(QStringLiteral("模型元数据输入尺寸 %1x%2 与模型 %3x%4 不一致，以模型为准")
+                                .arg(meta.inputWidth)
+                                .arg(meta.inputHeight)
+                                .arg(sessionInW)
+                                .arg(sessionInH),
+                            "Inference", 5028);
+        }
+        else if (hasMetadata && meta.inputWidth > 0 && meta.inputHeight > 0)
+        {
+            m_inW = meta.inputWidth;
+            m_inH = meta.inputHeight;
         }
 
-        m_isYoloDetect = false;
-        m_hasObj = false;
-        m_numClasses = 0;
-        m_channels = 0;
-        m_detOutputIndex = -1;
-        m_segOutputIndex = -1;
-        m_maskChannels = 0;
-        m_maskWidth = 0;
-        m_maskHeight = 0;
-
-        int expectedMaskChannels = 0;
+        // 静态输出形状（动态维度为 -1）与元素类型，仅在加载时读取一次；float16 / 8 位量化输出同样接受
+        std::vector<std::vector<int64_t>> outputShapes(no);
+        std::vector<ONNXTensorElementDataType> outputTypes(no, ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED);
         for (size_t i = 0; i < no; ++i)
         {
             auto to = m_ort->session->GetOutputTypeInfo(i);
             if (to.GetONNXType() != ONNX_TYPE_TENSOR)
                 continue;
             auto info = to.GetTensorTypeAndShapeInfo();
-            if (info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
+            if (!isSupportedElementType(info.GetElementType()))
                 continue;
-            auto sh = info.GetShape();
-            if (sh.size() == 3)
+            outputTypes[i] = info.GetElementType();
+            outputShapes[i] = info.GetShape();
+        }
+
+        DecodePlan plan;
+        if (hasMetadata)
+        {
+            auto outputIndex = [&](const QString &name) -> int
             {
-                const int d1 = std::abs(static_cast<int>(sh[1]));
-                const int d2 = std::abs(static_cast<int>(sh[2]));
-                const int C = std::min(d1, d2);
-                const int N = std::max(d1, d2);
-                if (C >= 6 && N >= 10)
+                for (size_t i = 0; i < no; ++i)
+                    if (QString::fromUtf8(m_ort->outputNames[i]) == name)
+                        return static_cast<int>(i);
+                return -1;
+            };
+            plan.fromMetadata = true;
+            plan.detOutput = meta.detectionOutput.isEmpty() ? 0 : outputIndex(meta.detectionOutput);
+            plan.protoOutput = meta.prototypeOutput.isEmpty() ? -1 : outputIndex(meta.prototypeOutput);
+            plan.attrCount = meta.attributeCount();
+            plan.layout = meta.layout == ModelContainer::Metadata::Layout::AttributesLast    ? 1
+                          : meta.layout == ModelContainer::Metadata::Layout::AttributesFirst ? 2
+                                                                                             : 0;
+            plan.numClasses = meta.numClasses;
+            plan.hasObjectness = meta.objectness;
+            plan.maskChannels = meta.maskChannels;
+            plan.boxesNormalized = meta.boxesNormalized;
+            plan.scoresSigmoided = meta.scoresSigmoided;
+            plan.confThreshold = meta.confidenceThreshold;
+            plan.iouThreshold = meta.iouThreshold;
+
+            // 元数据与模型静态形状互相印证，不一致时拒绝加载而不是输出错误结果
+            QString mismatch;
+            if (plan.detOutput < 0 || plan.detOutput >= static_cast<int>(no) ||
+                outputShapes[static_cast<size_t>(plan.detOutput)].size() != 3)
+                mismatch = QStringLiteral("检测输出 %1 不存在或不是三维浮点张量").arg(meta.detectionOutput);
+            else if (!meta.prototypeOutput.isEmpty() &&
+                     (plan.protoOutput < 0 || outputShapes[static_cast<size_t>(plan.protoOutput)].size() != 4))
+                mismatch = QStringLiteral("原型输出 %1 不存在或不是四维浮点张量").arg(meta.prototypeOutput);
+            else
+            {
+                const auto &sh = outputShapes[static_cast<size_t>(plan.detOutput)];
+                const int64_t attrDim = plan.layout == 1 ? sh[2] : plan.layout == 2 ? sh[1] : -1;
+                if (attrDim > 0 && attrDim != plan.attrCount)
+                    mismatch = QStringLiteral("检测输出属性维为 %1，元数据推算为 %2").arg(attrDim).arg(plan.attrCount);
+                else if (plan.layout == 0 && sh[1] > 0 && sh[2] > 0 && sh[1] != plan.attrCount && sh[2] != plan.attrCount)
+                    mismatch = QStringLiteral("检测输出形状 [1,%1,%2] 中没有 %3 维属性").arg(sh[1]).arg(sh[2]).arg(plan.attrCount);
+                else if (plan.protoOutput >= 0)
                 {
-                    m_isYoloDetect = true;
-                    const int nc_v8 = C - 4;
-                    const int nc_v5 = C - 5;
-                    if (nc_v8 >= 1)
-                    {
-                        m_hasObj = false;
-                        m_numClasses = nc_v8;
-                    }
-                    else
-                    {
-                        m_hasObj = true;
-                        m_numClasses = std::max(1, nc_v5);
-                    }
-                    m_channels = C;
-                    m_detOutputIndex = static_cast<int>(i);
-                    const int clsOffset = m_hasObj ? 5 : 4;
-                    int maskCandidate = m_channels - (clsOffset + m_numClasses);
-                    if (maskCandidate > 0)
-                        expectedMaskChannels = maskCandidate;
+                    const int64_t protoC = outputShapes[static_cast<size_t>(plan.protoOutput)][1];
+                    if (protoC > 0 && protoC != plan.maskChannels)
+                        mismatch = QStringLiteral("原型输出通道为 %1，元数据为 %2").arg(protoC).arg(plan.maskChannels);
+                }
+            }
+            if (!mismatch.isEmpty())
+            {
+                LOG_ERROR(QStringLiteral("模型元数据与模型输出不符: %1").arg(mismatch), "Inference", 5027);
+                m_ort.reset();
+                return false;
+            }
+            if (plan.layout == 0)
+            {
+                const auto &sh = outputShapes[static_cast<size_t>(plan.detOutput)];
+                if (sh[1] > 0 && sh[2] > 0 && sh[1] != sh[2])
+                    plan.layout = (sh[2] == plan.attrCount) ? 1 : 2;
+            }
+        }
+        else
+        {
+            // 无元数据的旧模型：按输出形状推断。先找原型输出，掩码通道不计入类别数
+            for (size_t i = 0; i < no; ++i)
+            {
+                const auto &sh = outputShapes[i];
+                if (sh.size() == 4 && sh[0] == 1 && sh[1] > 0)
+                {
+                    plan.protoOutput = static_cast<int>(i);
+                    plan.maskChannels = static_cast<int>(sh[1]);
                     break;
                 }
             }
+            for (size_t i = 0; i < no; ++i)
+            {
+                const auto &sh = outputShapes[i];
+                if (sh.size() != 3)
+                    continue;
+                const int d1 = std::abs(static_cast<int>(sh[1]));
+                const int d2 = std::abs(static_cast<int>(sh[2]));
+                const int C = std::min(d1, d2);
+                const int N = std::max(d1, d2);
+                if (C < 6 || N < 10)
+                    continue;
+                plan.detOutput = static_cast<int>(i);
+                plan.attrCount = C;
+                plan.layout = (sh[1] > 0 && sh[2] > 0) ? (d2 == C ? 1 : 2) : 0;
+                plan.numClasses = C - 4 - plan.maskChannels;
+                if (plan.numClasses < 1)
+                {
+                    // 原型通道与检测输出对不上，按纯检测模型处理
+                    plan.protoOutput = -1;
+                    plan.maskChannels = 0;
+                    plan.numClasses = C - 4;
+                }
+                break;
+            }
+            if (plan.detOutput < 0)
+                plan.protoOutput = -1;
+            LOG_INFO(QStringLiteral("模型未携带元数据，按输出形状推断解码方式（可用 encrypt_model --metadata 重新打包）"), "Inference");
         }
+        m_plan = plan;
 
-        for (size_t i = 0; i < no; ++i)
+        // 输入/输出元素格式：8 位量化张量需要元数据中的 scale / zero_point，
+        // 唯一例外是 uint8 输入，按常见约定视为 0..255 像素值
+        QString formatError;
+        const auto resolveFormat = [&](ONNXTensorElementDataType type, const ModelContainer::Metadata::Quantization &q,
+                                       bool isInput, const QString &what, TensorFormat &out)
         {
-            auto to = m_ort->session->GetOutputTypeInfo(i);
-            if (to.GetONNXType() != ONNX_TYPE_TENSOR)
-                continue;
-            auto info = to.GetTensorTypeAndShapeInfo();
-            if (info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
-                continue;
-            auto sh = info.GetShape();
-            if (sh.size() != 4)
-                continue;
-            const int protoBatch = std::abs(static_cast<int>(sh[0]));
-            const int protoC = std::abs(static_cast<int>(sh[1]));
-            const int protoH = std::abs(static_cast<int>(sh[2]));
-            const int protoW = std::abs(static_cast<int>(sh[3]));
-            if (protoBatch != 1 || protoC <= 0 || protoH <= 0 || protoW <= 0)
-                continue;
-            if (expectedMaskChannels > 0 && protoC != expectedMaskChannels)
-                continue;
-            m_segOutputIndex = static_cast<int>(i);
-            m_maskChannels = protoC;
-            m_maskHeight = protoH;
-            m_maskWidth = protoW;
-            break;
+            out = TensorFormat();
+            out.type = type;
+            if (!isQuantizedElementType(type))
+                return;
+            if (q.isValid())
+            {
+                out.scale = q.scale;
+                out.zeroPoint = q.zeroPoint;
+            }
+            else if (isInput && type == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+            {
+                out.scale = 1.f / 255.f;
+            }
+            else if (formatError.isEmpty())
+            {
+                formatError = QStringLiteral("%1 为 8 位量化张量，模型元数据需提供 quantization.scale / zero_point").arg(what);
+            }
+        };
+        if (!isSupportedElementType(inputType))
+            formatError = QStringLiteral("不支持的输入元素类型 %1（支持 float / float16 / uint8 / int8）").arg(static_cast<int>(inputType));
+        resolveFormat(inputType, meta.inputQuantization, true, QStringLiteral("输入"), m_ort->input);
+        if (plan.detOutput >= 0)
+            resolveFormat(outputTypes[static_cast<size_t>(plan.detOutput)], meta.detectionQuantization, false,
+                          QStringLiteral("检测输出"), m_ort->detection);
+        if (plan.protoOutput >= 0)
+            resolveFormat(outputTypes[static_cast<size_t>(plan.protoOutput)], meta.prototypeQuantization, false,
+                          QStringLiteral("原型输出"), m_ort->prototype);
+        if (!formatError.isEmpty())
+        {
+            LOG_ERROR(QStringLiteral("模型张量格式不受支持: %1").arg(formatError), "Inference", 5030);
+            m_ort.reset();
+            m_plan = DecodePlan();
+            return false;
         }
 
+        // 类别名与颜色随模型发布；无元数据时恢复默认。辅助引擎不发布
+        const bool segmentationFamily = hasMetadata ? meta.segmentation : (plan.protoOutput >= 0);
+        if (m_publishLabels)
+            publishLabels(segmentationFamily, meta.classNames, meta.classColors);
+
         m_modelPath = path;
-        LOG_INFO(QStringLiteral("成功加载模型: %1, 输入尺寸: %2x%3").arg(path).arg(m_inW).arg(m_inH), "Inference");
+        LOG_INFO(QStringLiteral("成功加载模型: %1, 输入尺寸: %2x%3%9, 类别数: %4, 掩码通道: %5 (%6), 执行提供程序: %7 × %8 线程")
+                     .arg(path)
+                     .arg(m_inW)
+                     .arg(m_inH)
+                     .arg(m_plan.numClasses)
+                     .arg(m_plan.maskChannels)
+                     .arg(m_plan.fromMetadata ? QStringLiteral("模型元数据") : QStringLiteral("形状推断"))
+                     .arg(m_ort->provider.provider)
+                     .arg(m_ort->provider.threads > 0 ? QString::number(m_ort->provider.threads) : QStringLiteral("默认"))
+                     .arg(m_dynamicInput ? QStringLiteral("（动态输入）") : QString()),
+                 "Inference");
+        if (needsTuning)
+        {
+            LOG_INFO(QStringLiteral("该模型尚无本机调优结果，已以默认提供程序加载，调优在后台进行，下次加载时生效"), "Inference");
+            scheduleProviderTuning(modelData, m_ort->fingerprint,
+                                   meta.inputWidth > 0 ? meta.inputWidth : 640,
+                                   meta.inputHeight > 0 ? meta.inputHeight : 640,
+                                   configuredThreads);
+        }
         return true;
     }
     catch (const Ort::Exception &e)
@@ -590,83 +1310,362 @@ bool InferenceEngine::loadModel(const QString &path)
 #endif
 }
 
-bool InferenceEngine::isSegmentationModel() const
+bool InferenceEngine::loadTriageModel(const QString &path)
 {
 #ifndef HAVE_ORT
+    Q_UNUSED(path);
     return false;
 #else
+    if (!m_ort || !m_ort->session)
+    {
+        LOG_WARNING(QStringLiteral("加载初筛模型前须先加载检测模型"), "Inference", 5035);
+        return false;
+    }
+    m_ort->triageSession.reset();
+    m_ort->triageFingerprint.clear();
+    m_ort->triageNamePtrs.clear();
+    m_ort->triageInputNames.clear();
+    m_ort->triageOutputName = nullptr;
+    m_ort->triageW = m_ort->triageH = 0;
+
+    if (path.isEmpty())
+    {
+        if (!m_dynamicInput)
+        {
+            LOG_WARNING(QStringLiteral("检测模型为固定输入尺寸，无法做低分辨率初筛；级联初筛需配置 Models/FAITriage"), "Inference", 5035);
+            return false;
+        }
+        LOG_INFO(QStringLiteral("级联初筛使用检测模型低分辨率推理"), "Inference");
+        return true;
+    }
+
     try
     {
-        if (!m_ort || !m_ort->session)
+        QString loadError;
+        auto loadInfo = EncryptedModelLoader::load(path, modelProtectionKey(), &loadError);
+        if (!loadInfo.has_value())
+        {
+            LOG_WARNING(QStringLiteral("初筛模型加载失败: %1").arg(loadError.isEmpty() ? path : loadError), "Inference", 5035);
             return false;
+        }
 
-        // 检查输出形状来判断是否为分割模型
-        // 分割模型通常有 [1, num_classes, H, W] 形状的输出
-        const size_t no = m_ort->session->GetOutputCount();
-        for (size_t i = 0; i < no; ++i)
+        auto session = std::make_unique<Ort::Session>(m_ort->env, loadInfo->data.constData(),
+                                                      static_cast<size_t>(loadInfo->data.size()), m_ort->opts);
+        QString shapeError;
+        int inW = 0, inH = 0;
+        ONNXTensorElementDataType inputType = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+        if (session->GetInputCount() != 1 || session->GetOutputCount() < 1 ||
+            session->GetInputTypeInfo(0).GetONNXType() != ONNX_TYPE_TENSOR)
         {
-            auto to = m_ort->session->GetOutputTypeInfo(i);
-            if (to.GetONNXType() != ONNX_TYPE_TENSOR)
-                continue;
-            auto inf = to.GetTensorTypeAndShapeInfo();
-            if (inf.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
-                continue;
-            auto sh = inf.GetShape();
-            if (sh.size() == 4 && sh[0] == 1 && sh[1] > 1) // [1, C, H, W]
+            shapeError = QStringLiteral("须为单输入张量模型");
+        }
+        else
+        {
+            auto ti = session->GetInputTypeInfo(0);
+            auto info = ti.GetTensorTypeAndShapeInfo();
+            inputType = info.GetElementType();
+            const auto sh = info.GetShape();
+            if (sh.size() == 4 && sh[2] > 0 && sh[3] > 0)
             {
-                return true;
+                inH = static_cast<int>(sh[2]);
+                inW = static_cast<int>(sh[3]);
             }
+            else if (sh.size() == 4)
+            {
+                // 动态空间维度时按 TriageInputSize 取方形输入
+                inW = inH = std::max(kInputStride, AppConfig::instance().current()->triageInputSize / kInputStride * kInputStride);
+            }
+            // 8 位输入只接受 uint8 像素约定；int8 需要量化参数，初筛模型不携带元数据
+            if (sh.size() != 4)
+                shapeError = QStringLiteral("输入须为 [1,3,H,W]");
+            else if (inputType != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT && inputType != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 &&
+                     inputType != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+                shapeError = QStringLiteral("不支持的输入元素类型 %1").arg(static_cast<int>(inputType));
         }
-        return false;
-    }
-    catch (const std::exception &e)
-    {
-        LOG_ERROR(QString("检查模型类型异常: %1").arg(e.what()), "Inference", 5015);
-        return false;
+        const int normalClass = normalClassIndex(m_plan.fromMetadata ? m_plan.numClasses : 4);
+        if (shapeError.isEmpty())
+        {
+            auto to = session->GetOutputTypeInfo(0);
+            const auto info = to.GetTensorTypeAndShapeInfo();
+            const auto sh = info.GetShape();
+            const ONNXTensorElementDataType outputType = info.GetElementType();
+            if (outputType != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT && outputType != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16)
+                shapeError = QStringLiteral("输出须为 float / float16 类别分数");
+            else if (sh.empty() || sh.size() > 2 || sh.back() <= normalClass)
+                shapeError = QStringLiteral("输出须为 [1, C] 且 C > %1（NORMAL 类别号）").arg(normalClass);
+        }
+        if (!shapeError.isEmpty())
+        {
+            LOG_WARNING(QStringLiteral("初筛模型不受支持: %1 (%2)").arg(shapeError, path), "Inference", 5035);
+            return false;
+        }
+
+        Ort::AllocatorWithDefaultOptions alloc;
+        m_ort->triageNamePtrs.emplace_back(session->GetInputNameAllocated(0, alloc));
+        m_ort->triageNamePtrs.emplace_back(session->GetOutputNameAllocated(0, alloc));
+        m_ort->triageInputNames.push_back(m_ort->triageNamePtrs[0].get());
+        m_ort->triageOutputName = m_ort->triageNamePtrs[1].get();
+        m_ort->triageInput = TensorFormat();
+        m_ort->triageInput.type = inputType;
+        if (inputType == ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8)
+            m_ort->triageInput.scale = 1.f / 255.f;
+        m_ort->triageW = inW;
+        m_ort->triageH = inH;
+        m_ort->triageFingerprint = loadInfo->fingerprint;
+        m_ort->triageSession = std::move(session);
+        LOG_INFO(QStringLiteral("成功加载初筛模型: %1, 输入尺寸: %2x%3").arg(path).arg(inW).arg(inH), "Inference");
+        return true;
     }
-    catch (...)
+    catch (const Ort::Exception &e)
     {
-        LOG_ERROR("检查模型类型发生未知异常", "Inference", 5016);
+        LOG_WARNING(QStringLiteral("初筛模型加载异常: %1").arg(QString::fromUtf8(e.what())), "Inference", 5035);
+        m_ort->triageSession.reset();
         return false;
     }
 #endif
 }
 
-InferenceEngine::Result InferenceEngine::run(const QImage &input, Task taskHint) const
+double InferenceEngine::CascadeStats::hitRate() const
+{
+    return screened > 0 ? static_cast<double>(earlyExits) / screened : 0.0;
+}
+
+double InferenceEngine::CascadeStats::savedMs() const
+{
+    if (fullRuns <= 0)
+        return 0.0;
+    return earlyExits * (fullMs / fullRuns) - triageMs;
+}
+
+QString InferenceEngine::CascadeStats::toText() const
+{
+    return QStringLiteral("triage %1 image(s), NORMAL early exit %2 (%3%), full detection %7 run(s), triage %4 ms/image, full detection %5 ms/image, saved ~%6 s")
+        .arg(screened)
+        .arg(earlyExits)
+        .arg(hitRate() * 100.0, 0, 'f', 1)
+        .arg(screened > 0 ? triageMs / screened : 0.0, 0, 'f', 1)
+        .arg(fullRuns > 0 ? fullMs / fullRuns : 0.0, 0, 'f', 1)
+        .arg(savedMs() / 1000.0, 0, 'f', 1)
+        .arg(fullRuns);
+}
+
+InferenceEngine::CascadeStats InferenceEngine::cascadeStats() const
+{
+    CascadeStats stats;
+    stats.screened = m_cascade.screened.load(std::memory_order_relaxed);
+    stats.earlyExits = m_cascade.earlyExits.load(std::memory_order_relaxed);
+    stats.fullRuns = m_cascade.fullRuns.load(std::memory_order_relaxed);
+    stats.triageMs = m_cascade.triageNs.load(std::memory_order_relaxed) / 1e6;
+    stats.fullMs = m_cascade.fullNs.load(std::memory_order_relaxed) / 1e6;
+    return stats;
+}
+
+void InferenceEngine::resetCascadeStats()
+{
+    m_cascade.screened.store(0, std::memory_order_relaxed);
+    m_cascade.earlyExits.store(0, std::memory_order_relaxed);
+    m_cascade.fullRuns.store(0, std::memory_order_relaxed);
+    m_cascade.triageNs.store(0, std::memory_order_relaxed);
+    m_cascade.fullNs.store(0, std::memory_order_relaxed);
+}
+
+bool InferenceEngine::isSegmentationModel() const
+{
+    // 解码方案在加载时已确定，这里不再查询会话
+    return hasSegmentationSupport();
+}
+
+InferenceEngine::Result InferenceEngine::run(const QImage &input, Task taskHint, bool renderOutput) const
 {
     const bool segmentationRequested = (taskHint == Task::HipMRI_Seg);
 #ifndef HAVE_ORT
+    Q_UNUSED(segmentationRequested);
     Result R;
-    R.outputImage = input;
+    if (renderOutput)
+        R.outputImage = input;
     R.summary = "Built without ONNXRuntime";
     return R;
 #else
-    return runYolo(input, segmentationRequested && hasSegmentationSupport());
+    return runYolo(input, segmentationRequested && hasSegmentationSupport(), renderOutput);
+#endif
+}
+
+InferenceEngine::Result InferenceEngine::run(const PixelView &pixels, Task taskHint, bool renderOutput) const
+{
+    const bool segmentationMode = (taskHint == Task::HipMRI_Seg) && hasSegmentationSupport();
+    Result R;
+    if (!pixels.data || pixels.width <= 0 || pixels.height <= 0 || pixels.bitsAllocated > 16)
+    {
+        R.summary = "Invalid pixel view";
+        LOG_WARNING("推理输入像素视图无效", "Inference", 5025);
+        return R;
+    }
+#ifndef HAVE_ORT
+    R.summary = "Built without ONNXRuntime";
+#else
+    if (!segmentationMode)
+    {
+        const QSize triage = triageInputSize(pixels.width, pixels.height);
+        if (triage.isValid())
+        {
+            DetectionPreprocessResult prep = preprocessPixelView(pixels, triage.width(), triage.height());
+            if (runTriage(prep.tensor, prep.width, prep.height, prep.scale, prep.padW, prep.padH,
+                          pixels.width, pixels.height, R))
+            {
+                if (renderOutput)
+                    R.outputImage = renderResult(pixelViewToImage(pixels), R, segmentationMode);
+                return R;
+            }
+        }
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!segmentationMode && shouldTile(pixels.width, pixels.height))
+    {
+        // 切片需要按区域取像素，先做一次取窗转换
+        const QImage image = pixelViewToImage(pixels);
+        R = runTiled(image);
+        m_cascade.fullRuns.fetch_add(1, std::memory_order_relaxed);
+        m_cascade.fullNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+        if (renderOutput)
+            R.outputImage = renderResult(image, R, segmentationMode);
+        return R;
+    }
+    const QSize net = networkInputSize(pixels.width, pixels.height);
+    DetectionPreprocessResult prep = preprocessPixelView(pixels, net.width(), net.height());
+    R = runTensor(prep.tensor, prep.width, prep.height, prep.scale, prep.padW, prep.padH,
+                  pixels.width, pixels.height, segmentationMode);
+    if (!segmentationMode)
+    {
+        m_cascade.fullRuns.fetch_add(1, std::memory_order_relaxed);
+        m_cascade.fullNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+    }
 #endif
+    if (renderOutput)
+        R.outputImage = renderResult(pixelViewToImage(pixels), R, segmentationMode);
+    return R;
+}
+
+QImage InferenceEngine::windowedImage(const PixelView &pixels)
+{
+    if (!pixels.data || pixels.width <= 0 || pixels.height <= 0)
+        return {};
+    return pixelViewToImage(pixels);
+}
+
+QImage InferenceEngine::renderResult(const QImage &input, const Result &result, bool segmentationMode)
+{
+    QImage vis = input.convertToFormat(QImage::Format_ARGB32);
+    if (!result.segmentationMask.isNull())
+    {
+        QPainter painter(&vis);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+        painter.drawImage(QPoint(), result.segmentationMask);
+    }
+
+    for (const auto &det : result.dets)
+    {
+        QRectF rect(det.x1, det.y1, det.x2 - det.x1, det.y2 - det.y1);
+        QString label = segmentationMode ? segmentationClassName(det.cls) : className(det.cls);
+        QString text = segmentationMode
+                           ? label
+                           : QString("%1  %2%").arg(label).arg(int(std::round(det.score * 100)));
+        QColor color = segmentationMode ? segmentationClassColor(det.cls) : classColor(det.cls);
+        drawBox(vis, rect, text, color);
+    }
+    return vis;
+}
+
+QVector<QRgb> InferenceEngine::segmentationColorTable(int alpha, const QVector<qreal> &classOpacity)
+{
+    QVector<QRgb> table(256, qRgba(0, 0, 0, 0));
+    for (int cls = 0; cls < 255; ++cls)
+    {
+        const qreal opacity = (cls < classOpacity.size()) ? std::clamp<qreal>(classOpacity[cls], 0.0, 1.0) : 1.0;
+        const QColor c = segmentationClassColor(cls);
+        table[cls + 1] = qRgba(c.red(), c.green(), c.blue(), static_cast<int>(std::lround(alpha * opacity)));
+    }
+    return table;
 }
 
 QString InferenceEngine::className(int cls)
 {
+    if (const ClassLabels *labels = publishedLabels(false); labels && cls >= 0 && cls < labels->names.size())
+        return labels->names[cls];
     static const QStringList names = {"CAM", "PINCER", "MIXED", "NORMAL"};
     return (cls >= 0 && cls < names.size()) ? names[cls] : "UNKNOWN";
 }
 
 QColor InferenceEngine::classColor(int cls)
 {
+    if (const ClassLabels *labels = publishedLabels(false); labels && cls >= 0 && cls < labels->colors.size() && labels->colors[cls].isValid())
+        return labels->colors[cls];
     static const QColor colors[] = {QColor(255, 0, 0), QColor(0, 255, 0), QColor(0, 0, 255), QColor(128, 128, 128)};
     return (cls >= 0 && cls < 4) ? colors[cls] : QColor(128, 128, 128);
 }
 
 QString InferenceEngine::segmentationClassName(int cls)
 {
-    const QStringList names = AppConfig::instance().getMriClassNames();
+    // 模型元数据中的类别名优先；否则取配置快照中预解析的类别名，每个框只需一次原子加载
+    if (const ClassLabels *labels = publishedLabels(true); labels && cls >= 0 && cls < labels->names.size())
+        return labels->names[cls];
+    const QStringList names = AppConfig::instance().current()->mriClassNames;
     if (cls >= 0 && cls < names.size())
         return names[cls];
     return QStringLiteral("Muscle %1").arg(cls + 1);
 }
 
+QString InferenceEngine::inputPrecision() const
+{
+#ifdef HAVE_ORT
+    if (!m_ort || !m_ort->session)
+        return QString();
+    switch (m_ort->input.type)
+    {
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+        return QStringLiteral("float16");
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+        return QStringLiteral("uint8");
+    case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+        return QStringLiteral("int8");
+    default:
+        return QStringLiteral("float32");
+    }
+#else
+    return QString();
+#endif
+}
+
+QString InferenceEngine::resolveModelVariant(const QString &basePath)
+{
+    const QString precision = AppConfig::instance().current()->modelPrecision;
+    if (basePath.isEmpty() || precision.isEmpty() || precision == QStringLiteral("fp32"))
+        return basePath;
+
+    const QFileInfo base(basePath);
+    const QString suffix = base.suffix();
+    const QString name = suffix.isEmpty() ? base.fileName() : base.completeBaseName();
+    const QString variantName = suffix.isEmpty() ? QStringLiteral("%1.%2").arg(name, precision)
+                                                 : QStringLiteral("%1.%2.%3").arg(name, precision, suffix);
+    const QString variant = base.dir().filePath(variantName);
+    if (QFileInfo::exists(variant))
+        return variant;
+
+    LOG_WARNING(QStringLiteral("未找到 %1 精度模型 %2，使用原模型").arg(precision, variant), "Inference", 5031);
+    return basePath;
+}
+
+int InferenceEngine::segmentationClassCount()
+{
+    if (const ClassLabels *labels = publishedLabels(true))
+        return labels->names.size();
+    return AppConfig::instance().current()->mriClassNames.size();
+}
+
 QColor InferenceEngine::segmentationClassColor(int cls)
 {
+    if (const ClassLabels *labels = publishedLabels(true); labels && cls >= 0 && cls < labels->colors.size() && labels->colors[cls].isValid())
+        return labels->colors[cls];
     static const QVector<QColor> palette = {
         QColor(252, 90, 141),
         QColor(88, 205, 237),
@@ -681,125 +1680,431 @@ QColor InferenceEngine::segmentationClassColor(int cls)
     const int hue = (cls * 57) % 360;
     return QColor::fromHsv(hue, 180, 240);
 }
+QSize InferenceEngine::networkInputSize(int srcW, int srcH) const
+{
+    if (!m_dynamicInput || srcW <= 0 || srcH <= 0 || !AppConfig::instance().current()->minimalPadding)
+        return QSize(m_inW, m_inH);
+    return minimalPadSize(srcW, srcH, m_inW, m_inH, kInputStride);
+}
+
+QByteArray InferenceEngine::resultKey(const QByteArray &contentHash, Task taskHint) const
+{
+    if (contentHash.isEmpty())
+        return QByteArray();
+    return combineResultKey(resultKeyContext(taskHint), contentHash);
+}
+
+QByteArray InferenceEngine::combineResultKey(const QByteArray &context, const QByteArray &contentHash)
+{
+    if (context.isEmpty() || contentHash.isEmpty())
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(context);
+    hash.addData(contentHash);
+    return hash.result();
+}
+
+QByteArray InferenceEngine::resultKeyContext(Task taskHint) const
+{
 #ifdef HAVE_ORT
-InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segmentationMode) const
+    if (!m_ort || !m_ort->session || m_ort->fingerprint.isEmpty())
+        return QByteArray();
+    // 解码、预处理或合并逻辑改变结果时递增，使旧缓存整体失效
+    constexpr quint32 kResultRevision = 1;
+
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    const bool modelThresholds = config->useModelThresholds;
+    const float conf = (modelThresholds && m_plan.confThreshold >= 0.f) ? m_plan.confThreshold
+                                                                       : m_confThr.load(std::memory_order_relaxed);
+    const float iou = (modelThresholds && m_plan.iouThreshold >= 0.f) ? m_plan.iouThreshold
+                                                                     : m_iouThr.load(std::memory_order_relaxed);
+
+    QByteArray params;
+    QDataStream ds(&params, QIODevice::WriteOnly);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    ds << kResultRevision << QString::fromStdString(Ort::GetVersionString()) << m_ort->fingerprint
+       << static_cast<qint32>(taskHint) << hasSegmentationSupport() << conf << iou
+       << (m_dynamicInput && config->minimalPadding)
+       << config->tiledInference << static_cast<qint32>(config->tileSize) << config->tileOverlap
+       << static_cast<qint32>(config->tileMinImageSize);
+    // 初筛提前结束的结果与完整检测不同，级联设置与初筛模型同样参与键
+    ds << config->triageCascade;
+    if (config->triageCascade)
+        ds << config->triageConfidence << static_cast<qint32>(config->triageInputSize) << m_ort->triageFingerprint;
+    return params;
+#else
+    Q_UNUSED(taskHint);
+    return QByteArray();
+#endif
+}
+
+bool InferenceEngine::shouldTile(int srcW, int srcH) const
 {
-    Result R;
-    QImage vis = input.convertToFormat(QImage::Format_ARGB32);
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    if (!config->tiledInference)
+        return false;
+    const int longSide = std::max(srcW, srcH);
+    const int tile = config->tileSize > 0 ? config->tileSize : std::max(m_inW, m_inH);
+    return longSide >= config->tileMinImageSize && longSide > tile;
+}
 
-    try
+QSize InferenceEngine::triageInputSize(int srcW, int srcH) const
+{
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    if (!config->triageCascade || !isLoaded())
+        return QSize();
+#ifdef HAVE_ORT
+    if (m_ort && m_ort->triageSession)
+        return QSize(m_ort->triageW, m_ort->triageH);
+#endif
+    // 低分辨率检测：只有动态空间维度的模型能直接接受更小的输入，且须明显小于完整输入才有意义
+    const int side = config->triageInputSize / kInputStride * kInputStride;
+    if (!m_dynamicInput || side < kInputStride || side >= std::max(m_inW, m_inH))
+        return QSize();
+    if (!config->minimalPadding)
+        return QSize(side, side);
+    return minimalPadSize(srcW, srcH, side, side, kInputStride);
+}
+
+#ifdef HAVE_ORT
+InferenceEngine::Result InferenceEngine::runTiled(const QImage &input) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    const QImage rgb = input.convertToFormat(QImage::Format_RGB888);
+    const int tile = config->tileSize > 0 ? config->tileSize : std::max(m_inW, m_inH);
+    std::vector<QRect> tiles = tileGrid(rgb.width(), rgb.height(), tile, config->tileOverlap);
+    // 整图一遍保留跨越多个切片的大目标，切片补充小结构
+    tiles.push_back(rgb.rect());
+
+    // 各切片相互独立：线程从原子计数器领取切片号（会话 Run 可并发调用）
+    std::vector<Result> parts(tiles.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]()
     {
-        if (!m_ort || !m_ort->session)
+        for (size_t i = next.fetch_add(1); i < tiles.size(); i = next.fetch_add(1))
         {
-            R.outputImage = vis;
-            R.summary = "Model not loaded";
-            LOG_WARNING("推理请求但模型未加载", "Inference", 5022);
-            return R;
+            const QImage crop = (tiles[i] == rgb.rect()) ? rgb : rgb.copy(tiles[i]);
+            const QSize net = networkInputSize(crop.width(), crop.height());
+            DetectionPreprocessResult prep = preprocessDetectionInput(crop, net.width(), net.height());
+            parts[i] = runTensor(prep.tensor, prep.width, prep.height, prep.scale, prep.padW, prep.padH,
+                                 crop.width(), crop.height(), false);
+        }
+    };
+    // 每次 Run 内部已有算子级并行，默认只开少量切片并发
+    const int configured = config->tileParallelism > 0 ? config->tileParallelism : std::max(1, QThread::idealThreadCount() / 4);
+    const int threads = std::clamp(configured, 1, static_cast<int>(tiles.size()));
+    if (threads > 1)
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads - 1);
+        for (int t = 0; t < threads - 1; ++t)
+            pool.start(worker);
+        worker();
+        pool.waitForDone();
+    }
+    else
+    {
+        worker();
+    }
+
+    std::vector<Detection> all;
+    bool valid = true;
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        valid = valid && parts[i].valid;
+        const QPoint origin = tiles[i].topLeft();
+        for (Detection &d : parts[i].dets)
+        {
+            d.x1 += origin.x();
+            d.x2 += origin.x();
+            d.y1 += origin.y();
+            d.y2 += origin.y();
+            all.push_back(std::move(d));
         }
+    }
 
-        const int netW = m_inW, netH = m_inH;
-        DetectionPreprocessResult prep = preprocessDetectionInput(input, netW, netH);
-        Ort::Value in = createInputTensor(prep.tensor, prep.height, prep.width);
+    const bool modelThresholds = config->useModelThresholds;
+    const float iouThr = (modelThresholds && m_plan.iouThreshold >= 0.f) ? m_plan.iouThreshold
+                                                                       : m_iouThr.load(std::memory_order_relaxed);
+    const size_t candidates = all.size();
+    Result R;
+    R.dets = mergeTileDetections(std::move(all), iouThr);
+    R.valid = valid;
+    R.summary = detectionSummary(R.dets, m_plan.fromMetadata ? m_plan.numClasses : 4) +
+                QStringLiteral("  (%1 tiles)").arg(static_cast<int>(tiles.size()) - 1);
+    LOG_DEBUG(QStringLiteral("切片推理: %1x%2, %3 个 %4px 切片 + 整图, %5 线程, %6 个候选合并为 %7, 耗时 %8 ms")
+                  .arg(rgb.width())
+                  .arg(rgb.height())
+                  .arg(static_cast<int>(tiles.size()) - 1)
+                  .arg(tile)
+                  .arg(threads)
+                  .arg(static_cast<int>(candidates))
+                  .arg(static_cast<int>(R.dets.size()))
+                  .arg(timer.elapsed()),
+              "Inference");
+    return R;
+}
 
-        const size_t no = m_ort->session->GetOutputCount();
-        int detIndex = (m_detOutputIndex >= 0 && m_detOutputIndex < (int)no) ? m_detOutputIndex : -1;
-        auto isValidDetOutput = [&](int idx) -> bool {
-            if (idx < 0 || idx >= (int)no)
-                return false;
-            auto to = m_ort->session->GetOutputTypeInfo((size_t)idx);
-            if (to.GetONNXType() != ONNX_TYPE_TENSOR)
-                return false;
-            auto info = to.GetTensorTypeAndShapeInfo();
-            if (info.GetElementType() != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT)
-                return false;
-            auto sh = info.GetShape();
-            return sh.size() == 3;
-        };
-        if (!isValidDetOutput(detIndex))
-            detIndex = -1;
-        if (detIndex < 0)
+bool InferenceEngine::runTriage(std::vector<float> &tensor, int netW, int netH, float scale, int padW, int padH,
+                                int srcW, int srcH, Result &out) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    const float threshold = AppConfig::instance().current()->triageConfidence;
+    const int classCount = m_plan.fromMetadata ? m_plan.numClasses : 4;
+    const int normalClass = normalClassIndex(classCount);
+    float normalScore = 0.f;
+    bool normal = false;
+    Result coarse;
+
+    if (m_ort && m_ort->triageSession)
+    {
+        try
         {
-            for (size_t i = 0; i < no; ++i)
+            std::vector<uint8_t> inputStorage;
+            Ort::Value in = createInputTensor(tensor, netH, netW, m_ort->triageInput, inputStorage);
+            Ort::Value scores{nullptr};
+            QString error;
+            if (!runSingleOutput(*m_ort->triageSession, m_ort->triageInputNames, in, m_ort->triageOutputName, scores, &error))
             {
-                if (isValidDetOutput((int)i))
+                LOG_WARNING(QStringLiteral("初筛推理失败，改为完整检测: %1").arg(error), "Inference", 5035);
+            }
+            else if (const size_t count = scores.GetTensorTypeAndShapeInfo().GetElementCount();
+                     count > static_cast<size_t>(normalClass))
+            {
+                const TensorView view = tensorView(scores, TensorFormat());
+                std::vector<float> p(count);
+                float sum = 0.f;
+                bool probabilities = true;
+                for (size_t i = 0; i < count; ++i)
                 {
-                    detIndex = (int)i;
-                    break;
+                    p[i] = view.at(i);
+                    sum += p[i];
+                    probabilities = probabilities && p[i] >= 0.f && p[i] <= 1.f;
                 }
+                // 导出时未带 softmax 的分类头输出 logits，这里补做
+                if (!probabilities || std::fabs(sum - 1.f) > 1e-3f)
+                {
+                    const float peak = *std::max_element(p.begin(), p.end());
+                    sum = 0.f;
+                    for (float &v : p)
+                    {
+                        v = std::exp(v - peak);
+                        sum += v;
+                    }
+                    for (float &v : p)
+                        v /= sum;
+                }
+                normalScore = p[static_cast<size_t>(normalClass)];
+                normal = std::max_element(p.begin(), p.end()) - p.begin() == normalClass && normalScore >= threshold;
+            }
+        }
+        catch (const Ort::Exception &e)
+        {
+            LOG_WARNING(QStringLiteral("初筛推理异常，改为完整检测: %1").arg(QString::fromUtf8(e.what())), "Inference", 5035);
+        }
+    }
+    else
+    {
+        // 低分辨率检测只检出 NORMAL 且置信度足够时才提前结束；无框或出现任何异常类别都交给完整检测
+        coarse = runTensor(tensor, netW, netH, scale, padW, padH, srcW, srcH, false);
+        normal = coarse.valid && !coarse.dets.empty();
+        for (const Detection &d : coarse.dets)
+        {
+            normal = normal && d.cls == normalClass;
+            normalScore = std::max(normalScore, d.score);
+        }
+        normal = normal && normalScore >= threshold;
+    }
+
+    m_cascade.screened.fetch_add(1, std::memory_order_relaxed);
+    m_cascade.triageNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+    if (!normal)
+        return false;
+
+    m_cascade.earlyExits.fetch_add(1, std::memory_order_relaxed);
+    out = std::move(coarse);
+    out.valid = true;
+    const QString verdict = QStringLiteral("Triage: %1 %2, detection skipped").arg(className(normalClass)).arg(normalScore, 0, 'f', 2);
+    out.summary = out.dets.empty() ? verdict : QStringLiteral("%1  (%2)").arg(detectionSummary(out.dets, classCount), verdict);
+    return true;
+}
+
+InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segmentationMode, bool renderOutput) const
+{
+    Result R;
+    if (!segmentationMode)
+    {
+        const QSize triage = triageInputSize(input.width(), input.height());
+        if (triage.isValid())
+        {
+            DetectionPreprocessResult prep = preprocessDetectionInput(input, triage.width(), triage.height());
+            if (runTriage(prep.tensor, prep.width, prep.height, prep.scale, prep.padW, prep.padH,
+                          input.width(), input.height(), R))
+            {
+                if (renderOutput)
+                    R.outputImage = renderResult(input, R, segmentationMode);
+                return R;
             }
         }
-        if (detIndex < 0)
+    }
+    QElapsedTimer timer;
+    timer.start();
+    if (!segmentationMode && shouldTile(input.width(), input.height()))
+    {
+        R = runTiled(input);
+    }
+    else
+    {
+        const QSize net = networkInputSize(input.width(), input.height());
+        DetectionPreprocessResult prep = preprocessDetectionInput(input, net.width(), net.height());
+        R = runTensor(prep.tensor, prep.width, prep.height, prep.scale, prep.padW, prep.padH,
+                      input.width(), input.height(), segmentationMode);
+    }
+    if (!segmentationMode)
+    {
+        m_cascade.fullRuns.fetch_add(1, std::memory_order_relaxed);
+        m_cascade.fullNs.fetch_add(timer.nsecsElapsed(), std::memory_order_relaxed);
+    }
+    if (renderOutput)
+        R.outputImage = renderResult(input, R, segmentationMode);
+    return R;
+}
+
+InferenceEngine::Result InferenceEngine::runTensor(std::vector<float> &tensor, int netW, int netH, float scale,
+                                                   int padW, int padH, int srcW, int srcH, bool segmentationMode) const
+{
+    Result R;
+
+    try
+    {
+        if (!m_ort || !m_ort->session)
+        {
+            R.summary = "Model not loaded";
+            LOG_WARNING("推理请求但模型未加载", "Inference", 5022);
+            return R;
+        }
+
+        // netW x netH 为实际张量尺寸（最小填充时小于 m_inW x m_inH），框坐标还原与掩码裁剪均以此为准
+        const DecodePlan &plan = m_plan;
+        // UseModelThresholds 打开且模型元数据给出默认阈值时以模型为准，否则用配置值
+        const bool modelThresholds = AppConfig::instance().current()->useModelThresholds;
+        const float confThr = (modelThresholds && plan.confThreshold >= 0.f) ? plan.confThreshold
+                                                                            : m_confThr.load(std::memory_order_relaxed);
+        const float iouThr = (modelThresholds && plan.iouThreshold >= 0.f) ? plan.iouThreshold
+                                                                          : m_iouThr.load(std::memory_order_relaxed);
+        if (plan.detOutput < 0)
         {
-            R.outputImage = vis;
             R.summary = "Detection output missing";
             LOG_WARNING("模型输出无效: 未找到检测张量", "Inference", 5001);
             return R;
         }
+        std::vector<uint8_t> inputStorage;
+        Ort::Value in = createInputTensor(tensor, netH, netW, m_ort->input, inputStorage);
 
-        bool wantSegmentation = segmentationMode && hasSegmentationSupport();
-        std::vector<int> requestIndices;
-        requestIndices.push_back(detIndex);
-        if (wantSegmentation && m_segOutputIndex >= 0 &&
-            m_segOutputIndex < static_cast<int>(no))
-            requestIndices.push_back(m_segOutputIndex);
-
-        std::vector<const char *> requestNames;
-        requestNames.reserve(requestIndices.size());
-        for (int idx : requestIndices)
-            requestNames.push_back(m_ort->outputNames[static_cast<size_t>(idx)]);
+        const bool wantSegmentation = segmentationMode && hasSegmentationSupport();
+        const char *requestNames[2] = {m_ort->outputNames[static_cast<size_t>(plan.detOutput)], nullptr};
+        size_t requestCount = 1;
+        if (wantSegmentation)
+            requestNames[requestCount++] = m_ort->outputNames[static_cast<size_t>(plan.protoOutput)];
 
         auto outputs = m_ort->session->Run(Ort::RunOptions{nullptr},
                                            m_ort->inputNames.data(), &in, 1,
-                                           requestNames.data(), requestNames.size());
+                                           requestNames, requestCount);
         if (outputs.empty() || !outputs[0].IsTensor())
         {
-            R.outputImage = vis;
             R.summary = "Invalid output";
             LOG_WARNING("模型输出无效", "Inference", 5003);
             return R;
         }
 
-        const float *data = outputs[0].GetTensorData<float>();
+        const TensorView det = tensorView(outputs[0], m_ort->detection);
         auto info = outputs[0].GetTensorTypeAndShapeInfo();
         auto sh = info.GetShape();
-        const int d1 = std::abs((int)sh[1]);
-        const int d2 = std::abs((int)sh[2]);
-        const int attrCount = std::min(d1, d2);
-        const int detCount = std::max(d1, d2);
-        const bool attrLast = (d2 == attrCount);
+        const int attrCount = plan.attrCount;
+        const bool attrLast = plan.layout == 1 || (plan.layout == 0 && sh.size() == 3 && sh[2] == attrCount);
+        if (sh.size() != 3 || (attrLast ? sh[2] : sh[1]) != attrCount)
+        {
+            R.summary = "Invalid output";
+            LOG_WARNING(QStringLiteral("检测输出形状与解码方案不符（属性数 %1）").arg(attrCount), "Inference", 5003);
+            return R;
+        }
+        const int detCount = static_cast<int>(attrLast ? sh[1] : sh[2]);
 
-        int nc = (m_numClasses > 0 ? m_numClasses : std::max(1, std::max(attrCount - 4, attrCount - 5)));
-        bool hasObj = (m_numClasses > 0 ? m_hasObj : (attrCount - 5 == nc));
+        const int nc = plan.numClasses;
+        const bool hasObj = plan.hasObjectness;
+        // 无元数据时保持旧行为：检测任务固定 4 类
+        const int maxDetClass = plan.fromMetadata ? nc - 1 : 3;
 
         auto getAttr = [&](int detIdx, int attrIdx) -> float
         {
-            return attrLast ? data[detIdx * attrCount + attrIdx]
-                            : data[attrIdx * detCount + detIdx];
+            return attrLast ? det.at(static_cast<size_t>(detIdx) * attrCount + attrIdx)
+                            : det.at(static_cast<size_t>(attrIdx) * detCount + detIdx);
         };
 
         const int clsOffset = hasObj ? 5 : 4;
 
-        bool segReady = wantSegmentation && outputs.size() > 1 && outputs[1].IsTensor() && m_maskChannels > 0;
-        int maskOffset = -1;
-        int maskChannels = segReady ? m_maskChannels : 0;
-        if (segReady)
-        {
-            maskOffset = clsOffset + nc;
-            if (maskOffset + maskChannels > attrCount)
-                segReady = false;
-        }
+        bool segReady = wantSegmentation && outputs.size() > 1 && outputs[1].IsTensor();
+        const int maskChannels = segReady ? plan.maskChannels : 0;
+        const int maskOffset = clsOffset + nc;
+        if (segReady && maskOffset + maskChannels > attrCount)
+            segReady = false;
+
+        // 分数已是概率时直接比较；否则在 logit 空间比较，被拒绝的候选框无需计算指数
+        const bool sigmoided = plan.scoresSigmoided;
+        const float rawThr = sigmoided ? confThr : logit(confThr);
 
         std::vector<Box> candidates;
         candidates.reserve(std::min(detCount, 3000));
         for (int idx = 0; idx < detCount; ++idx)
         {
+            int bestClass = -1;
+            float bestScore = 0.f;
+            if (!hasObj)
+            {
+                float bestRaw = -FLT_MAX;
+                for (int k = 0; k < nc; ++k)
+                {
+                    const float v = getAttr(idx, clsOffset + k);
+                    if (v > bestRaw)
+                    {
+                        bestRaw = v;
+                        bestClass = k;
+                    }
+                }
+                if (bestClass < 0 || bestRaw < rawThr)
+                    continue;
+                bestScore = sigmoided ? bestRaw : sigmoid(bestRaw);
+            }
+            else
+            {
+                const float obj = sigmoided ? getAttr(idx, 4) : sigmoid(getAttr(idx, 4));
+                if (obj < confThr)
+                    continue;
+                for (int k = 0; k < nc; ++k)
+                {
+                    const float v = getAttr(idx, clsOffset + k);
+                    const float score = obj * (sigmoided ? v : sigmoid(v));
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestClass = k;
+                    }
+                }
+            }
+            if (bestClass < 0 || bestScore < confThr)
+                continue;
+
             float cx = getAttr(idx, 0);
             float cy = getAttr(idx, 1);
             float bw = getAttr(idx, 2);
             float bh = getAttr(idx, 3);
 
-            const float maxAbs = std::max({std::fabs(cx), std::fabs(cy), std::fabs(bw), std::fabs(bh)});
-            const bool normalized = (maxAbs <= 1.5f);
+            const bool normalized = plan.boxesNormalized >= 0
+                                        ? plan.boxesNormalized == 1
+                                        : std::max({std::fabs(cx), std::fabs(cy), std::fabs(bw), std::fabs(bh)}) <= 1.5f;
             if (normalized)
             {
                 cx *= netW;
@@ -808,23 +2113,6 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
                 bh *= netH;
             }
 
-            float obj = hasObj ? sigmoid(getAttr(idx, 4)) : 1.f;
-
-            int bestClass = -1;
-            float bestScore = 0.f;
-            for (int k = 0; k < nc; ++k)
-            {
-                float clsProb = sigmoid(getAttr(idx, clsOffset + k));
-                float score = hasObj ? (obj * clsProb) : clsProb;
-                if (score > bestScore)
-                {
-                    bestScore = score;
-                    bestClass = k;
-                }
-            }
-            if (bestClass < 0 || bestScore < m_confThr)
-                continue;
-
             float x1 = cx - bw * 0.5f;
             float y1 = cy - bh * 0.5f;
             float x2 = cx + bw * 0.5f;
@@ -840,9 +2128,9 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
             box.x2 = x2;
             box.y2 = y2;
             box.score = bestScore;
-            box.cls = segmentationMode ? bestClass : std::clamp(bestClass, 0, 3);
+            box.cls = segmentationMode ? bestClass : std::clamp(bestClass, 0, maxDetClass);
 
-            if (segReady && maskOffset >= 0)
+            if (segReady)
             {
                 box.maskCoeffs.resize(static_cast<size_t>(maskChannels));
                 for (int m = 0; m < maskChannels; ++m)
@@ -852,13 +2140,13 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
             candidates.push_back(std::move(box));
         }
 
-        auto kept = nms_classwise(std::move(candidates), m_iouThr);
-        scale_boxes_back(kept, prep.scale, prep.padW, prep.padH, input.width(), input.height());
+        auto kept = nms_classwise(std::move(candidates), iouThr);
+        scale_boxes_back(kept, scale, padW, padH, srcW, srcH);
 
         QImage overlay;
         if (segReady && !kept.empty())
         {
-            const Ort::Value &protoTensor = outputs.back();
+            const Ort::Value &protoTensor = outputs[1];
             auto protoInfo = protoTensor.GetTensorTypeAndShapeInfo();
             auto protoShape = protoInfo.GetShape();
             if (protoShape.size() == 4)
@@ -869,13 +2157,20 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
                 const int protoW = std::abs((int)protoShape[3]);
                 if (protoBatch == 1 && protoC == maskChannels && protoH > 0 && protoW > 0)
                 {
-                    const float *protoData = protoTensor.GetTensorData<float>();
+                    const TensorView proto = tensorView(protoTensor, m_ort->prototype);
                     const size_t protoPlane = (size_t)protoH * (size_t)protoW;
                     std::vector<float> buffer(protoPlane);
-                    QImage maskComposite(input.size(), QImage::Format_ARGB32_Premultiplied);
-                    maskComposite.fill(Qt::transparent);
-                    const QRect canvas(0, 0, input.width(), input.height());
+                    // 标签图：像素值为类别 + 1（0 为背景），重叠处归属概率更高的实例
+                    QImage labels(srcW, srcH, QImage::Format_Indexed8);
+                    labels.setColorTable(segmentationColorTable());
+                    labels.fill(0);
+                    std::vector<uchar> strength(static_cast<size_t>(srcW) * static_cast<size_t>(srcH), 0);
+                    const QRect canvas(0, 0, srcW, srcH);
                     const float maskThreshold = 0.45f;
+                    // 原型分辨率 <-> 原图坐标：proto -> 网络输入（去 letterbox 填充）-> 原图
+                    const double protoToNetX = static_cast<double>(netW) / protoW;
+                    const double protoToNetY = static_cast<double>(netH) / protoH;
+                    const double contourPixelArea = (protoToNetX / scale) * (protoToNetY / scale);
 
                     for (auto &box : kept)
                     {
@@ -885,10 +2180,7 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
                         std::fill(buffer.begin(), buffer.end(), 0.f);
                         for (int c = 0; c < maskChannels; ++c)
                         {
-                            const float coeff = box.maskCoeffs[(size_t)c];
-                            const float *plane = protoData + (size_t)c * protoPlane;
-                            for (size_t idx = 0; idx < protoPlane; ++idx)
-                                buffer[idx] += coeff * plane[idx];
+                            proto.accumulate((size_t)c * protoPlane, protoPlane, box.maskCoeffs[(size_t)c], buffer.data());
                         }
                         for (float &v : buffer)
                             v = sigmoid(v);
@@ -904,16 +2196,16 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
                             }
                         }
 
-                        QImage resized = mask.scaled(prep.width, prep.height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-                        int cropX = std::clamp(prep.padW, 0, resized.width());
-                        int cropY = std::clamp(prep.padH, 0, resized.height());
-                        int cropW = std::clamp((int)std::round(input.width() * prep.scale), 0, resized.width() - cropX);
-                        int cropH = std::clamp((int)std::round(input.height() * prep.scale), 0, resized.height() - cropY);
+                        QImage resized = mask.scaled(netW, netH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                        int cropX = std::clamp(padW, 0, resized.width());
+                        int cropY = std::clamp(padH, 0, resized.height());
+                        int cropW = std::clamp((int)std::round(srcW * scale), 0, resized.width() - cropX);
+                        int cropH = std::clamp((int)std::round(srcH * scale), 0, resized.height() - cropY);
                         if (cropW <= 0 || cropH <= 0)
                             continue;
 
                         QImage cropped = resized.copy(cropX, cropY, cropW, cropH);
-                        QImage restored = cropped.scaled(input.width(), input.height(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                        QImage restored = cropped.scaled(srcW, srcH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 
                         QRect roi(std::max(0, (int)std::floor(box.x1)),
                                   std::max(0, (int)std::floor(box.y1)),
@@ -927,48 +2219,61 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
                         for (int y = roi.top(); y <= roi.bottom(); ++y)
                         {
                             const uchar *maskRow = restored.constScanLine(y);
-                            QRgb *overlayRow = reinterpret_cast<QRgb *>(maskComposite.scanLine(y));
+                            uchar *labelRow = labels.scanLine(y);
+                            uchar *strengthRow = strength.data() + static_cast<size_t>(y) * static_cast<size_t>(srcW);
+                            const uchar label = static_cast<uchar>(std::clamp(box.cls + 1, 1, 255));
                             for (int x = roi.left(); x <= roi.right(); ++x)
                             {
                                 float alpha = maskRow[x] / 255.f;
                                 if (alpha < maskThreshold)
                                     continue;
                                 covered += 1.0;
-                                int a = std::clamp<int>(std::lround(alpha * 200.f), 0, 255);
-                                QColor color = segmentationClassColor(box.cls);
-                                QRgb current = overlayRow[x];
-                                if (qAlpha(current) < a)
-                                    overlayRow[x] = qRgba(color.red(), color.green(), color.blue(), a);
+                                if (strengthRow[x] < maskRow[x])
+                                {
+                                    strengthRow[x] = maskRow[x];
+                                    labelRow[x] = label;
+                                }
                             }
                         }
 
                         box.maskAreaPixels = covered;
                         box.hasMask = covered > 0.0;
-                    }
 
-                    overlay = maskComposite.convertToFormat(QImage::Format_ARGB32);
-                    if (!overlay.isNull())
-                    {
-                        QPainter painter(&vis);
-                        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
-                        painter.drawImage(QPoint(), overlay);
+                        // 在原型分辨率上直接提取轮廓（比原图小一个数量级），再映射回原图坐标
+                        const QRect protoRoi(QPoint((int)std::floor((box.x1 * scale + padW) / protoToNetX),
+                                                    (int)std::floor((box.y1 * scale + padH) / protoToNetY)),
+                                             QPoint((int)std::ceil((box.x2 * scale + padW) / protoToNetX) - 1,
+                                                    (int)std::ceil((box.y2 * scale + padH) / protoToNetY) - 1));
+                        QVector<QPolygonF> contours = MaskContours::trace(buffer.data(), protoW, protoH, protoRoi, maskThreshold);
+                        double contourArea = 0.0;
+                        for (QPolygonF &poly : contours)
+                        {
+                            contourArea += MaskContours::signedArea(poly) * contourPixelArea;
+                            for (QPointF &pt : poly)
+                            {
+                                pt.setX(std::clamp((pt.x() * protoToNetX - padW) / scale, 0.0, (double)srcW));
+                                pt.setY(std::clamp((pt.y() * protoToNetY - padH) / scale, 0.0, (double)srcH));
+                            }
+                        }
+                        box.contours = std::move(contours);
+                        box.contourAreaPixels = std::max(0.0, contourArea);
+
+                        // 两种面积来自不同采样路径，偏差过大说明掩码贴边或极小，仅记录不拦截
+                        if (covered >= 64.0 && std::fabs(box.contourAreaPixels - covered) > 0.25 * covered)
+                        {
+                            LOG_DEBUG(QStringLiteral("掩码面积与轮廓面积偏差较大: %1 px vs %2 px (cls=%3)")
+                                          .arg(covered, 0, 'f', 0)
+                                          .arg(box.contourAreaPixels, 0, 'f', 0)
+                                          .arg(box.cls),
+                                      "Inference");
+                        }
                     }
+
+                    overlay = labels;
                 }
             }
         }
 
-        for (const auto &box : kept)
-        {
-            QRectF rect(box.x1, box.y1, box.x2 - box.x1, box.y2 - box.y1);
-            QString label = segmentationMode ? segmentationClassName(box.cls) : className(box.cls);
-            QString text = segmentationMode
-                               ? label
-                               : QString("%1  %2%").arg(label).arg(int(std::round(box.score * 100)));
-            QColor color = segmentationMode ? segmentationClassColor(box.cls) : classColor(box.cls);
-            drawBox(vis, rect, text, color);
-        }
-
-        R.outputImage = vis;
         R.segmentationMask = (segmentationMode ? overlay : QImage());
         R.dets.reserve(kept.size());
         for (const auto &box : kept)
@@ -982,6 +2287,8 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
             det.cls = box.cls;
             det.maskAreaPixels = box.maskAreaPixels;
             det.hasMask = box.hasMask;
+            det.contours = box.contours;
+            det.contourAreaPixels = box.contourAreaPixels;
             R.dets.push_back(det);
         }
 
@@ -992,33 +2299,16 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
         }
         else
         {
-            int c0 = 0, c1 = 0, c2 = 0, c3 = 0;
-            for (const auto &b : kept)
-            {
-                if (b.cls == 0)
-                    ++c0;
-                else if (b.cls == 1)
-                    ++c1;
-                else if (b.cls == 2)
-                    ++c2;
-                else
-                    ++c3;
-            }
-            R.summary = QStringLiteral("Detections: %1  [CAM:%2  PINCER:%3  MIXED:%4  NORMAL:%5]")
-                            .arg((int)kept.size())
-                            .arg(c0)
-                            .arg(c1)
-                            .arg(c2)
-                            .arg(c3);
+            R.summary = detectionSummary(R.dets, maxDetClass + 1);
         }
 
+        R.valid = true;
         return R;
     }
     catch (const std::exception &e)
     {
         LOG_ERROR(QString("推理异常: %1").arg(e.what()), "Inference", 5023);
         Result err;
-        err.outputImage = vis;
         err.summary = QString("推理异常: %1").arg(e.what());
         return err;
     }
@@ -1026,7 +2316,6 @@ InferenceEngine::Result InferenceEngine::runYolo(const QImage &input, bool segme
     {
         LOG_ERROR("推理发生未知异常", "Inference", 5024);
         Result err;
-        err.outputImage = vis;
         err.summary = "推理发生未知异常";
         return err;
     }
@@ -1037,10 +2326,8 @@ bool InferenceEngine::hasSegmentationSupport() const
 {
 #ifdef HAVE_ORT
     return m_ort && m_ort->session &&
-           m_segOutputIndex >= 0 &&
-           m_maskChannels > 0 &&
-           m_maskWidth > 0 &&
-           m_maskHeight > 0;
+           m_plan.protoOutput >= 0 &&
+           m_plan.maskChannels > 0;
 #else
     return false;
 #endif
@@ -1,7 +1,12 @@
 #pragma once
+#include <QByteArray>
 #include <QImage>
 #include <QString>
 #include <QColor>
+#include <QPolygonF>
+#include <QSize>
+#include <QVector>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -28,6 +33,24 @@ public:
         double maskAreaPixels{0.0};
         double maskAreaMm2{0.0};
         bool hasMask{false};
+        QVector<QPolygonF> contours;   // 掩码轮廓（原图像素坐标；外轮廓有向面积为正、孔洞为负）
+        double contourAreaPixels{0.0}; // 轮廓多边形面积，用于与 maskAreaPixels 交叉校验
+    };
+
+    // 未经 8 位显示转换的单通道像素（如 DICOM 模态值），调用期间须保持有效
+    struct PixelView
+    {
+        const void *data{nullptr};
+        int width{0};
+        int height{0};
+        qsizetype stride{0};     // 每行字节数
+        int bitsAllocated{16};   // 8 或 16
+        bool isSigned{false};
+        double slope{1.0};
+        double intercept{0.0};
+        double windowCenter{0.0};
+        double windowWidth{0.0}; // <= 0 时按数据范围取窗
+        bool invert{false};      // MONOCHROME1
     };
 
     struct Result
@@ -35,56 +58,151 @@ public:
         QImage outputImage;          // 已绘制框的图
         QString summary;             // 统计摘要
         std::vector<Detection> dets; // 检测框
-        QImage segmentationMask;     // 分割掩码图像（仅用于分割任务）
+        QImage segmentationMask;     // 分割标签图（Indexed8，像素值为类别 + 1，仅用于分割任务）
+        bool valid{false};           // 推理完整完成（出错时为 false，不写入结果缓存）
+    };
+
+    // 级联初筛统计（检测任务，Inference/TriageCascade 打开时累计）
+    struct CascadeStats
+    {
+        qint64 screened{0};   // 经过初筛的图像数
+        qint64 earlyExits{0}; // 初筛判为 NORMAL、跳过完整检测的图像数
+        qint64 fullRuns{0};   // 完整检测次数
+        double triageMs{0.0}; // 初筛累计耗时
+        double fullMs{0.0};   // 完整检测累计耗时
+
+        double hitRate() const;
+        // 节省耗时估计：跳过的图像数 × 完整检测平均耗时 - 全部初筛耗时
+        double savedMs() const;
+        // 初筛图像数、判为 NORMAL 跳过的图像数与占比、完整检测次数、两级平均耗时及估计节省时间
+        QString toText() const;
     };
 
     InferenceEngine();
     ~InferenceEngine();
 
     bool loadModel(const QString &path);
+    /**
+     * @brief 加载模型时是否发布类别名与颜色（全局，供界面与导出使用），默认发布
+     * @details 精度对比等辅助引擎须在 loadModel 前关闭，以免覆盖当前模型的类别
+     */
+    void setPublishLabels(bool publish) { m_publishLabels = publish; }
     void unload();
     bool isLoaded() const;
-    Result run(const QImage &input, Task taskHint) const;
+    // renderOutput 为 false 时不生成 outputImage（批量推理只保留检测与掩码）
+    Result run(const QImage &input, Task taskHint, bool renderOutput = true) const;
+    // 原始像素直接生成输入张量；renderOutput 为 false 时不生成 outputImage
+    Result run(const PixelView &pixels, Task taskHint, bool renderOutput = false) const;
+    // 在输入图上绘制掩码与检测框（按需生成显示图）
+    static QImage renderResult(const QImage &input, const Result &result, bool segmentationMode);
+    // 原始像素按视图的窗宽窗位转为 8 位灰度图（与张量预处理使用同一查找表）
+    static QImage windowedImage(const PixelView &pixels);
 
     bool isSegmentationModel() const;
+    /**
+     * @brief 结果缓存键：输入内容哈希 + 模型指纹 + 生效阈值与推理模式 + 引擎版本
+     * @return 模型未加载或无指纹时为空（不缓存）
+     */
+    QByteArray resultKey(const QByteArray &contentHash, Task taskHint) const;
+    /**
+     * @brief 结果缓存键中取决于引擎状态的部分（模型指纹、生效阈值、推理模式与引擎版本）
+     * @details 须在模型加载期间于持有引擎的线程取得；之后由 combineResultKey 与内容哈希组合，
+     *          工作线程无需再访问引擎
+     * @return 模型未加载或无指纹时为空
+     */
+    QByteArray resultKeyContext(Task taskHint) const;
+    static QByteArray combineResultKey(const QByteArray &context, const QByteArray &contentHash);
+    // 已加载模型的输入张量精度（float32 / float16 / uint8 / int8），未加载时为空
+    QString inputPrecision() const;
+    /**
+     * @brief 按 Models/Precision 选择精度变体：name.ext → name.<precision>.ext
+     * @details 精度为 fp32 或变体文件不存在时返回原路径（后者记录警告）
+     */
+    static QString resolveModelVariant(const QString &basePath);
+    /**
+     * @brief 加载级联初筛分类模型（单输出 [1, C] 类别分数，类别顺序与检测模型一致）
+     * @details 须在 loadModel 之后调用，重新加载检测模型时一并卸载。
+     *          path 为空时初筛改用检测模型低分辨率推理，仅动态输入模型可用
+     * @return 级联初筛可用时返回 true
+     */
+    bool loadTriageModel(const QString &path);
+    CascadeStats cascadeStats() const;
+    void resetCascadeStats();
+    // 可在推理进行中调用（配置热重载），下一次 run 生效
     void setThresholds(float conf, float iou)
     {
-        m_confThr = conf;
-        m_iouThr = iou;
+        m_confThr.store(conf, std::memory_order_relaxed);
+        m_iouThr.store(iou, std::memory_order_relaxed);
     }
 
-    // 固定 4 类：名字 + 颜色
+    // 默认 4 类：名字 + 颜色；模型元数据携带类别时以其为准
     static QString className(int cls);
     static QColor classColor(int cls);
     static QString segmentationClassName(int cls);
     static QColor segmentationClassColor(int cls);
+    // 分割类别数：优先取已加载模型元数据中的类别，否则取配置
+    static int segmentationClassCount();
+    // 标签图调色板：0 透明，i + 1 为第 i 类颜色；classOpacity 按类别缩放 alpha（缺省为 1）
+    static QVector<QRgb> segmentationColorTable(int alpha = 200, const QVector<qreal> &classOpacity = {});
 
 private:
     struct OrtPack;
     std::unique_ptr<OrtPack> m_ort;
 
     int m_inW{640}, m_inH{640};
-    float m_confThr{0.25f};
-    float m_iouThr{0.45f};
+    bool m_dynamicInput{false}; // 模型空间维度为动态，可按输入长宽比使用矩形最小填充
+    bool m_publishLabels{true};
+    std::atomic<float> m_confThr{0.25f};
+    std::atomic<float> m_iouThr{0.45f};
 
-    // 模型输出结构推断
-    bool m_isYoloDetect{false};
-    int m_channels{0};
-    int m_numClasses{0};
-    bool m_hasObj{false};
+    // 解码方案：加载时由模型元数据（或按输出形状推断）一次性确定，推理时不再探测会话
+    struct DecodePlan
+    {
+        bool fromMetadata{false};
+        int detOutput{-1};       // 检测输出索引
+        int protoOutput{-1};     // 分割原型输出索引，-1 表示无
+        int attrCount{0};        // 每个候选框的属性数
+        int layout{0};           // 0 按形状判断，1 属性在末维 [1,N,C]，2 属性在中间维 [1,C,N]
+        int numClasses{0};
+        bool hasObjectness{false};
+        int maskChannels{0};
+        int boxesNormalized{-1}; // -1 逐框判断
+        bool scoresSigmoided{false};
+        float confThreshold{-1.f}; // 模型内置默认阈值，< 0 表示未指定
+        float iouThreshold{-1.f};
+    };
+    DecodePlan m_plan;
 
     QString m_modelPath;
-    int m_detOutputIndex{-1};
-    int m_segOutputIndex{-1};
 
-    // YOLO segmentation prototype information
-    int m_maskChannels{0};
-    int m_maskWidth{0};
-    int m_maskHeight{0};
-    int m_detVectorSize{0};
+    // 本次推理的网络输入尺寸：固定输入为 m_inW x m_inH；动态输入且启用 MinimalPadding 时按长宽比收缩
+    QSize networkInputSize(int srcW, int srcH) const;
+    // 检测任务的大图是否走切片推理（Inference/TiledInference 与尺寸门限）
+    bool shouldTile(int srcW, int srcH) const;
+    // 初筛输入尺寸：分类模型取其输入尺寸，否则为低分辨率检测尺寸；级联关闭或不可用时为空
+    QSize triageInputSize(int srcW, int srcH) const;
+
+    // 级联计数：run 为 const 且可并发调用
+    struct CascadeCounters
+    {
+        std::atomic<qint64> screened{0};
+        std::atomic<qint64> earlyExits{0};
+        std::atomic<qint64> fullRuns{0};
+        std::atomic<qint64> triageNs{0};
+        std::atomic<qint64> fullNs{0};
+    };
+    mutable CascadeCounters m_cascade;
 
 #ifdef HAVE_ORT
-    Result runYolo(const QImage &input, bool segmentationMode) const;
+    Result runYolo(const QImage &input, bool segmentationMode, bool renderOutput) const;
+    // 切片 + 整图并发推理，框映射回原图后跨切片合并（仅检测，不生成掩码与结果图）
+    Result runTiled(const QImage &input) const;
+    // netW x netH 为张量的实际空间尺寸
+    Result runTensor(std::vector<float> &tensor, int netW, int netH, float scale, int padW, int padH,
+                     int srcW, int srcH, bool segmentationMode) const;
+    // 初筛：判为 NORMAL 时返回 true 并填写 out，调用方不再做完整检测
+    bool runTriage(std::vector<float> &tensor, int netW, int netH, float scale, int padW, int padH,
+                   int srcW, int srcH, Result &out) const;
 #endif
     bool hasSegmentationSupport() const;
 };
@@ -0,0 +1,283 @@
+#include "MaskContours.h"
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    struct Segment
+    {
+        qint64 edgeA;
+        qint64 edgeB;
+        QPointF a;
+        QPointF b;
+        bool used{false};
+    };
+
+    double pointLineDistance(const QPointF &p, const QPointF &a, const QPointF &b)
+    {
+        const double dx = b.x() - a.x();
+        const double dy = b.y() - a.y();
+        const double len = std::hypot(dx, dy);
+        if (len <= 1e-12)
+            return std::hypot(p.x() - a.x(), p.y() - a.y());
+        return std::fabs(dy * p.x() - dx * p.y() + b.x() * a.y() - b.y() * a.x()) / len;
+    }
+
+    void simplifyRange(const QPolygonF &pts, int first, int last, double epsilon, std::vector<char> &keep)
+    {
+        if (last <= first + 1)
+            return;
+        double maxDist = -1.0;
+        int index = first;
+        for (int i = first + 1; i < last; ++i)
+        {
+            const double d = pointLineDistance(pts[i], pts[first], pts[last]);
+            if (d > maxDist)
+            {
+                maxDist = d;
+                index = i;
+            }
+        }
+        if (maxDist > epsilon)
+        {
+            keep[static_cast<size_t>(index)] = 1;
+            simplifyRange(pts, first, index, epsilon, keep);
+            simplifyRange(pts, index, last, epsilon, keep);
+        }
+    }
+
+    // 闭合多边形：以起点和离它最远的点切成两段分别简化
+    QPolygonF simplifyClosed(const QPolygonF &ring, double epsilon)
+    {
+        const int n = ring.size();
+        if (n < 4 || epsilon <= 0.0)
+            return ring;
+        int far = 0;
+        double farDist = -1.0;
+        for (int i = 1; i < n; ++i)
+        {
+            const double d = std::hypot(ring[i].x() - ring[0].x(), ring[i].y() - ring[0].y());
+            if (d > farDist)
+            {
+                farDist = d;
+                far = i;
+            }
+        }
+        QPolygonF closed = ring;
+        closed.append(ring[0]);
+        std::vector<char> keep(static_cast<size_t>(closed.size()), 0);
+        keep[0] = keep[static_cast<size_t>(far)] = keep.back() = 1;
+        simplifyRange(closed, 0, far, epsilon, keep);
+        simplifyRange(closed, far, closed.size() - 1, epsilon, keep);
+
+        QPolygonF out;
+        for (int i = 0; i < n; ++i)
+        {
+            if (keep[static_cast<size_t>(i)])
+                out.append(closed[i]);
+        }
+        return out;
+    }
+}
+
+namespace MaskContours
+{
+    double signedArea(const QPolygonF &polygon)
+    {
+        const int n = polygon.size();
+        if (n < 3)
+            return 0.0;
+        double sum = 0.0;
+        for (int i = 0, j = n - 1; i < n; j = i++)
+            sum += polygon[j].x() * polygon[i].y() - polygon[i].x() * polygon[j].y();
+        return 0.5 * sum;
+    }
+
+    QVector<QPolygonF> trace(const float *prob, int width, int height, const QRect &roi,
+                             float threshold, double epsilon)
+    {
+        const QRect area = roi.intersected(QRect(0, 0, width, height));
+        if (!prob || area.isEmpty())
+            return {};
+
+        // 采样点为像素中心；ROI 外补一圈背景，所有等值线都闭合
+        const int x0 = area.left() - 1;
+        const int y0 = area.top() - 1;
+        const int gw = area.width() + 2;
+        const int gh = area.height() + 2;
+        auto value = [&](int gx, int gy) -> float
+        {
+            const int x = x0 + gx;
+            const int y = y0 + gy;
+            if (!area.contains(x, y))
+                return 0.f;
+            return prob[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)];
+        };
+        auto lerp = [&](float va, float vb) -> double
+        {
+            const float d = vb - va;
+            return (std::fabs(d) < 1e-12f) ? 0.5 : std::clamp(static_cast<double>((threshold - va) / d), 0.0, 1.0);
+        };
+        // 边编号：水平边 (gx, gy)->(gx+1, gy)，竖直边 (gx, gy)->(gx, gy+1)
+        auto hEdge = [gw](int gx, int gy) { return (static_cast<qint64>(gy) * gw + gx) * 2; };
+        auto vEdge = [gw](int gx, int gy) { return (static_cast<qint64>(gy) * gw + gx) * 2 + 1; };
+        auto toPoint = [&](double gx, double gy) { return QPointF(x0 + gx + 0.5, y0 + gy + 0.5); };
+
+        std::vector<Segment> segments;
+        for (int gy = 0; gy + 1 < gh; ++gy)
+        {
+            for (int gx = 0; gx + 1 < gw; ++gx)
+            {
+                const float tl = value(gx, gy);
+                const float tr = value(gx + 1, gy);
+                const float br = value(gx + 1, gy + 1);
+                const float bl = value(gx, gy + 1);
+                const int code = (tl >= threshold ? 8 : 0) | (tr >= threshold ? 4 : 0) |
+                                 (br >= threshold ? 2 : 0) | (bl >= threshold ? 1 : 0);
+                if (code == 0 || code == 15)
+                    continue;
+
+                const qint64 top = hEdge(gx, gy);
+                const qint64 bottom = hEdge(gx, gy + 1);
+                const qint64 left = vEdge(gx, gy);
+                const qint64 right = vEdge(gx + 1, gy);
+                const QPointF pTop = toPoint(gx + lerp(tl, tr), gy);
+                const QPointF pBottom = toPoint(gx + lerp(bl, br), gy + 1);
+                const QPointF pLeft = toPoint(gx, gy + lerp(tl, bl));
+                const QPointF pRight = toPoint(gx + 1, gy + lerp(tr, br));
+                auto add = [&](qint64 ea, const QPointF &a, qint64 eb, const QPointF &b)
+                { segments.push_back({ea, eb, a, b}); };
+
+                // 鞍点按中心均值消歧
+                const bool centerInside = (tl + tr + br + bl) * 0.25f >= threshold;
+                switch (code)
+                {
+                case 1:
+                case 14:
+                    add(left, pLeft, bottom, pBottom);
+                    break;
+                case 2:
+                case 13:
+                    add(bottom, pBottom, right, pRight);
+                    break;
+                case 3:
+                case 12:
+                    add(left, pLeft, right, pRight);
+                    break;
+                case 4:
+                case 11:
+                    add(top, pTop, right, pRight);
+                    break;
+                case 6:
+                case 9:
+                    add(top, pTop, bottom, pBottom);
+                    break;
+                case 7:
+                case 8:
+                    add(left, pLeft, top, pTop);
+                    break;
+                case 5:
+                    if (centerInside)
+                    {
+                        add(left, pLeft, top, pTop);
+                        add(bottom, pBottom, right, pRight);
+                    }
+                    else
+                    {
+                        add(left, pLeft, bottom, pBottom);
+                        add(top, pTop, right, pRight);
+                    }
+                    break;
+                case 10:
+                    if (centerInside)
+                    {
+                        add(left, pLeft, bottom, pBottom);
+                        add(top, pTop, right, pRight);
+                    }
+                    else
+                    {
+                        add(left, pLeft, top, pTop);
+                        add(bottom, pBottom, right, pRight);
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        // 每条穿越边恰好被两个线段共享，按边编号串成闭环
+        QHash<qint64, QVector<int>> byEdge;
+        byEdge.reserve(static_cast<int>(segments.size()) * 2);
+        for (int i = 0; i < static_cast<int>(segments.size()); ++i)
+        {
+            byEdge[segments[static_cast<size_t>(i)].edgeA].append(i);
+            byEdge[segments[static_cast<size_t>(i)].edgeB].append(i);
+        }
+
+        QVector<QPolygonF> rings;
+        for (size_t start = 0; start < segments.size(); ++start)
+        {
+            if (segments[start].used)
+                continue;
+            QPolygonF ring;
+            Segment *seg = &segments[start];
+            seg->used = true;
+            ring.append(seg->a);
+            qint64 edge = seg->edgeB;
+            QPointF point = seg->b;
+            while (true)
+            {
+                ring.append(point);
+                int next = -1;
+                for (int idx : byEdge.value(edge))
+                {
+                    if (!segments[static_cast<size_t>(idx)].used)
+                    {
+                        next = idx;
+                        break;
+                    }
+                }
+                if (next < 0)
+                    break;
+                Segment &s = segments[static_cast<size_t>(next)];
+                s.used = true;
+                if (s.edgeA == edge)
+                {
+                    edge = s.edgeB;
+                    point = s.b;
+                }
+                else
+                {
+                    edge = s.edgeA;
+                    point = s.a;
+                }
+                if (edge == seg->edgeA)
+                    break;
+            }
+            if (ring.size() >= 3)
+            {
+                QPolygonF simplified = simplifyClosed(ring, epsilon);
+                if (simplified.size() >= 3)
+                    rings.append(simplified);
+            }
+        }
+
+        // 被奇数个环包围的是孔洞：统一外轮廓为正向面积、孔洞为负向
+        for (int i = 0; i < rings.size(); ++i)
+        {
+            int depth = 0;
+            for (int j = 0; j < rings.size(); ++j)
+            {
+                if (j != i && rings[j].containsPoint(rings[i].first(), Qt::OddEvenFill))
+                    ++depth;
+            }
+            const bool hole = (depth % 2) == 1;
+            if ((signedArea(rings[i]) < 0.0) != hole)
+                std::reverse(rings[i].begin(), rings[i].end());
+        }
+        return rings;
+    }
+}
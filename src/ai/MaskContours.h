@@ -0,0 +1,20 @@
+#pragma once
+#include <QPolygonF>
+#include <QRect>
+#include <QVector>
+
+namespace MaskContours
+{
+    /**
+     * @brief 用 marching squares 提取概率图在阈值处的闭合等值线，并做 Douglas-Peucker 简化
+     * @param prob 行主序概率图（width * height）
+     * @param roi 只在该矩形内取值，矩形外视为背景，保证轮廓闭合
+     * @param epsilon 简化容差（概率图像素）
+     * @return 概率图像素坐标（像素中心为 x + 0.5）下的闭合多边形；外轮廓为正向面积，孔洞为负
+     */
+    QVector<QPolygonF> trace(const float *prob, int width, int height, const QRect &roi,
+                             float threshold, double epsilon = 0.5);
+
+    // 鞋带公式的有向面积
+    double signedArea(const QPolygonF &polygon);
+}
@@ -0,0 +1,429 @@
+#include "ModelContainer.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+    // v2 固定头：魔数、版本、块大小、块数、明文总长、标志
+    constexpr int kHeaderSizeV1 = 8;
+    constexpr int kHeaderSizeV2 = 4 + 4 + 4 + 4 + 8 + 4;
+    // 单块上限，防止损坏的头部触发超大分配
+    constexpr quint32 kMaxChunkSize = 256u << 20;
+    constexpr quint32 kMaxMetadataSize = 1u << 20;
+
+    void xorInPlace(char *data, qint64 size, qint64 offset, const QByteArray &key)
+    {
+        const qint64 keyLen = key.size();
+        if (keyLen == 0)
+            return;
+        const char *k = key.constData();
+        qint64 ki = offset % keyLen;
+        for (qint64 i = 0; i < size; ++i)
+        {
+            data[i] ^= k[ki];
+            if (++ki == keyLen)
+                ki = 0;
+        }
+    }
+
+    QByteArray sha256(const char *data, qint64 size)
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(QByteArrayView(data, size));
+        return hash.result();
+    }
+
+    void setError(QString *error, const QString &message)
+    {
+        if (error)
+            *error = message;
+    }
+
+    ModelContainer::Metadata::Quantization parseQuantization(const QJsonObject &owner)
+    {
+        const QJsonObject q = owner.value("quantization").toObject();
+        ModelContainer::Metadata::Quantization result;
+        result.scale = static_cast<float>(q.value("scale").toDouble(0.0));
+        result.zeroPoint = q.value("zero_point").toInt(0);
+        return result;
+    }
+}
+
+namespace ModelContainer
+{
+    QByteArray deriveKey(const QString &passphrase)
+    {
+        return QCryptographicHash::hash(passphrase.toUtf8(), QCryptographicHash::Sha256);
+    }
+
+    bool parseMetadata(const QByteArray &json, Metadata &out, QString *error)
+    {
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+        if (!doc.isObject())
+        {
+            setError(error, QStringLiteral("模型元数据不是合法的 JSON 对象: %1").arg(parseError.errorString()));
+            return false;
+        }
+        const QJsonObject root = doc.object();
+        if (root.value("format").toInt(1) != 1)
+        {
+            setError(error, QStringLiteral("不支持的模型元数据格式: %1").arg(root.value("format").toInt()));
+            return false;
+        }
+
+        Metadata m;
+        const QString task = root.value("task").toString("detect").trimmed().toLower();
+        if (task != "detect" && task != "segment")
+        {
+            setError(error, QStringLiteral("未知的模型任务类型: %1").arg(task));
+            return false;
+        }
+        m.segmentation = (task == "segment");
+
+        // 输入形状 [N, C, H, W]，动态维度写 -1 或省略
+        const QJsonObject input = root.value("input").toObject();
+        m.inputQuantization = parseQuantization(input);
+        const QJsonArray shape = input.value("shape").toArray();
+        if (shape.size() == 4)
+        {
+            m.inputHeight = std::max(0, shape.at(2).toInt());
+            m.inputWidth = std::max(0, shape.at(3).toInt());
+        }
+
+        const QJsonObject output = root.value("output").toObject();
+        const QJsonObject det = output.value("detection").toObject();
+        m.detectionOutput = det.value("name").toString();
+        const QString layout = det.value("layout").toString("auto").trimmed().toLower();
+        if (layout == "attributes_last")
+            m.layout = Metadata::Layout::AttributesLast;
+        else if (layout == "attributes_first")
+            m.layout = Metadata::Layout::AttributesFirst;
+        else if (layout != "auto")
+        {
+            setError(error, QStringLiteral("未知的检测输出布局: %1").arg(layout));
+            return false;
+        }
+        m.objectness = det.value("objectness").toBool(false);
+        m.maskChannels = std::max(0, det.value("mask_channels").toInt(0));
+        if (det.contains("boxes_normalized"))
+            m.boxesNormalized = det.value("boxes_normalized").toBool() ? 1 : 0;
+        m.prototypeOutput = output.value("prototype").toObject().value("name").toString();
+        m.detectionQuantization = parseQuantization(det);
+        m.prototypeQuantization = parseQuantization(output.value("prototype").toObject());
+
+        static const QRegularExpression colorPattern(QStringLiteral("^#[0-9a-fA-F]{6}$"));
+        for (const QJsonValue &v : root.value("classes").toArray())
+        {
+            // 既可写 {"name", "color"} 对象，也可只写名称
+            const QJsonObject cls = v.toObject();
+            const QString name = v.isString() ? v.toString() : cls.value("name").toString();
+            if (name.trimmed().isEmpty())
+            {
+                setError(error, QStringLiteral("第 %1 个类别缺少名称").arg(m.classNames.size()));
+                return false;
+            }
+            m.classNames << name.trimmed();
+            const QString color = cls.value("color").toString();
+            if (!color.isEmpty())
+            {
+                if (!colorPattern.match(color).hasMatch())
+                {
+                    setError(error, QStringLiteral("类别 %1 的颜色格式无效: %2").arg(name, color));
+                    return false;
+                }
+                // 颜色按类别顺序对齐，缺省的由调用方用默认调色板补齐
+                while (m.classColors.size() < m.classNames.size() - 1)
+                    m.classColors << QString();
+                m.classColors << color;
+            }
+        }
+        m.numClasses = det.value("num_classes").toInt(m.classNames.size());
+        if (m.numClasses <= 0 || (!m.classNames.isEmpty() && m.classNames.size() != m.numClasses))
+        {
+            setError(error, QStringLiteral("类别数不一致: num_classes=%1，classes=%2").arg(m.numClasses).arg(m.classNames.size()));
+            return false;
+        }
+        if (m.segmentation && (m.maskChannels <= 0 || m.prototypeOutput.isEmpty()))
+        {
+            setError(error, QStringLiteral("分割模型需要 mask_channels 与 prototype 输出"));
+            return false;
+        }
+
+        const QJsonObject thresholds = root.value("thresholds").toObject();
+        m.confidenceThreshold = static_cast<float>(thresholds.value("confidence").toDouble(-1.0));
+        m.iouThreshold = static_cast<float>(thresholds.value("iou").toDouble(-1.0));
+        if (m.confidenceThreshold > 1.f || m.iouThreshold > 1.f)
+        {
+            setError(error, QStringLiteral("阈值必须位于 0..1"));
+            return false;
+        }
+        m.scoresSigmoided = root.value("scores_sigmoided").toBool(false);
+
+        out = std::move(m);
+        return true;
+    }
+
+    bool write(QIODevice &in, QFileDevice &out, const QByteArray &key, const QByteArray &metadata,
+               quint32 chunkSize, QString *error)
+    {
+        if (key.isEmpty())
+        {
+            setError(error, QStringLiteral("加密密钥为空"));
+            return false;
+        }
+        chunkSize = std::clamp<quint32>(chunkSize, 4096u, kMaxChunkSize);
+        const qint64 plainSize = in.size();
+        if (plainSize <= 0)
+        {
+            setError(error, QStringLiteral("输入模型为空"));
+            return false;
+        }
+        const qint64 chunkCount = (plainSize + chunkSize - 1) / chunkSize;
+        if (quint32(metadata.size()) > kMaxMetadataSize)
+        {
+            setError(error, QStringLiteral("模型元数据过大: %1 字节").arg(metadata.size()));
+            return false;
+        }
+
+        const quint32 flags = metadata.isEmpty() ? 0u : kFlagMetadata;
+        QByteArray header;
+        {
+            QDataStream hs(&header, QIODevice::WriteOnly);
+            hs << kMagic << kVersion2 << chunkSize << quint32(chunkCount) << quint64(plainSize) << flags;
+        }
+        // 哈希表先写占位，数据写完后回填
+        const qint64 tableOffset = header.size();
+        QByteArray table(static_cast<qsizetype>(chunkCount * kHashSize), '\0');
+        if (out.write(header) != header.size() || out.write(table) != table.size())
+        {
+            setError(error, QStringLiteral("写入文件头失败: %1").arg(out.errorString()));
+            return false;
+        }
+        if (flags & kFlagMetadata)
+        {
+            QByteArray block;
+            QDataStream ms(&block, QIODevice::WriteOnly);
+            ms << quint32(metadata.size());
+            block.append(sha256(metadata.constData(), metadata.size()));
+            block.append(metadata);
+            if (out.write(block) != block.size())
+            {
+                setError(error, QStringLiteral("写入模型元数据失败: %1").arg(out.errorString()));
+                return false;
+            }
+        }
+
+        QByteArray buffer(static_cast<qsizetype>(chunkSize), Qt::Uninitialized);
+        qint64 offset = 0;
+        for (qint64 c = 0; c < chunkCount; ++c)
+        {
+            const qint64 want = std::min<qint64>(chunkSize, plainSize - offset);
+            qint64 got = 0;
+            while (got < want)
+            {
+                const qint64 n = in.read(buffer.data() + got, want - got);
+                if (n <= 0)
+                {
+                    setError(error, QStringLiteral("读取模型失败（第 %1 块）: %2").arg(c).arg(in.errorString()));
+                    return false;
+                }
+                got += n;
+            }
+            table.replace(static_cast<qsizetype>(c * kHashSize), kHashSize, sha256(buffer.constData(), want));
+            xorInPlace(buffer.data(), want, offset, key);
+            if (out.write(buffer.constData(), want) != want)
+            {
+                setError(error, QStringLiteral("写入第 %1 块失败: %2").arg(c).arg(out.errorString()));
+                return false;
+            }
+            offset += want;
+        }
+
+        if (!out.seek(tableOffset) || out.write(table) != table.size())
+        {
+            setError(error, QStringLiteral("回填块哈希表失败: %1").arg(out.errorString()));
+            return false;
+        }
+        return out.flush();
+    }
+
+    bool read(const QString &path, const QByteArray &key, QByteArray &out, ReadInfo *info, QString *error)
+    {
+        ReadInfo local;
+        ReadInfo &ri = info ? *info : local;
+        ri = ReadInfo();
+        out.clear();
+
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            setError(error, QStringLiteral("无法打开模型文件: %1，错误: %2").arg(path, file.errorString()));
+            return false;
+        }
+        const qint64 fileSize = file.size();
+        if (fileSize < kHeaderSizeV1)
+        {
+            setError(error, QStringLiteral("模型文件过小或损坏: %1，大小: %2字节").arg(path).arg(fileSize));
+            return false;
+        }
+
+        QDataStream hs(&file);
+        quint32 magic = 0;
+        quint32 version = 0;
+        hs >> magic >> version;
+        if (magic != kMagic)
+        {
+            setError(error, QStringLiteral("模型文件非法或未加密: %1").arg(path));
+            return false;
+        }
+        ri.version = version;
+
+        if ((version >> 16) == (kVersion1 >> 16))
+        {
+            // v1：整段 XOR，无校验
+            out = file.readAll();
+            xorInPlace(out.data(), out.size(), 0, key);
+            ri.chunkCount = 1;
+            ri.fingerprint = sha256(out.constData(), out.size());
+            return true;
+        }
+        if ((version >> 16) != (kVersion2 >> 16))
+        {
+            setError(error, QStringLiteral("不支持的模型容器版本 0x%1: %2").arg(version, 8, 16, QLatin1Char('0')).arg(path));
+            return false;
+        }
+
+        quint32 chunkSize = 0;
+        quint32 chunkCount = 0;
+        quint64 plainSize = 0;
+        quint32 flags = 0;
+        hs >> chunkSize >> chunkCount >> plainSize >> flags;
+        const qint64 tableBytes = qint64(chunkCount) * kHashSize;
+        const auto truncated = [&]()
+        {
+            setError(error, QStringLiteral("模型容器头部损坏或文件被截断: %1（文件 %2 字节）").arg(path).arg(fileSize));
+            return false;
+        };
+        if (hs.status() != QDataStream::Ok || chunkSize == 0 || chunkSize > kMaxChunkSize ||
+            plainSize > quint64(fileSize) || chunkCount != (plainSize + chunkSize - 1) / chunkSize ||
+            fileSize < kHeaderSizeV2 + tableBytes + qint64(plainSize))
+            return truncated();
+        // 空容器不含任何模型数据，也使后续按块数分配线程的 clamp 上界为 0
+        if (plainSize == 0 || chunkCount == 0)
+        {
+            setError(error, QStringLiteral("模型容器不含模型数据: %1").arg(path));
+            return false;
+        }
+        ri.chunkCount = static_cast<int>(chunkCount);
+
+        const QByteArray table = file.read(tableBytes);
+        qint64 metadataBytes = 0;
+        QByteArray metadataDigest;
+        if (flags & kFlagMetadata)
+        {
+            quint32 length = 0;
+            hs >> length;
+            const QByteArray digest = file.read(kHashSize);
+            if (hs.status() != QDataStream::Ok || length > kMaxMetadataSize || digest.size() != kHashSize)
+                return truncated();
+            ri.metadata = file.read(length);
+            if (ri.metadata.size() != qint64(length))
+                return truncated();
+            if (sha256(ri.metadata.constData(), ri.metadata.size()) != digest)
+            {
+                setError(error, QStringLiteral("模型元数据校验失败: %1").arg(path));
+                ri.metadata.clear();
+                return false;
+            }
+            metadataDigest = digest;
+            metadataBytes = 4 + kHashSize + qint64(length);
+        }
+        if (fileSize != kHeaderSizeV2 + tableBytes + metadataBytes + qint64(plainSize))
+            return truncated();
+
+        // 密文直接读入输出缓冲，原地解密，避免第二份整模型拷贝
+        out.resize(static_cast<qsizetype>(plainSize));
+        if (table.size() != tableBytes || file.read(out.data(), out.size()) != out.size())
+        {
+            setError(error, QStringLiteral("读取模型数据失败: %1").arg(file.errorString()));
+            out.clear();
+            return false;
+        }
+        file.close();
+
+        // 各块相互独立：线程从原子计数器领取块号，解密后与哈希表比对
+        std::vector<char> bad(chunkCount, 0);
+        std::atomic<quint32> next{0};
+        auto worker = [&]()
+        {
+            for (quint32 c = next.fetch_add(1); c < chunkCount; c = next.fetch_add(1))
+            {
+                const qint64 offset = qint64(c) * chunkSize;
+                const qint64 size = std::min<qint64>(chunkSize, qint64(plainSize) - offset);
+                char *data = out.data() + offset;
+                xorInPlace(data, size, offset, key);
+                if (sha256(data, size) != QByteArrayView(table.constData() + qint64(c) * kHashSize, kHashSize))
+                    bad[c] = 1;
+            }
+        };
+        ri.threads = std::clamp(QThread::idealThreadCount(), 1, static_cast<int>(chunkCount));
+        if (ri.threads > 1)
+        {
+            QThreadPool pool;
+            pool.setMaxThreadCount(ri.threads - 1);
+            for (int t = 0; t < ri.threads - 1; ++t)
+                pool.start(worker);
+            worker();
+            pool.waitForDone();
+        }
+        else
+        {
+            worker();
+        }
+
+        for (quint32 c = 0; c < chunkCount; ++c)
+        {
+            if (!bad[c])
+                continue;
+            if (ri.badChunk < 0)
+                ri.badChunk = static_cast<int>(c);
+            ++ri.badChunks;
+        }
+        if (ri.badChunk >= 0)
+        {
+            const qint64 begin = qint64(ri.badChunk) * chunkSize;
+            const qint64 end = std::min<qint64>(begin + chunkSize, qint64(plainSize));
+            if (ri.badChunks == ri.chunkCount)
+                setError(error, QStringLiteral("模型全部 %1 个块校验失败，密钥可能不正确: %2").arg(ri.chunkCount).arg(path));
+            else
+                setError(error, QStringLiteral("模型第 %1/%2 块校验失败（明文字节 %3-%4），共 %5 块损坏: %6")
+                                    .arg(ri.badChunk)
+                                    .arg(ri.chunkCount)
+                                    .arg(begin)
+                                    .arg(end - 1)
+                                    .arg(ri.badChunks)
+                                    .arg(path));
+            out.clear();
+            return false;
+        }
+
+        QCryptographicHash fingerprint(QCryptographicHash::Sha256);
+        fingerprint.addData(table);
+        fingerprint.addData(QByteArray::number(plainSize));
+        // 元数据（类别名、输出布局、量化参数）改变推理结果，一并计入
+        fingerprint.addData(metadataDigest);
+        ri.fingerprint = fingerprint.result();
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+class QIODevice;
+class QFileDevice;
+
+/**
+ * @brief 加密模型容器格式（encrypt_model 工具与 InferenceEngine 共用）
+ * @details v1：8 字节头（"MYOL" 魔数 + 版本）后接整段 XOR 加密数据。
+ *          v2：固定大小分块，每块带明文 SHA-256，布局为
+ *              [魔数][版本][块大小][块数][明文总长 u64][标志]
+ *              [块数 x 32 字节哈希][元数据段（可选）][按序存放的加密块]
+ *          元数据段（标志位 kFlagMetadata）为 [长度 u32][SHA-256][UTF-8 JSON]，明文存放，
+ *          描述输入形状、输出布局、类别与默认阈值，推理引擎据此一次性确定解码方式。
+ *          XOR 密钥流按明文全局偏移取值，与 v1 的加密结果逐字节一致。
+ *          所有整数为大端（QDataStream 默认）。
+ */
+namespace ModelContainer
+{
+    constexpr quint32 kMagic = 0x4D594F4C; // "MYOL"
+    constexpr quint32 kVersion1 = 0x00010000;
+    constexpr quint32 kVersion2 = 0x00020000;
+    constexpr quint32 kDefaultChunkSize = 4u << 20;
+    constexpr int kHashSize = 32;
+    constexpr quint32 kFlagMetadata = 0x1;
+
+    /**
+     * @brief 模型自描述元数据（JSON 解析结果）
+     * @details 示例：
+     *   {"format": 1, "task": "segment",
+     *    "input": {"shape": [1, 3, 640, 640]},
+     *    "output": {"detection": {"name": "output0", "layout": "attributes_first",
+     *                             "objectness": false, "num_classes": 8, "mask_channels": 32,
+     *                             "boxes_normalized": false},
+     *               "prototype": {"name": "output1"}},
+     *    "classes": [{"name": "Gluteus Maximus", "color": "#fc5a8d"}, ...],
+     *    "thresholds": {"confidence": 0.25, "iou": 0.45},
+     *    "scores_sigmoided": true}
+     *   8 位整型输入/输出需给出量化参数，例如
+     *   "input": {"shape": [...], "quantization": {"scale": 0.003921569, "zero_point": 0}}，
+     *   检测与原型输出同理（写在 detection / prototype 对象中）。
+     */
+    struct Metadata
+    {
+        // 线性量化：real = (q - zeroPoint) * scale
+        struct Quantization
+        {
+            float scale{0.f};
+            int zeroPoint{0};
+            bool isValid() const { return scale > 0.f; }
+        };
+
+        enum class Layout
+        {
+            Auto,            // 按输出形状判断
+            AttributesLast,  // [1, N, C]
+            AttributesFirst  // [1, C, N]
+        };
+
+        bool segmentation{false};
+        int inputWidth{0};
+        int inputHeight{0};
+        QString detectionOutput;  // 为空时按形状查找
+        QString prototypeOutput;  // 分割原型输出，为空表示无
+        Layout layout{Layout::Auto};
+        bool objectness{false};
+        int numClasses{0};
+        int maskChannels{0};
+        int boxesNormalized{-1};  // -1 逐框判断，0 像素坐标，1 归一化坐标
+        QStringList classNames;
+        QStringList classColors;  // "#rrggbb"，可少于类别数
+        float confidenceThreshold{-1.f}; // < 0 表示未指定
+        float iouThreshold{-1.f};
+        bool scoresSigmoided{false};
+        Quantization inputQuantization;
+        Quantization detectionQuantization;
+        Quantization prototypeQuantization;
+
+        // 检测输出每个候选框的属性数：4 个框坐标 + 目标度 + 类别 + 掩码系数
+        int attributeCount() const { return 4 + (objectness ? 1 : 0) + numClasses + maskChannels; }
+    };
+
+    // 解析并校验元数据 JSON
+    bool parseMetadata(const QByteArray &json, Metadata &out, QString *error = nullptr);
+
+    struct ReadInfo
+    {
+        quint32 version{0};
+        int chunkCount{0};
+        int badChunk{-1};   // 第一个校验失败的块，-1 表示无
+        int badChunks{0};   // 校验失败的块数
+        int threads{1};     // 解密校验使用的线程数
+        QByteArray metadata; // 元数据 JSON，容器未携带时为空
+        QByteArray fingerprint; // 模型内容指纹（SHA-256）：v2 由块哈希表与元数据摘要派生，无需再次哈希整模型
+    };
+
+    // 由口令派生 32 字节 XOR 密钥
+    QByteArray deriveKey(const QString &passphrase);
+
+    /**
+     * @brief 流式写出 v2 容器，内存占用与模型大小无关（一个块 + 哈希表）
+     * @param in 明文模型（顺序读取）
+     * @param out 输出文件，需要可回写（先写占位哈希表，写完数据后回填）
+     * @param metadata 元数据 JSON，为空时不写元数据段
+     */
+    bool write(QIODevice &in, QFileDevice &out, const QByteArray &key, const QByteArray &metadata = {},
+               quint32 chunkSize = kDefaultChunkSize, QString *error = nullptr);
+
+    /**
+     * @brief 读取 v1 / v2 容器并解密；v2 各块在多个线程上并行解密和校验
+     * @param out 明文模型数据
+     * @param info 版本、块数与校验失败的块（可选）
+     * @return 文件非法、版本不支持或有块校验失败时返回 false，error 给出原因与块号
+     */
+    bool read(const QString &path, const QByteArray &key, QByteArray &out,
+              ReadInfo *info = nullptr, QString *error = nullptr);
+}
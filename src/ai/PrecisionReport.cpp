@@ -0,0 +1,270 @@
+#include "PrecisionReport.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr float kMatchIou = 0.5f;
+
+    float boxIou(const InferenceEngine::Detection &a, const InferenceEngine::Detection &b)
+    {
+        const float ix = std::max(0.f, std::min(a.x2, b.x2) - std::max(a.x1, b.x1));
+        const float iy = std::max(0.f, std::min(a.y2, b.y2) - std::max(a.y1, b.y1));
+        const float inter = ix * iy;
+        const float areaA = std::max(0.f, a.x2 - a.x1) * std::max(0.f, a.y2 - a.y1);
+        const float areaB = std::max(0.f, b.x2 - b.x1) * std::max(0.f, b.y2 - b.y1);
+        const float uni = areaA + areaB - inter;
+        return uni > 0.f ? inter / uni : 0.f;
+    }
+
+    struct ImageStats
+    {
+        int matched{0};
+        int classAgreements{0};
+        double iouSum{0.0};
+        double scoreDeltaSum{0.0};
+        double maxScoreDelta{0.0};
+    };
+
+    // 类别无关的贪心匹配：所有候选对按 IoU 从高到低，每个框最多匹配一次
+    ImageStats matchDetections(const std::vector<InferenceEngine::Detection> &ref,
+                               const std::vector<InferenceEngine::Detection> &var)
+    {
+        struct Pair
+        {
+            float iou;
+            size_t r;
+            size_t v;
+        };
+        std::vector<Pair> pairs;
+        for (size_t r = 0; r < ref.size(); ++r)
+        {
+            for (size_t v = 0; v < var.size(); ++v)
+            {
+                const float iou = boxIou(ref[r], var[v]);
+                if (iou >= kMatchIou)
+                    pairs.push_back({iou, r, v});
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b)
+                  { return a.iou > b.iou; });
+
+        ImageStats stats;
+        std::vector<char> refUsed(ref.size(), 0), varUsed(var.size(), 0);
+        for (const Pair &p : pairs)
+        {
+            if (refUsed[p.r] || varUsed[p.v])
+                continue;
+            refUsed[p.r] = varUsed[p.v] = 1;
+            ++stats.matched;
+            if (ref[p.r].cls == var[p.v].cls)
+                ++stats.classAgreements;
+            stats.iouSum += p.iou;
+            const double delta = std::abs(static_cast<double>(ref[p.r].score) - var[p.v].score);
+            stats.scoreDeltaSum += delta;
+            stats.maxScoreDelta = std::max(stats.maxScoreDelta, delta);
+        }
+        return stats;
+    }
+
+    // 标签图逐像素累计各类别的交集与并集（像素值为类别 + 1）
+    void accumulateMaskIou(const QImage &ref, const QImage &var,
+                           std::array<qint64, 256> &inter, std::array<qint64, 256> &uni)
+    {
+        if (ref.isNull() || var.isNull() || ref.size() != var.size() ||
+            ref.format() != QImage::Format_Indexed8 || var.format() != QImage::Format_Indexed8)
+            return;
+        for (int y = 0; y < ref.height(); ++y)
+        {
+            const uchar *a = ref.constScanLine(y);
+            const uchar *b = var.constScanLine(y);
+            for (int x = 0; x < ref.width(); ++x)
+            {
+                if (a[x] == b[x])
+                {
+                    if (a[x])
+                    {
+                        ++inter[a[x]];
+                        ++uni[a[x]];
+                    }
+                    continue;
+                }
+                if (a[x])
+                    ++uni[a[x]];
+                if (b[x])
+                    ++uni[b[x]];
+            }
+        }
+    }
+}
+
+namespace PrecisionReport
+{
+    QString Summary::toText() const
+    {
+        QString text = QStringLiteral("%1 images: recall %2%, precision %3%, class agreement %4%, box IoU %5, |Δscore| %6 (max %7)")
+                           .arg(images)
+                           .arg(recall * 100.0, 0, 'f', 1)
+                           .arg(precision * 100.0, 0, 'f', 1)
+                           .arg(matched > 0 ? 100.0 * classAgreements / matched : 0.0, 0, 'f', 1)
+                           .arg(meanBoxIou, 0, 'f', 3)
+                           .arg(meanScoreDelta, 0, 'f', 3)
+                           .arg(maxScoreDelta, 0, 'f', 3);
+        if (meanMaskIou >= 0.0)
+            text += QStringLiteral(", mask IoU %1").arg(meanMaskIou, 0, 'f', 3);
+        text += QStringLiteral(", %1 ms vs %2 ms FP32").arg(variantMs, 0, 'f', 1).arg(referenceMs, 0, 'f', 1);
+        if (variantMs > 0.0)
+            text += QStringLiteral(" (%1x)").arg(referenceMs / variantMs, 0, 'f', 2);
+        return text;
+    }
+
+    bool run(const InferenceEngine &reference, const InferenceEngine &variant,
+             const QStringList &images, InferenceEngine::Task task, const ImageLoader &loader,
+             const QString &reportPath, Summary &summary, const std::atomic_bool *cancel, QString *error)
+    {
+        summary = Summary();
+        if (!reference.isLoaded() || !variant.isLoaded())
+        {
+            summary.error = QStringLiteral("参照模型或变体模型未加载");
+            if (error)
+                *error = summary.error;
+            return false;
+        }
+
+        const bool segmentation = (task == InferenceEngine::Task::HipMRI_Seg);
+        std::array<qint64, 256> maskInter{}, maskUnion{};
+        double referenceNs = 0.0, variantNs = 0.0;
+        double iouSum = 0.0, scoreDeltaSum = 0.0;
+        QJsonArray perImage;
+
+        for (const QString &path : images)
+        {
+            if (cancel && cancel->load())
+            {
+                summary.cancelled = true;
+                break;
+            }
+            QImage image;
+            if (!loader(path, image) || image.isNull())
+            {
+                ++summary.failed;
+                continue;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            const InferenceEngine::Result ref = reference.run(image, task, false);
+            referenceNs += timer.nsecsElapsed();
+            timer.restart();
+            const InferenceEngine::Result var = variant.run(image, task, false);
+            variantNs += timer.nsecsElapsed();
+
+            const ImageStats stats = matchDetections(ref.dets, var.dets);
+            summary.referenceDetections += static_cast<int>(ref.dets.size());
+            summary.variantDetections += static_cast<int>(var.dets.size());
+            summary.matched += stats.matched;
+            summary.classAgreements += stats.classAgreements;
+            summary.maxScoreDelta = std::max(summary.maxScoreDelta, stats.maxScoreDelta);
+            iouSum += stats.iouSum;
+            scoreDeltaSum += stats.scoreDeltaSum;
+            if (segmentation)
+                accumulateMaskIou(ref.segmentationMask, var.segmentationMask, maskInter, maskUnion);
+            ++summary.images;
+
+            QJsonObject entry;
+            entry["path"] = path;
+            entry["reference_detections"] = static_cast<int>(ref.dets.size());
+            entry["variant_detections"] = static_cast<int>(var.dets.size());
+            entry["matched"] = stats.matched;
+            entry["class_agreements"] = stats.classAgreements;
+            entry["mean_box_iou"] = stats.matched > 0 ? stats.iouSum / stats.matched : 0.0;
+            entry["max_score_delta"] = stats.maxScoreDelta;
+            perImage.append(entry);
+        }
+
+        if (summary.referenceDetections > 0)
+            summary.recall = static_cast<double>(summary.matched) / summary.referenceDetections;
+        if (summary.variantDetections > 0)
+            summary.precision = static_cast<double>(summary.matched) / summary.variantDetections;
+        if (summary.matched > 0)
+        {
+            summary.meanBoxIou = iouSum / summary.matched;
+            summary.meanScoreDelta = scoreDeltaSum / summary.matched;
+        }
+        if (summary.images > 0)
+        {
+            summary.referenceMs = referenceNs / 1e6 / summary.images;
+            summary.variantMs = variantNs / 1e6 / summary.images;
+        }
+
+        QJsonArray maskClasses;
+        if (segmentation)
+        {
+            double iouTotal = 0.0;
+            int classes = 0;
+            for (int label = 1; label < 256; ++label)
+            {
+                if (maskUnion[label] == 0)
+                    continue;
+                const double iou = static_cast<double>(maskInter[label]) / maskUnion[label];
+                iouTotal += iou;
+                ++classes;
+                QJsonObject c;
+                c["class_id"] = label - 1;
+                c["class_name"] = InferenceEngine::segmentationClassName(label - 1);
+                c["iou"] = iou;
+                maskClasses.append(c);
+            }
+            if (classes > 0)
+                summary.meanMaskIou = iouTotal / classes;
+        }
+
+        QJsonObject totals;
+        totals["images"] = summary.images;
+        totals["failed"] = summary.failed;
+        totals["reference_detections"] = summary.referenceDetections;
+        totals["variant_detections"] = summary.variantDetections;
+        totals["matched"] = summary.matched;
+        totals["class_agreements"] = summary.classAgreements;
+        totals["recall"] = summary.recall;
+        totals["precision"] = summary.precision;
+        totals["mean_box_iou"] = summary.meanBoxIou;
+        totals["mean_score_delta"] = summary.meanScoreDelta;
+        totals["max_score_delta"] = summary.maxScoreDelta;
+        if (segmentation)
+        {
+            totals["mean_mask_iou"] = summary.meanMaskIou;
+            totals["mask_iou_per_class"] = maskClasses;
+        }
+        totals["reference_ms"] = summary.referenceMs;
+        totals["variant_ms"] = summary.variantMs;
+        totals["cancelled"] = summary.cancelled;
+
+        QJsonObject root;
+        root["generated"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+        root["match_iou"] = kMatchIou;
+        root["reference_precision"] = reference.inputPrecision();
+        root["variant_precision"] = variant.inputPrecision();
+        root["summary"] = totals;
+        root["images"] = perImage;
+
+        QSaveFile file(reportPath);
+        if (!file.open(QIODevice::WriteOnly) ||
+            file.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) < 0 || !file.commit())
+        {
+            summary.error = QStringLiteral("无法写出精度报告 %1: %2").arg(reportPath, file.errorString());
+            if (error)
+                *error = summary.error;
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+
+#include "InferenceEngine.h"
+
+/**
+ * @brief 量化 / 半精度模型相对 FP32 模型的精度差异报告
+ * @details 两个模型在同一批本地验证图像上推理，以 FP32 结果为参照：
+ *          检测框按类别无关的 IoU 贪心匹配（IoU >= 0.5），统计召回率、精确率、类别一致率、
+ *          匹配框平均 IoU 与置信度偏差；分割模型另按类别累计标签图的掩码 IoU。
+ *          同时记录两个模型的单图平均耗时，报告写为 JSON。
+ */
+namespace PrecisionReport
+{
+    struct Summary
+    {
+        int images{0};               // 成功比较的图像数
+        int failed{0};               // 加载失败的图像数
+        int referenceDetections{0};  // FP32 检测框总数
+        int variantDetections{0};    // 变体检测框总数
+        int matched{0};              // IoU >= 0.5 的匹配对数
+        int classAgreements{0};      // 匹配对中类别一致的数量
+        double recall{0.0};          // matched / referenceDetections
+        double precision{0.0};       // matched / variantDetections
+        double meanBoxIou{0.0};
+        double meanScoreDelta{0.0};  // 匹配对 |score 差| 均值
+        double maxScoreDelta{0.0};
+        double meanMaskIou{-1.0};    // 各类别掩码 IoU 的均值，非分割模型为 -1
+        double referenceMs{0.0};     // 单图平均推理耗时
+        double variantMs{0.0};
+        bool cancelled{false};
+        QString error;               // 非空表示报告未生成
+
+        // 单行摘要，用于日志与提示框
+        QString toText() const;
+    };
+
+    using ImageLoader = std::function<bool(const QString &path, QImage &out)>;
+
+    /**
+     * @brief 逐图比较两个模型并写出 JSON 报告
+     * @param reference FP32 参照模型
+     * @param variant 待评估的 FP16 / INT8 模型
+     * @param loader 图像加载函数（在调用线程执行）
+     * @param reportPath 报告输出路径
+     * @param cancel 非空时每幅图像前检查，置位后提前结束（已比较部分照常写出）
+     * @return 报告写出成功时返回 true
+     */
+    bool run(const InferenceEngine &reference, const InferenceEngine &variant,
+             const QStringList &images, InferenceEngine::Task task, const ImageLoader &loader,
+             const QString &reportPath, Summary &summary,
+             const std::atomic_bool *cancel = nullptr, QString *error = nullptr);
+}
@@ -0,0 +1,475 @@
+#include "ResultCache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <algorithm>
+#include <vector>
+#include "core/AppConfig.h"
+#include "core/ErrorHandler.h"
+
+namespace
+{
+    constexpr quint32 kFileMagic = 0x4D524331;   // "MRC1"
+    constexpr quint32 kFileVersion = 1;
+    constexpr quint32 kRecordMagic = 0x52454331; // "REC1"
+    constexpr qint64 kFileHeaderSize = 8;
+    constexpr int kKeySize = 32;
+    constexpr qint64 kRecordHeaderSize = 4 + kKeySize + 4 + 2 + 2;
+    constexpr quint32 kMaxDetections = 100000;
+
+    QString defaultDirectory()
+    {
+        return QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation))
+            .filePath(QStringLiteral("result_cache"));
+    }
+
+    bool isGray8(const QImage &image)
+    {
+        if (image.format() == QImage::Format_Grayscale8)
+            return true;
+        if (image.format() != QImage::Format_Indexed8 || image.colorCount() != 256)
+            return false;
+        const QVector<QRgb> colors = image.colorTable();
+        for (int i = 0; i < 256; ++i)
+        {
+            if (colors[i] != qRgb(i, i, i))
+                return false;
+        }
+        return true;
+    }
+}
+
+ResultCache &ResultCache::instance()
+{
+    static ResultCache cache;
+    return cache;
+}
+
+ResultCache::~ResultCache()
+{
+    QMutexLocker lock(&m_mutex);
+    closeLocked();
+}
+
+QByteArray ResultCache::contentHash(const QImage &image)
+{
+    if (image.isNull())
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray header;
+    QDataStream ds(&header, QIODevice::WriteOnly);
+    const bool gray = isGray8(image);
+    ds << qint32(image.width()) << qint32(image.height()) << qint32(gray ? QImage::Format_Grayscale8 : image.format());
+    hash.addData(header);
+    const QVector<QRgb> colors = gray ? QVector<QRgb>() : image.colorTable();
+    if (!colors.isEmpty())
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(colors.constData()), colors.size() * qsizetype(sizeof(QRgb))));
+    const qsizetype rowBytes = (qsizetype(image.width()) * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y)
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(image.constScanLine(y)), rowBytes));
+    return hash.result();
+}
+
+QByteArray ResultCache::contentHash(const InferenceEngine::PixelView &pixels, QImage *windowed)
+{
+    // 网络只看到取窗后的 8 位灰度，按它哈希与显示图路径一致
+    const QImage image = InferenceEngine::windowedImage(pixels);
+    if (windowed)
+        *windowed = image;
+    return contentHash(image);
+}
+
+bool ResultCache::lookup(const QByteArray &keyContext, const QImage &input, InferenceEngine::Result &out)
+{
+    if (keyContext.isEmpty() || !AppConfig::instance().current()->resultCacheEnabled)
+        return false;
+    const QByteArray key = InferenceEngine::combineResultKey(keyContext, contentHash(input));
+    return !key.isEmpty() && find(key, out);
+}
+
+InferenceEngine::Result ResultCache::run(const InferenceEngine &engine, const QImage &input, InferenceEngine::Task task,
+                                         bool renderOutput, bool *hit)
+{
+    QByteArray key;
+    if (AppConfig::instance().current()->resultCacheEnabled)
+        key = engine.resultKey(contentHash(input), task);
+
+    InferenceEngine::Result result;
+    const bool found = !key.isEmpty() && find(key, result);
+    if (hit)
+        *hit = found;
+    if (found)
+    {
+        if (renderOutput)
+        {
+            const bool segmentation = (task == InferenceEngine::Task::HipMRI_Seg) && engine.isSegmentationModel();
+            result.outputImage = InferenceEngine::renderResult(input, result, segmentation);
+        }
+        return result;
+    }
+
+    result = engine.run(input, task, renderOutput);
+    if (!key.isEmpty() && result.valid)
+        store(key, result);
+    return result;
+}
+
+InferenceEngine::Result ResultCache::run(const InferenceEngine &engine, const InferenceEngine::PixelView &pixels,
+                                         InferenceEngine::Task task, bool *hit, QImage *windowed)
+{
+    QByteArray key;
+    if (AppConfig::instance().current()->resultCacheEnabled)
+        key = engine.resultKey(contentHash(pixels, windowed), task);
+
+    InferenceEngine::Result result;
+    const bool found = !key.isEmpty() && find(key, result);
+    if (hit)
+        *hit = found;
+    if (found)
+        return result;
+
+    result = engine.run(pixels, task);
+    if (!key.isEmpty() && result.valid)
+        store(key, result);
+    return result;
+}
+
+ResultCache::Stats ResultCache::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    Stats s;
+    s.hits = m_hits.load();
+    s.misses = m_misses.load();
+    s.entries = m_index.size();
+    s.bytes = m_size;
+    return s;
+}
+
+bool ResultCache::ensureOpenLocked()
+{
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    if (!config->resultCacheEnabled)
+    {
+        if (!m_directory.isEmpty())
+            closeLocked();
+        return false;
+    }
+    m_maxSize = qint64(config->resultCacheMaxSizeMB) * 1024 * 1024;
+    const QString directory = config->resultCacheDirectory.isEmpty() ? defaultDirectory() : config->resultCacheDirectory;
+    if (directory == m_directory)
+        return m_file.isOpen();
+
+    // 打开失败时也记下目录，避免每次查询都重试
+    closeLocked();
+    m_directory = directory;
+    return openLocked(directory);
+}
+
+bool ResultCache::openLocked(const QString &directory)
+{
+    QDir().mkpath(directory);
+    m_file.setFileName(QDir(directory).filePath(QStringLiteral("results.bin")));
+    if (!m_file.open(QIODevice::ReadWrite))
+    {
+        LOG_WARNING(QStringLiteral("无法打开结果缓存 %1: %2").arg(m_file.fileName(), m_file.errorString()), "ResultCache", 5033);
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    bool reset = fileSize < kFileHeaderSize;
+    if (!reset)
+    {
+        const QByteArray header = m_file.read(kFileHeaderSize);
+        reset = header.size() != kFileHeaderSize ||
+                qFromBigEndian<quint32>(header.constData()) != kFileMagic ||
+                qFromBigEndian<quint32>(header.constData() + 4) != kFileVersion;
+        if (reset)
+            LOG_WARNING(QStringLiteral("结果缓存格式不兼容，已清空: %1").arg(m_file.fileName()), "ResultCache", 5033);
+    }
+    if (reset)
+    {
+        QByteArray header(kFileHeaderSize, '\0');
+        qToBigEndian(kFileMagic, header.data());
+        qToBigEndian(kFileVersion, header.data() + 4);
+        if (!m_file.resize(0) || !m_file.seek(0) || m_file.write(header) != header.size())
+        {
+            LOG_WARNING(QStringLiteral("无法初始化结果缓存: %1").arg(m_file.errorString()), "ResultCache", 5033);
+            m_file.close();
+            return false;
+        }
+        m_file.flush();
+        m_size = kFileHeaderSize;
+        return true;
+    }
+
+    // 扫描记录头建立索引；末尾不完整的记录（写入中途退出）截掉
+    m_size = fileSize;
+    if (!remapLocked())
+    {
+        m_file.close();
+        return false;
+    }
+    qint64 offset = kFileHeaderSize;
+    while (offset + kRecordHeaderSize <= m_size)
+    {
+        const uchar *p = m_map + offset;
+        const quint32 size = qFromBigEndian<quint32>(p + 4 + kKeySize);
+        if (qFromBigEndian<quint32>(p) != kRecordMagic || offset + kRecordHeaderSize + size > m_size)
+            break;
+        Entry entry;
+        entry.offset = offset + kRecordHeaderSize;
+        entry.size = size;
+        entry.crc = qFromBigEndian<quint16>(p + 4 + kKeySize + 4);
+        m_index.insert(QByteArray(reinterpret_cast<const char *>(p + 4), kKeySize), entry);
+        offset = entry.offset + size;
+    }
+    if (offset != m_size)
+    {
+        LOG_WARNING(QStringLiteral("结果缓存末尾有 %1 字节不完整记录，已截断").arg(m_size - offset), "ResultCache", 5033);
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mapSize = 0;
+        m_file.resize(offset);
+        m_size = offset;
+        remapLocked();
+    }
+    LOG_DEBUG(QStringLiteral("结果缓存: %1 条记录, %2 KB").arg(m_index.size()).arg(m_size / 1024), "ResultCache");
+    return true;
+}
+
+void ResultCache::closeLocked()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_size = 0;
+    m_index.clear();
+    if (m_file.isOpen())
+        m_file.close();
+    m_directory.clear();
+}
+
+bool ResultCache::remapLocked()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_mapSize = 0;
+    if (m_size <= 0)
+        return true;
+    m_map = m_file.map(0, m_size);
+    if (!m_map)
+    {
+        LOG_WARNING(QStringLiteral("结果缓存内存映射失败: %1").arg(m_file.errorString()), "ResultCache", 5033);
+        return false;
+    }
+    m_mapSize = m_size;
+    return true;
+}
+
+bool ResultCache::find(const QByteArray &key, InferenceEngine::Result &out)
+{
+    QByteArray payload;
+    Entry entry;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!ensureOpenLocked())
+            return false;
+        const auto it = m_index.constFind(key);
+        if (it == m_index.constEnd())
+        {
+            ++m_misses;
+            return false;
+        }
+        entry = it.value();
+        // 打开后追加的记录不在当前映射内，按需扩大映射
+        if (entry.offset + entry.size > m_mapSize && !remapLocked())
+            return false;
+        payload = QByteArray(reinterpret_cast<const char *>(m_map + entry.offset), entry.size);
+    }
+
+    if (qChecksum(payload) != entry.crc || !deserialize(payload, out))
+    {
+        LOG_WARNING(QStringLiteral("结果缓存记录损坏，重新推理"), "ResultCache", 5034);
+        ++m_misses;
+        return false;
+    }
+    ++m_hits;
+    return true;
+}
+
+void ResultCache::store(const QByteArray &key, const InferenceEngine::Result &result)
+{
+    if (key.size() != kKeySize)
+        return;
+    const QByteArray payload = serialize(result);
+
+    QMutexLocker lock(&m_mutex);
+    if (!ensureOpenLocked() || m_index.contains(key))
+        return;
+    const qint64 recordSize = kRecordHeaderSize + payload.size();
+    if (m_maxSize > 0 && m_size + recordSize > m_maxSize)
+    {
+        // 达到上限：丢弃最早写入的记录，保留最新的一半
+        if (kFileHeaderSize + recordSize > m_maxSize / 2 || !compactLocked(m_maxSize / 2))
+            return;
+    }
+
+    Entry entry;
+    entry.offset = m_size + kRecordHeaderSize;
+    entry.size = static_cast<quint32>(payload.size());
+    entry.crc = qChecksum(payload);
+    QByteArray header(kRecordHeaderSize, '\0');
+    qToBigEndian(kRecordMagic, header.data());
+    std::copy(key.constBegin(), key.constEnd(), header.begin() + 4);
+    qToBigEndian(entry.size, header.data() + 4 + kKeySize);
+    qToBigEndian(entry.crc, header.data() + 4 + kKeySize + 4);
+
+    if (!m_file.seek(m_size) || m_file.write(header) != header.size() || m_file.write(payload) != payload.size())
+    {
+        LOG_WARNING(QStringLiteral("写入结果缓存失败: %1").arg(m_file.errorString()), "ResultCache", 5034);
+        return;
+    }
+    m_file.flush();
+    m_index.insert(key, entry);
+    m_size += recordSize;
+}
+
+bool ResultCache::compactLocked(qint64 target)
+{
+    if (m_mapSize < m_size && !remapLocked())
+        return false;
+
+    // 记录按写入顺序排列，偏移越大越新
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<size_t>(m_index.size()));
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it)
+        entries.push_back(it.value());
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.offset > b.offset; });
+    qint64 kept = kFileHeaderSize;
+    size_t keep = 0;
+    for (; keep < entries.size(); ++keep)
+    {
+        const qint64 recordSize = kRecordHeaderSize + entries[keep].size;
+        if (kept + recordSize > target)
+            break;
+        kept += recordSize;
+    }
+
+    const QString path = m_file.fileName();
+    const QString tempPath = path + QStringLiteral(".tmp");
+    QFile out(tempPath);
+    bool ok = out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (ok)
+    {
+        QByteArray header(kFileHeaderSize, '\0');
+        qToBigEndian(kFileMagic, header.data());
+        qToBigEndian(kFileVersion, header.data() + 4);
+        ok = out.write(header) == header.size();
+        for (size_t i = keep; ok && i-- > 0;)
+        {
+            const qint64 begin = entries[i].offset - kRecordHeaderSize;
+            const qint64 length = kRecordHeaderSize + entries[i].size;
+            ok = out.write(reinterpret_cast<const char *>(m_map + begin), length) == length;
+        }
+        ok = out.flush() && ok;
+        out.close();
+    }
+    if (!ok)
+    {
+        LOG_WARNING(QStringLiteral("结果缓存压缩失败: %1").arg(out.errorString()), "ResultCache", 5034);
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    const QString directory = m_directory;
+    const int dropped = m_index.size() - static_cast<int>(keep);
+    closeLocked();
+    m_directory = directory;
+    if (!QFile::remove(path) || !QFile::rename(tempPath, path))
+    {
+        LOG_WARNING(QStringLiteral("无法替换结果缓存文件: %1").arg(path), "ResultCache", 5034);
+        return false;
+    }
+    if (!openLocked(directory))
+        return false;
+    LOG_INFO(QStringLiteral("结果缓存达到上限，丢弃最早的 %1 条记录，保留 %2 KB").arg(dropped).arg(m_size / 1024), "ResultCache");
+    return true;
+}
+
+QByteArray ResultCache::serialize(const InferenceEngine::Result &result)
+{
+    QByteArray payload;
+    QDataStream ds(&payload, QIODevice::WriteOnly);
+    ds.setVersion(QDataStream::Qt_6_0);
+    // 坐标与面积按单精度存放，足够还原像素级结果
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    ds << result.summary << quint32(result.dets.size());
+    for (const InferenceEngine::Detection &d : result.dets)
+    {
+        ds << d.x1 << d.y1 << d.x2 << d.y2 << d.score << qint32(d.cls)
+           << d.maskAreaPixels << d.maskAreaMm2 << d.hasMask << d.contours << d.contourAreaPixels;
+    }
+
+    // 标签图逐行紧排后压缩（背景占大部分，压缩率高）
+    const QImage &mask = result.segmentationMask;
+    const bool hasMask = !mask.isNull() && mask.format() == QImage::Format_Indexed8;
+    ds << hasMask;
+    if (hasMask)
+    {
+        QByteArray packed;
+        packed.reserve(qsizetype(mask.width()) * mask.height());
+        for (int y = 0; y < mask.height(); ++y)
+            packed.append(reinterpret_cast<const char *>(mask.constScanLine(y)), mask.width());
+        ds << qint32(mask.width()) << qint32(mask.height()) << qCompress(packed, 1);
+    }
+    return payload;
+}
+
+bool ResultCache::deserialize(const QByteArray &payload, InferenceEngine::Result &out)
+{
+    QDataStream ds(payload);
+    ds.setVersion(QDataStream::Qt_6_0);
+    ds.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    InferenceEngine::Result result;
+    quint32 count = 0;
+    ds >> result.summary >> count;
+    if (ds.status() != QDataStream::Ok || count > kMaxDetections)
+        return false;
+    result.dets.resize(count);
+    for (InferenceEngine::Detection &d : result.dets)
+    {
+        qint32 cls = 0;
+        ds >> d.x1 >> d.y1 >> d.x2 >> d.y2 >> d.score >> cls
+            >> d.maskAreaPixels >> d.maskAreaMm2 >> d.hasMask >> d.contours >> d.contourAreaPixels;
+        d.cls = cls;
+    }
+
+    bool hasMask = false;
+    ds >> hasMask;
+    if (hasMask)
+    {
+        qint32 width = 0, height = 0;
+        QByteArray compressed;
+        ds >> width >> height >> compressed;
+        const QByteArray packed = qUncompress(compressed);
+        if (width <= 0 || height <= 0 || packed.size() != qsizetype(width) * height)
+            return false;
+        QImage mask(width, height, QImage::Format_Indexed8);
+        mask.setColorTable(InferenceEngine::segmentationColorTable());
+        for (int y = 0; y < height; ++y)
+            std::copy_n(packed.constData() + qsizetype(y) * width, width, reinterpret_cast<char *>(mask.scanLine(y)));
+        result.segmentationMask = std::move(mask);
+    }
+    if (ds.status() != QDataStream::Ok)
+        return false;
+
+    result.valid = true;
+    out = std::move(result);
+    return true;
+}
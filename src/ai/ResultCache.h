@@ -0,0 +1,95 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+
+#include "InferenceEngine.h"
+
+/**
+ * @brief 跨会话的推理结果缓存（内容寻址，单文件追加存储）
+ * @details 键由 InferenceEngine::resultKey 给出：输入像素内容哈希 + 模型指纹 + 生效阈值与推理模式 + 引擎版本，
+ *          与文件路径无关，内容相同的图像只存一份。值为紧凑序列化的检测框、轮廓与压缩后的标签图
+ *          （不含结果图，命中后按需重绘）。
+ *          文件布局：[魔数][版本] 后接若干记录 [魔数][键 32 字节][长度 u32][CRC-16][保留 u16][数据]，
+ *          打开时内存映射并扫描记录头建立索引，查找只做一次哈希表查询与一次映射区拷贝；
+ *          末尾写了一半的记录在下次打开时截掉。达到容量上限时丢弃最早写入的记录，只保留最新的一半重写文件。
+ *          所有整数为大端。可在多个线程中并发使用。
+ */
+class ResultCache
+{
+public:
+    struct Stats
+    {
+        qint64 hits{0};
+        qint64 misses{0};
+        int entries{0};
+        qint64 bytes{0};
+    };
+
+    static ResultCache &instance();
+    ~ResultCache();
+
+    // 输入内容哈希（SHA-256）：尺寸、格式与有效像素字节，不含行尾填充。
+    // 8 位灰度（Grayscale8 或灰阶调色板的 Indexed8）统一按规范形式哈希；原始像素视图先按窗宽窗位
+    // 转为送入网络的 8 位灰度再哈希，DICOM 无论经显示图还是原始像素推理都得到同一个键
+    static QByteArray contentHash(const QImage &image);
+    static QByteArray contentHash(const InferenceEngine::PixelView &pixels, QImage *windowed = nullptr);
+
+    /**
+     * @brief 只查缓存，不推理（导航时使用）
+     * @param keyContext InferenceEngine::resultKeyContext 的返回值；不访问引擎，可在工作线程调用
+     * @return 命中时返回 true，out 不含结果图
+     */
+    bool lookup(const QByteArray &keyContext, const QImage &input, InferenceEngine::Result &out);
+
+    /**
+     * @brief 先查缓存，未命中时调用 engine.run 并写入缓存
+     * @param hit 可选，返回是否命中
+     */
+    InferenceEngine::Result run(const InferenceEngine &engine, const QImage &input, InferenceEngine::Task task,
+                                bool renderOutput, bool *hit = nullptr);
+    // windowed 可选，返回哈希时生成的 8 位灰度图（缓存关闭时为空）
+    InferenceEngine::Result run(const InferenceEngine &engine, const InferenceEngine::PixelView &pixels,
+                                InferenceEngine::Task task, bool *hit = nullptr, QImage *windowed = nullptr);
+
+    Stats stats() const;
+
+private:
+    ResultCache() = default;
+    ResultCache(const ResultCache &) = delete;
+    ResultCache &operator=(const ResultCache &) = delete;
+
+    struct Entry
+    {
+        qint64 offset{0}; // 数据起始偏移
+        quint32 size{0};
+        quint16 crc{0};
+    };
+
+    // 按当前配置打开（目录或开关变化时重新打开）；返回缓存是否可用
+    bool ensureOpenLocked();
+    bool openLocked(const QString &directory);
+    void closeLocked();
+    bool remapLocked();
+    // 按写入顺序保留最新的记录（总长不超过 target）写入新文件后替换
+    bool compactLocked(qint64 target);
+    bool find(const QByteArray &key, InferenceEngine::Result &out);
+    void store(const QByteArray &key, const InferenceEngine::Result &result);
+
+    static QByteArray serialize(const InferenceEngine::Result &result);
+    static bool deserialize(const QByteArray &payload, InferenceEngine::Result &out);
+
+    mutable QMutex m_mutex;
+    QString m_directory;  // 已打开的目录，空表示未打开
+    QFile m_file;
+    uchar *m_map{nullptr};
+    qint64 m_mapSize{0};
+    qint64 m_size{0};     // 已写入的有效长度
+    qint64 m_maxSize{0};
+    QHash<QByteArray, Entry> m_index;
+    std::atomic<qint64> m_hits{0};
+    std::atomic<qint64> m_misses{0};
+};
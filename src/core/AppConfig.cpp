@@ -1,9 +1,14 @@
 #include "AppConfig.h"
+#include "ErrorHandler.h"
 #include <QCoreApplication>
 #include <QFile>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QDir>
+#include <QMutexLocker>
 #include <QRegularExpression>
+#include <QTimer>
+#include <algorithm>
 
 namespace
 {
@@ -17,6 +22,92 @@ QStringList defaultMriClassNames()
         QStringLiteral("Piriformis"),
         QStringLiteral("Tensor Fasciae Latae")};
 }
+
+QStringList parseMriClassNames(const QSettings &settings)
+{
+    const QString raw = settings.value("MRI/ClassNames").toString();
+    if (raw.trimmed().isEmpty())
+        return defaultMriClassNames();
+
+    QStringList names;
+    const QStringList parts = raw.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts);
+    for (const QString &p : parts)
+    {
+        const QString trimmed = p.trimmed();
+        if (!trimmed.isEmpty())
+            names << trimmed;
+    }
+    return names.isEmpty() ? defaultMriClassNames() : names;
+}
+
+QString resolveModelProtectionKey(const QSettings &settings)
+{
+    const QString configured = settings.value("Security/ModelProtectionKey").toString().trimmed();
+    if (!configured.isEmpty())
+        return configured;
+
+    const QString envKey = QString::fromUtf8(qgetenv("MEDAPP_MODEL_KEY")).trimmed();
+    if (!envKey.isEmpty())
+        return envKey;
+
+    return QStringLiteral("MedYOLO11Qt_Model_Protection_Key_2024");
+}
+
+QString resolveLogFilePath(const QSettings &settings)
+{
+    const QString path = settings.value("Logging/LogFilePath").toString().trimmed();
+    if (path.isEmpty() || QDir::isAbsolutePath(path))
+        return path;
+    return QDir(QCoreApplication::applicationDirPath()).absoluteFilePath(path);
+}
+
+// 一次性解析全部配置项（默认值与取值规范化都在这里完成）
+AppConfig::Snapshot parseSnapshot(const QSettings &settings)
+{
+    AppConfig::Snapshot s;
+    s.qtInstallPath = settings.value("Paths/QtPath").toString();
+    s.gdcmInstallPath = settings.value("Paths/GDCMPath").toString();
+    s.onnxRuntimeInstallPath = settings.value("Paths/ONNXRuntimePath").toString();
+    s.faiModelPath = settings.value("Models/FAI", "./models/fai_xray.onnx").toString();
+    s.mriModelPath = settings.value("Models/MRI", "./models/mri_segmentation.onnx").toString();
+    s.modelPrecision = settings.value("Models/Precision", "fp32").toString().trimmed().toLower();
+    s.faiTriageModelPath = settings.value("Models/FAITriage").toString().trimmed();
+    s.mriClassNames = parseMriClassNames(settings);
+    s.confidenceThreshold = settings.value("Inference/ConfidenceThreshold", 0.25f).toFloat();
+    s.iouThreshold = settings.value("Inference/IoUThreshold", 0.45f).toFloat();
+    s.useModelThresholds = settings.value("Inference/UseModelThresholds", true).toBool();
+    s.minimalPadding = settings.value("Inference/MinimalPadding", true).toBool();
+    s.tiledInference = settings.value("Inference/TiledInference", false).toBool();
+    s.tileSize = std::max(0, settings.value("Inference/TileSize", 0).toInt());
+    s.tileOverlap = std::clamp(settings.value("Inference/TileOverlap", 0.2f).toFloat(), 0.f, 0.5f);
+    s.tileMinImageSize = std::max(0, settings.value("Inference/TileMinImageSize", 2000).toInt());
+    s.tileParallelism = std::max(0, settings.value("Inference/TileParallelism", 0).toInt());
+    s.triageCascade = settings.value("Inference/TriageCascade", false).toBool();
+    s.triageConfidence = std::clamp(settings.value("Inference/TriageConfidence", 0.9f).toFloat(), 0.f, 1.f);
+    s.triageInputSize = std::max(0, settings.value("Inference/TriageInputSize", 320).toInt());
+    s.modelProtectionKey = resolveModelProtectionKey(settings);
+    s.gpuAcceleration = settings.value("Performance/UseGPU", false).toBool();
+    s.gpuDeviceId = settings.value("Performance/GPUID", 0).toInt();
+    s.inferenceThreads = settings.value("Performance/InferenceThreads", 0).toInt();
+    s.decodeThreads = settings.value("Performance/DecodeThreads", 0).toInt();
+    s.executionProviders = settings.value("Performance/ExecutionProviders", "auto").toString().trimmed().toLower();
+    s.autoTuneProviders = settings.value("Performance/AutoTuneProviders", true).toBool();
+    s.resultCacheEnabled = settings.value("Cache/Enabled", true).toBool();
+    s.resultCacheDirectory = settings.value("Cache/Directory").toString().trimmed();
+    s.resultCacheMaxSizeMB = std::max(0, settings.value("Cache/MaxSizeMB", 2048).toInt());
+    s.exportImageFormat = settings.value("Export/ImageFormat", "png").toString().trimmed().toLower();
+    s.exportPngCompression = std::clamp(settings.value("Export/PngCompression", 1).toInt(), 0, 9);
+    s.exportMaskFormat = settings.value("Export/MaskFormat", "labelmap").toString().trimmed().toLower();
+    s.exportJsonLayout = settings.value("Export/JsonLayout", "jsonl").toString().trimmed().toLower();
+    s.exportWriteCoco = settings.value("Export/WriteCoco", false).toBool();
+    s.exportBaseCacheMB = std::max(0, settings.value("Export/BaseImageCacheMB", 512).toInt());
+    s.logLevel = settings.value("Logging/LogLevel", "INFO").toString().trimmed().toUpper();
+    s.logToFile = settings.value("Logging/LogToFile", true).toBool();
+    s.logFilePath = resolveLogFilePath(settings);
+    s.maxLogSize = settings.value("Logging/MaxLogSize", 10 * 1024 * 1024).toLongLong();
+    s.debugMode = settings.value("Debug/Enabled", false).toBool();
+    return s;
+}
 }
 
 /**
@@ -41,6 +132,10 @@ AppConfig::AppConfig()
 
     // 创建QSettings对象
     m_settings = new QSettings(m_configFilePath, QSettings::IniFormat);
+    {
+        QMutexLocker locker(&m_mutex);
+        publishLocked();
+    }
 
     // 设置默认值（如果配置文件不存在，使用这些默认值）
     if (!QFile::exists(m_configFilePath))
@@ -61,6 +156,7 @@ AppConfig::AppConfig()
  */
 AppConfig::~AppConfig()
 {
+    // 监视器挂在 QCoreApplication 上，随应用对象一起释放
     delete m_settings;
     m_settings = nullptr;
 }
@@ -79,11 +175,17 @@ bool AppConfig::loadConfig(const QString &configPath)
         return false;
     }
 
-    m_configFilePath = path;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_configFilePath = path;
 
-    // 释放旧的QSettings对象并创建新的
-    delete m_settings;
-    m_settings = new QSettings(path, QSettings::IniFormat);
+        // 释放旧的QSettings对象并创建新的
+        delete m_settings;
+        m_settings = new QSettings(path, QSettings::IniFormat);
+        publishLocked();
+    }
+    rearmWatcher();
+    notifySubscribers();
     return true;
 }
 
@@ -104,12 +206,14 @@ bool AppConfig::saveConfig(const QString &configPath)
         return false;
     }
 
+    QMutexLocker locker(&m_mutex);
     // 如果指定了新路径，创建新的QSettings对象
     if (!configPath.isEmpty())
     {
         m_configFilePath = path;
         delete m_settings;
         m_settings = new QSettings(path, QSettings::IniFormat);
+        publishLocked();
     }
 
     // 保存配置
@@ -117,13 +221,117 @@ bool AppConfig::saveConfig(const QString &configPath)
     return true;
 }
 
+int AppConfig::subscribe(Subscriber callback)
+{
+    QMutexLocker locker(&m_mutex);
+    const int id = m_nextSubscriberId++;
+    m_subscribers.emplace(id, std::move(callback));
+    return id;
+}
+
+void AppConfig::unsubscribe(int id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_subscribers.erase(id);
+}
+
+void AppConfig::setWatchEnabled(bool enabled)
+{
+    if (!enabled)
+    {
+        delete m_watcher.data();
+        delete m_reloadTimer.data();
+        return;
+    }
+    if (m_watcher || !QCoreApplication::instance())
+        return;
+
+    m_watcher = new QFileSystemWatcher(QCoreApplication::instance());
+    // 编辑器保存时常连续触发多次，合并为一次重新加载
+    m_reloadTimer = new QTimer(m_watcher);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(250);
+    QObject::connect(m_watcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, [this]()
+                     { m_reloadTimer->start(); });
+    QObject::connect(m_reloadTimer, &QTimer::timeout, m_watcher, [this]()
+                     { reloadFromDisk(); });
+    rearmWatcher();
+}
+
+void AppConfig::setValue(const QString &key, const QVariant &value)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_settings->setValue(key, value);
+        publishLocked();
+    }
+    notifySubscribers();
+}
+
+void AppConfig::publishLocked()
+{
+    auto next = std::make_shared<Snapshot>(parseSnapshot(*m_settings));
+    const SnapshotPtr previous = std::atomic_load_explicit(&m_current, std::memory_order_relaxed);
+    next->revision = previous ? previous->revision + 1 : 1;
+    std::atomic_store_explicit(&m_current, SnapshotPtr(std::move(next)), std::memory_order_release);
+}
+
+void AppConfig::notifySubscribers()
+{
+    // 回调在锁外执行，订阅者可以继续读取或修改配置
+    std::vector<Subscriber> callbacks;
+    {
+        QMutexLocker locker(&m_mutex);
+        callbacks.reserve(m_subscribers.size());
+        for (const auto &entry : m_subscribers)
+            callbacks.push_back(entry.second);
+    }
+    const SnapshotPtr snapshot = current();
+    for (const Subscriber &callback : callbacks)
+        callback(*snapshot);
+}
+
+void AppConfig::reloadFromDisk()
+{
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        path = m_configFilePath;
+        if (!QFile::exists(path))
+            return;
+        delete m_settings;
+        m_settings = new QSettings(path, QSettings::IniFormat);
+        publishLocked();
+    }
+    rearmWatcher();
+    LOG_INFO(QStringLiteral("配置文件已重新加载: %1").arg(path), "Config");
+    notifySubscribers();
+}
+
+void AppConfig::rearmWatcher()
+{
+    if (!m_watcher)
+        return;
+    // 原子替换式保存会让监视器丢失原文件，需要重新添加
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        path = m_configFilePath;
+    }
+    const QStringList watched = m_watcher->files();
+    if (!watched.isEmpty() && watched != QStringList{path})
+        m_watcher->removePaths(watched);
+    if (QFile::exists(path) && !m_watcher->files().contains(path))
+        m_watcher->addPath(path);
+}
+
 /**
  * @brief 获取Qt安装路径
  * @return Qt安装路径
  */
 QString AppConfig::getQtInstallPath() const
 {
-    return m_settings->value("Paths/QtPath").toString();
+    return current()->qtInstallPath;
 }
 
 /**
@@ -132,7 +340,7 @@ QString AppConfig::getQtInstallPath() const
  */
 void AppConfig::setQtInstallPath(const QString &path)
 {
-    m_settings->setValue("Paths/QtPath", path);
+    setValue(QStringLiteral("Paths/QtPath"), path);
 }
 
 /**
@@ -141,7 +349,7 @@ void AppConfig::setQtInstallPath(const QString &path)
  */
 QString AppConfig::getGdcmInstallPath() const
 {
-    return m_settings->value("Paths/GDCMPath").toString();
+    return current()->gdcmInstallPath;
 }
 
 /**
@@ -150,7 +358,7 @@ QString AppConfig::getGdcmInstallPath() const
  */
 void AppConfig::setGdcmInstallPath(const QString &path)
 {
-    m_settings->setValue("Paths/GDCMPath", path);
+    setValue(QStringLiteral("Paths/GDCMPath"), path);
 }
 
 /**
@@ -159,7 +367,7 @@ void AppConfig::setGdcmInstallPath(const QString &path)
  */
 QString AppConfig::getOnnxRuntimeInstallPath() const
 {
-    return m_settings->value("Paths/ONNXRuntimePath").toString();
+    return current()->onnxRuntimeInstallPath;
 }
 
 /**
@@ -168,7 +376,7 @@ QString AppConfig::getOnnxRuntimeInstallPath() const
  */
 void AppConfig::setOnnxRuntimeInstallPath(const QString &path)
 {
-    m_settings->setValue("Paths/ONNXRuntimePath", path);
+    setValue(QStringLiteral("Paths/ONNXRuntimePath"), path);
 }
 
 /**
@@ -177,7 +385,7 @@ void AppConfig::setOnnxRuntimeInstallPath(const QString &path)
  */
 QString AppConfig::getFaiModelPath() const
 {
-    return m_settings->value("Models/FAI", "./models/fai_xray.onnx").toString();
+    return current()->faiModelPath;
 }
 
 /**
@@ -186,7 +394,7 @@ QString AppConfig::getFaiModelPath() const
  */
 void AppConfig::setFaiModelPath(const QString &path)
 {
-    m_settings->setValue("Models/FAI", path);
+    setValue(QStringLiteral("Models/FAI"), path);
 }
 
 /**
@@ -195,7 +403,7 @@ void AppConfig::setFaiModelPath(const QString &path)
  */
 QString AppConfig::getMriModelPath() const
 {
-    return m_settings->value("Models/MRI", "./models/mri_segmentation.onnx").toString();
+    return current()->mriModelPath;
 }
 
 /**
@@ -204,29 +412,17 @@ QString AppConfig::getMriModelPath() const
  */
 void AppConfig::setMriModelPath(const QString &path)
 {
-    m_settings->setValue("Models/MRI", path);
+    setValue(QStringLiteral("Models/MRI"), path);
 }
 
 QStringList AppConfig::getMriClassNames() const
 {
-    const QString raw = m_settings->value("MRI/ClassNames").toString();
-    if (raw.trimmed().isEmpty())
-        return defaultMriClassNames();
-
-    QStringList names;
-    const QStringList parts = raw.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts);
-    for (const QString &p : parts)
-    {
-        const QString trimmed = p.trimmed();
-        if (!trimmed.isEmpty())
-            names << trimmed;
-    }
-    return names.isEmpty() ? defaultMriClassNames() : names;
+    return current()->mriClassNames;
 }
 
 void AppConfig::setMriClassNames(const QStringList &names)
 {
-    m_settings->setValue("MRI/ClassNames", names.join(", "));
+    setValue(QStringLiteral("MRI/ClassNames"), names.join(", "));
 }
 
 /**
@@ -235,7 +431,7 @@ void AppConfig::setMriClassNames(const QStringList &names)
  */
 float AppConfig::getConfidenceThreshold() const
 {
-    return m_settings->value("Inference/ConfidenceThreshold", 0.25f).toFloat();
+    return current()->confidenceThreshold;
 }
 
 /**
@@ -244,7 +440,7 @@ float AppConfig::getConfidenceThreshold() const
  */
 void AppConfig::setConfidenceThreshold(float threshold)
 {
-    m_settings->setValue("Inference/ConfidenceThreshold", threshold);
+    setValue(QStringLiteral("Inference/ConfidenceThreshold"), threshold);
 }
 
 /**
@@ -253,7 +449,7 @@ void AppConfig::setConfidenceThreshold(float threshold)
  */
 float AppConfig::getIoUThreshold() const
 {
-    return m_settings->value("Inference/IoUThreshold", 0.45f).toFloat();
+    return current()->iouThreshold;
 }
 
 /**
@@ -262,7 +458,7 @@ float AppConfig::getIoUThreshold() const
  */
 void AppConfig::setIoUThreshold(float threshold)
 {
-    m_settings->setValue("Inference/IoUThreshold", threshold);
+    setValue(QStringLiteral("Inference/IoUThreshold"), threshold);
 }
 
 /**
@@ -271,15 +467,7 @@ void AppConfig::setIoUThreshold(float threshold)
  */
 QString AppConfig::getModelProtectionKey() const
 {
-    const QString configured = m_settings->value("Security/ModelProtectionKey").toString().trimmed();
-    if (!configured.isEmpty())
-        return configured;
-
-    const QString envKey = QString::fromUtf8(qgetenv("MEDAPP_MODEL_KEY")).trimmed();
-    if (!envKey.isEmpty())
-        return envKey;
-
-    return QStringLiteral("MedYOLO11Qt_Model_Protection_Key_2024");
+    return current()->modelProtectionKey;
 }
 
 /**
@@ -288,27 +476,117 @@ QString AppConfig::getModelProtectionKey() const
  */
 void AppConfig::setModelProtectionKey(const QString &key)
 {
-    m_settings->setValue("Security/ModelProtectionKey", key);
+    setValue(QStringLiteral("Security/ModelProtectionKey"), key);
 }
 
 bool AppConfig::isGpuAccelerationEnabled() const
 {
-    return m_settings->value("Performance/UseGPU", false).toBool();
+    return current()->gpuAcceleration;
 }
 
 void AppConfig::setGpuAccelerationEnabled(bool enabled)
 {
-    m_settings->setValue("Performance/UseGPU", enabled);
+    setValue(QStringLiteral("Performance/UseGPU"), enabled);
 }
 
 int AppConfig::gpuDeviceId() const
 {
-    return m_settings->value("Performance/GPUID", 0).toInt();
+    return current()->gpuDeviceId;
 }
 
 void AppConfig::setGpuDeviceId(int deviceId)
 {
-    m_settings->setValue("Performance/GPUID", deviceId);
+    setValue(QStringLiteral("Performance/GPUID"), deviceId);
+}
+
+int AppConfig::inferenceThreadCount() const
+{
+    return current()->inferenceThreads;
+}
+
+void AppConfig::setInferenceThreadCount(int threads)
+{
+    setValue(QStringLiteral("Performance/InferenceThreads"), threads);
+}
+
+int AppConfig::decodeThreadCount() const
+{
+    return current()->decodeThreads;
+}
+
+void AppConfig::setDecodeThreadCount(int threads)
+{
+    setValue(QStringLiteral("Performance/DecodeThreads"), threads);
+}
+
+QString AppConfig::exportImageFormat() const
+{
+    return current()->exportImageFormat;
+}
+
+void AppConfig::setExportImageFormat(const QString &format)
+{
+    setValue(QStringLiteral("Export/ImageFormat"), format);
+}
+
+int AppConfig::exportPngCompression() const
+{
+    return current()->exportPngCompression;
+}
+
+void AppConfig::setExportPngCompression(int level)
+{
+    setValue(QStringLiteral("Export/PngCompression"), level);
+}
+
+QString AppConfig::exportMaskFormat() const
+{
+    return current()->exportMaskFormat;
+}
+
+void AppConfig::setExportMaskFormat(const QString &format)
+{
+    setValue(QStringLiteral("Export/MaskFormat"), format);
+}
+
+QString AppConfig::exportJsonLayout() const
+{
+    return current()->exportJsonLayout;
+}
+
+void AppConfig::setExportJsonLayout(const QString &layout)
+{
+    setValue(QStringLiteral("Export/JsonLayout"), layout);
+}
+
+bool AppConfig::exportWriteCoco() const
+{
+    return current()->exportWriteCoco;
+}
+
+void AppConfig::setExportWriteCoco(bool enabled)
+{
+    setValue(QStringLiteral("Export/WriteCoco"), enabled);
+}
+
+QString AppConfig::logLevel() const
+{
+    return current()->logLevel;
+}
+
+bool AppConfig::isLogToFileEnabled() const
+{
+    return current()->logToFile;
+}
+
+QString AppConfig::logFilePath() const
+{
+    return current()->logFilePath;
+}
+
+qint64 AppConfig::maxLogSize() const
+{
+    return current()->maxLogSize;
 }
 
 /**
@@ -317,7 +595,7 @@ void AppConfig::setGpuDeviceId(int deviceId)
  */
 bool AppConfig::isDebugModeEnabled() const
 {
-    return m_settings->value("Debug/Enabled", false).toBool();
+    return current()->debugMode;
 }
 
 /**
@@ -326,5 +604,5 @@ bool AppConfig::isDebugModeEnabled() const
  */
 void AppConfig::setDebugModeEnabled(bool enabled)
 {
-    m_settings->setValue("Debug/Enabled", enabled);
+    setValue(QStringLiteral("Debug/Enabled"), enabled);
 }
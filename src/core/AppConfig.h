@@ -1,17 +1,83 @@
 #ifndef APPCONFIG_H
 #define APPCONFIG_H
 
+#include <QMutex>
+#include <QPointer>
 #include <QString>
 #include <QStringList>
 #include <QSettings>
+#include <QVariant>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class QFileSystemWatcher;
+class QTimer;
 
 /**
  * @brief 应用程序配置管理类
- * @details 单例模式，用于管理应用程序的配置参数
+ * @details 单例模式，用于管理应用程序的配置参数。
+ *          读取走不可变快照：配置文件加载、修改或被外部编辑后整体解析一次并原子替换当前快照，
+ *          任意线程读取只需一次原子 shared_ptr 加载；读者持有的快照在释放前保持有效，
+ *          被替换的快照随最后一个引用回收。
  */
 class AppConfig
 {
 public:
+    /**
+     * @brief 预解析的配置快照（只读）
+     */
+    struct Snapshot
+    {
+        QString qtInstallPath;
+        QString gdcmInstallPath;
+        QString onnxRuntimeInstallPath;
+        QString faiModelPath;
+        QString mriModelPath;
+        QString modelPrecision; // fp32 / fp16 / int8，选择模型同目录下的对应精度变体
+        QString faiTriageModelPath; // 级联初筛分类模型，为空时用检测模型低分辨率初筛
+        QStringList mriClassNames;
+        float confidenceThreshold{0.25f};
+        float iouThreshold{0.45f};
+        bool useModelThresholds{true}; // 模型元数据带默认阈值时优先使用
+        bool minimalPadding{true};     // 动态输入模型按长宽比做矩形最小填充
+        bool tiledInference{false};    // 高分辨率检测输入切片推理
+        int tileSize{0};               // 切片边长（像素），0 为模型输入尺寸
+        float tileOverlap{0.2f};       // 相邻切片重叠比例
+        int tileMinImageSize{2000};    // 长边达到该尺寸才切片
+        int tileParallelism{0};        // 切片并发数，0 为自动
+        bool triageCascade{false};     // 检测前先做廉价初筛，明确 NORMAL 时跳过完整检测
+        float triageConfidence{0.9f};  // 初筛判为 NORMAL 的最低置信度
+        int triageInputSize{320};      // 低分辨率初筛的输入边长
+        QString modelProtectionKey;
+        bool gpuAcceleration{false};
+        int gpuDeviceId{0};
+        int inferenceThreads{0};
+        int decodeThreads{0};
+        QString executionProviders; // 逗号分隔的提供程序列表，"auto" 使用本机调优结果
+        bool autoTuneProviders{true};
+        bool resultCacheEnabled{true};  // 跨会话推理结果缓存
+        QString resultCacheDirectory;   // 为空时使用本机数据目录下的 result_cache
+        int resultCacheMaxSizeMB{2048}; // 缓存文件上限，达到后丢弃最早的记录
+        QString exportImageFormat;
+        int exportPngCompression{1};
+        QString exportMaskFormat;
+        QString exportJsonLayout;
+        bool exportWriteCoco{false};
+        int exportBaseCacheMB{512}; // 批量结果底图预算，导出补绘结果图用
+        QString logLevel;
+        bool logToFile{true};
+        QString logFilePath;
+        qint64 maxLogSize{10 * 1024 * 1024};
+        bool debugMode{false};
+        quint64 revision{0}; // 每次发布递增
+    };
+
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+    using Subscriber = std::function<void(const Snapshot &)>;
+
     /**
      * @brief 获取配置管理器的单例实例
      * @return AppConfig的引用
@@ -37,6 +103,25 @@ public:
      */
     bool saveConfig(const QString &configPath = QString());
 
+    /**
+     * @brief 当前配置快照（线程安全，一次原子加载）
+     * @details 需跨语句使用时持有返回的指针，不要绑定到其成员的引用上
+     */
+    SnapshotPtr current() const { return std::atomic_load_explicit(&m_current, std::memory_order_acquire); }
+
+    /**
+     * @brief 订阅配置变化（在发布新快照的线程回调：热重载在 GUI 线程，setter 在调用线程）
+     * @return 订阅编号，用于 unsubscribe
+     */
+    int subscribe(Subscriber callback);
+    void unsubscribe(int id);
+
+    /**
+     * @brief 监视配置文件，被外部修改后自动重新加载并通知订阅者
+     * @details 需在 QCoreApplication 创建之后调用
+     */
+    void setWatchEnabled(bool enabled);
+
     // Qt相关配置
     QString getQtInstallPath() const;
     void setQtInstallPath(const QString &path);
@@ -76,6 +161,36 @@ public:
     int gpuDeviceId() const;
     void setGpuDeviceId(int deviceId);
 
+    // 线程分配：<= 0 表示自动（解码线程为推理预留核心）
+    int inferenceThreadCount() const;
+    void setInferenceThreadCount(int threads);
+
+    int decodeThreadCount() const;
+    void setDecodeThreadCount(int threads);
+
+    // 批量导出编码：结果图格式（png / qoi）、PNG 压缩级别（0-9）、掩码格式（labelmap / rgba）
+    QString exportImageFormat() const;
+    void setExportImageFormat(const QString &format);
+
+    int exportPngCompression() const;
+    void setExportPngCompression(int level);
+
+    QString exportMaskFormat() const;
+    void setExportMaskFormat(const QString &format);
+
+    // 批量预测记录：jsonl 为单个 JSON Lines 文件，per-image 为每图一个 JSON；可选生成 COCO 标注
+    QString exportJsonLayout() const;
+    void setExportJsonLayout(const QString &layout);
+
+    bool exportWriteCoco() const;
+    void setExportWriteCoco(bool enabled);
+
+    // 日志配置：相对路径按程序目录解析；MaxLogSize 为单个日志文件的轮转阈值（字节）
+    QString logLevel() const;
+    bool isLogToFileEnabled() const;
+    QString logFilePath() const;
+    qint64 maxLogSize() const;
+
     // 调试模式配置
     bool isDebugModeEnabled() const;
     void setDebugModeEnabled(bool enabled);
@@ -88,11 +203,26 @@ private:
     AppConfig(const AppConfig &) = delete;
     AppConfig &operator=(const AppConfig &) = delete;
 
+    // 写入一项配置并发布新快照
+    void setValue(const QString &key, const QVariant &value);
+    // 从 m_settings 解析完整快照并原子替换当前快照（调用方持有 m_mutex）
+    void publishLocked();
+    void notifySubscribers();
+    void reloadFromDisk();
+    void rearmWatcher();
+
     // 配置存储（改为指针类型）
     QSettings *m_settings;
 
     // 默认配置路径
     QString m_configFilePath;
+
+    mutable QMutex m_mutex; // 保护 m_settings 与订阅者
+    SnapshotPtr m_current;  // 只经 std::atomic_load / atomic_store 访问
+    std::map<int, Subscriber> m_subscribers;
+    int m_nextSubscriberId{1};
+    QPointer<QFileSystemWatcher> m_watcher;
+    QPointer<QTimer> m_reloadTimer;
 };
 
 #endif // APPCONFIG_H
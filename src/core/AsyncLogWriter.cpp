@@ -0,0 +1,420 @@
+#include "AsyncLogWriter.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char *typeName(ErrorType type)
+    {
+        switch (type)
+        {
+        case ErrorType::INFO:
+            return "INFO";
+        case ErrorType::WARNING:
+            return "WARNING";
+        case ErrorType::ERROR:
+            return "ERROR";
+        case ErrorType::CRITICAL:
+            return "CRITICAL";
+        case ErrorType::DEBUG:
+            return "DEBUG";
+        }
+        return "UNKNOWN";
+    }
+
+    // 单次写盘前在内存中累积的最大字节数
+    constexpr int kWriteChunkBytes = 64 * 1024;
+
+    int openAppendFd(const QString &path)
+    {
+#ifdef _WIN32
+        return ::_wopen(reinterpret_cast<const wchar_t *>(path.utf16()), _O_WRONLY | _O_APPEND | _O_BINARY);
+#else
+        return ::open(QFile::encodeName(path).constData(), O_WRONLY | O_APPEND | O_CLOEXEC);
+#endif
+    }
+
+    void closeFd(int fd)
+    {
+#ifdef _WIN32
+        ::_close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    // 信号处理中可用：只调用 write
+    void writeAll(int fd, const char *data, size_t size) noexcept
+    {
+        while (size > 0)
+        {
+#ifdef _WIN32
+            const int n = ::_write(fd, data, static_cast<unsigned int>(size));
+#else
+            const ssize_t n = ::write(fd, data, size);
+#endif
+            if (n <= 0)
+                return;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+}
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity, int flushIntervalMs, int flushBatch)
+    : m_ring(capacity),
+      m_flushIntervalMs(std::max(10, flushIntervalMs)),
+      m_flushBatch(std::max(1, flushBatch))
+{
+    m_thread = std::thread(&AsyncLogWriter::run, this);
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable())
+        m_thread.join();
+
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    closeLocked();
+}
+
+bool AsyncLogWriter::enqueue(LogRecord &&record, bool urgent)
+{
+    const bool pushed = m_ring.tryPush(std::move(record));
+    if (!pushed)
+    {
+        // 缓冲满：丢弃并计数，同时确保写线程已被唤醒
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        urgent = true;
+    }
+    else
+    {
+        m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 每批只唤醒一次，生产者之间几乎不竞争 m_wakeMutex
+    if (urgent || m_sinceWake.fetch_add(1, std::memory_order_relaxed) + 1 == m_flushBatch)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakeRequested = true;
+        }
+        m_wake.notify_one();
+    }
+    return pushed;
+}
+
+void AsyncLogWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    if (m_stop || std::this_thread::get_id() == m_thread.get_id())
+        return;
+    const quint64 ticket = ++m_flushRequests;
+    m_wakeRequested = true;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [this, ticket]()
+                   { return m_flushGeneration >= ticket || m_stop; });
+}
+
+void AsyncLogWriter::writeFromCrashHandler(const char *line) noexcept
+{
+    // 不加锁：写线程或崩溃线程可能正持有任何锁；文件已由写线程按批刷新
+    const size_t size = std::strlen(line);
+    if (m_consoleEnabled.load(std::memory_order_relaxed))
+        writeAll(2, line, size);
+    const int fd = m_crashFd.load(std::memory_order_acquire);
+    if (fd >= 0)
+        writeAll(fd, line, size);
+}
+
+void AsyncLogWriter::setUiCapacity(int entries)
+{
+    std::lock_guard<std::mutex> lock(m_uiMutex);
+    m_uiCapacity.store(std::max(0, entries), std::memory_order_relaxed);
+    while (m_uiPending.size() > static_cast<size_t>(std::max(0, entries)))
+        m_uiPending.pop_front();
+}
+
+quint64 AsyncLogWriter::takeUiRecords(std::vector<LogRecord> &out)
+{
+    std::lock_guard<std::mutex> lock(m_uiMutex);
+    out.reserve(out.size() + m_uiPending.size());
+    for (LogRecord &record : m_uiPending)
+        out.push_back(std::move(record));
+    m_uiPending.clear();
+    const quint64 dropped = m_uiDropped;
+    m_uiDropped = 0;
+    return dropped;
+}
+
+void AsyncLogWriter::setFilePath(const QString &path)
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (path == m_filePath)
+        return;
+    writePendingLocked();
+    closeLocked();
+    m_filePath = path;
+    m_openFailed = false;
+}
+
+QString AsyncLogWriter::filePath() const
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    return m_filePath;
+}
+
+void AsyncLogWriter::setMaxFileSize(qint64 bytes)
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_maxFileSize = bytes;
+}
+
+void AsyncLogWriter::setFileOutputEnabled(bool enable)
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_fileEnabled = enable;
+    if (!enable)
+    {
+        m_pending.clear();
+        closeLocked();
+    }
+}
+
+void AsyncLogWriter::setConsoleOutputEnabled(bool enable)
+{
+    m_consoleEnabled.store(enable, std::memory_order_relaxed);
+}
+
+LogStats AsyncLogWriter::stats() const
+{
+    LogStats s;
+    s.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    s.written = m_written.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.flushes = m_flushes.load(std::memory_order_relaxed);
+    s.rotations = m_rotations.load(std::memory_order_relaxed);
+    return s;
+}
+
+QByteArray AsyncLogWriter::format(const LogRecord &record)
+{
+    QByteArray line;
+    line.reserve(64 + record.module.size() + record.message.size() * 3);
+    line.append('[');
+    line.append(QDateTime::fromMSecsSinceEpoch(record.timestampMs).toString(QStringLiteral("yyyy-MM-dd HH:mm:ss.zzz")).toLatin1());
+    line.append("] [");
+    line.append(typeName(record.type));
+    line.append("] [");
+    line.append(record.module.toUtf8());
+    line.append("] ");
+    line.append(record.message.toUtf8());
+    if (record.code != 0)
+    {
+        line.append(" [Code: ");
+        line.append(QByteArray::number(record.code));
+        line.append(']');
+    }
+    line.append('\n');
+    return line;
+}
+
+void AsyncLogWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    for (;;)
+    {
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMs), [this]()
+                        { return m_stop || m_wakeRequested; });
+        const bool stop = m_stop;
+        const quint64 requests = m_flushRequests;
+        m_wakeRequested = false;
+        lock.unlock();
+
+        m_sinceWake.store(0, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> fileLock(m_fileMutex);
+            size_t drained = 0;
+            size_t n = 0;
+            while ((n = drainLocked(1024)) > 0)
+                drained += n;
+            reportDroppedLocked();
+            if (drained > 0 || !m_pending.isEmpty())
+            {
+                writePendingLocked();
+                if (m_file.isOpen())
+                    m_file.flush();
+                m_flushes.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        lock.lock();
+        m_flushGeneration = requests;
+        m_flushed.notify_all();
+        if (stop)
+            break;
+    }
+}
+
+size_t AsyncLogWriter::drainLocked(size_t limit)
+{
+    const bool console = m_consoleEnabled.load(std::memory_order_relaxed);
+    const int uiCapacity = m_uiCapacity.load(std::memory_order_relaxed);
+    std::vector<LogRecord> forUi;
+    size_t count = 0;
+    LogRecord record;
+    while (count < limit && m_ring.tryPop(record))
+    {
+        const QByteArray line = format(record);
+        if (console)
+        {
+            const QString text = QString::fromUtf8(line.constData(), line.size() - 1);
+            switch (record.type)
+            {
+            case ErrorType::INFO:
+                qInfo().noquote() << text;
+                break;
+            case ErrorType::WARNING:
+                qWarning().noquote() << text;
+                break;
+            case ErrorType::ERROR:
+            case ErrorType::CRITICAL:
+                qCritical().noquote() << text;
+                break;
+            case ErrorType::DEBUG:
+                qDebug().noquote() << text;
+                break;
+            }
+        }
+        appendLocked(line);
+        if (uiCapacity > 0)
+            forUi.push_back(std::move(record));
+        ++count;
+    }
+    m_written.fetch_add(count, std::memory_order_relaxed);
+
+    // 每批只取一次界面锁
+    if (!forUi.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_uiMutex);
+        for (LogRecord &entry : forUi)
+            m_uiPending.push_back(std::move(entry));
+        const size_t capacity = static_cast<size_t>(std::max(0, m_uiCapacity.load(std::memory_order_relaxed)));
+        while (m_uiPending.size() > capacity)
+        {
+            m_uiPending.pop_front();
+            ++m_uiDropped;
+        }
+    }
+    return count;
+}
+
+void AsyncLogWriter::appendLocked(const QByteArray &line)
+{
+    if (!m_fileEnabled || m_filePath.isEmpty())
+        return;
+
+    // 按已写字节数判断轮转，不再每条查询文件大小
+    if (m_maxFileSize > 0 && m_fileBytes + m_pending.size() > 0 &&
+        m_fileBytes + m_pending.size() + line.size() > m_maxFileSize)
+    {
+        writePendingLocked();
+        rotateLocked();
+    }
+    m_pending.append(line);
+    if (m_pending.size() >= kWriteChunkBytes)
+        writePendingLocked();
+}
+
+void AsyncLogWriter::writePendingLocked()
+{
+    if (m_pending.isEmpty())
+        return;
+    if (!openLocked())
+    {
+        m_pending.clear();
+        return;
+    }
+    const qint64 written = m_file.write(m_pending);
+    if (written > 0)
+        m_fileBytes += written;
+    m_pending.clear();
+}
+
+bool AsyncLogWriter::openLocked()
+{
+    if (m_file.isOpen())
+        return true;
+    if (m_openFailed)
+        return false;
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        // 打不开时只提示一次，之后仅输出到控制台，直到日志路径被重新设置
+        qWarning() << "Failed to open log file:" << m_filePath;
+        m_openFailed = true;
+        return false;
+    }
+    m_fileBytes = m_file.size();
+    m_crashFd.store(openAppendFd(m_filePath), std::memory_order_release);
+    return true;
+}
+
+void AsyncLogWriter::closeLocked()
+{
+    const int fd = m_crashFd.exchange(-1, std::memory_order_acq_rel);
+    if (fd >= 0)
+        closeFd(fd);
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+void AsyncLogWriter::rotateLocked()
+{
+    closeLocked();
+
+    // 使用时间戳作为备份文件后缀
+    const QString timestamp = QDateTime::currentDateTime().toString(QStringLiteral("yyyy-MM-dd_HH-mm-ss-zzz"));
+    QFile::rename(m_filePath, m_filePath + "." + timestamp + ".bak");
+    m_fileBytes = 0;
+    m_rotations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogWriter::reportDroppedLocked()
+{
+    const quint64 dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped <= m_reportedDropped)
+        return;
+
+    LogRecord note;
+    note.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    note.type = ErrorType::WARNING;
+    note.module = QStringLiteral("Logging");
+    note.message = QStringLiteral("日志缓冲已满，丢弃 %1 条日志（累计 %2 条）")
+                       .arg(dropped - m_reportedDropped)
+                       .arg(dropped);
+    const QByteArray line = format(note);
+    if (m_consoleEnabled.load(std::memory_order_relaxed))
+        qWarning().noquote() << QString::fromUtf8(line).trimmed();
+    appendLocked(line);
+    m_reportedDropped = dropped;
+}
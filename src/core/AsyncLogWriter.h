@@ -0,0 +1,134 @@
+#ifndef ASYNCLOGWRITER_H
+#define ASYNCLOGWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ErrorHandler.h"
+#include "LogRingBuffer.h"
+
+/**
+ * @brief 后台批量日志写出器
+ * @details 生产者只向无锁环形缓冲入队；写线程按时间间隔或累计条数批量格式化、
+ *          写文件并刷新，按配置的最大文件大小轮转。缓冲满时丢弃新条目并计数，
+ *          丢弃数会在下一批中作为一条警告写入日志。写线程排空缓冲时顺带把条目
+ *          转交界面缓冲，生产者不接触界面锁。
+ */
+class AsyncLogWriter
+{
+public:
+    /**
+     * @param capacity 环形缓冲容量（条）
+     * @param flushIntervalMs 写线程最长休眠时间
+     * @param flushBatch 累计多少条后提前唤醒写线程
+     */
+    explicit AsyncLogWriter(size_t capacity = 8192, int flushIntervalMs = 200, int flushBatch = 256);
+    ~AsyncLogWriter();
+
+    AsyncLogWriter(const AsyncLogWriter &) = delete;
+    AsyncLogWriter &operator=(const AsyncLogWriter &) = delete;
+
+    /**
+     * @brief 入队一条日志（不阻塞）
+     * @param urgent 为 true 时立即唤醒写线程（错误、严重错误）
+     * @return 缓冲已满被丢弃时返回 false
+     */
+    bool enqueue(LogRecord &&record, bool urgent = false);
+
+    /**
+     * @brief 等待此前入队的日志全部写出并刷新到磁盘
+     */
+    void flush();
+
+    /**
+     * @brief 崩溃路径上的写出，异步信号安全：不加锁、不分配、不格式化
+     * @details 只用 write 把预先格式化的一行追加到日志文件（及控制台）；
+     *          写线程此前已按批刷新到磁盘，尚在环形缓冲中的条目不再写出
+     * @param line 以换行结尾的完整日志行（静态字符串）
+     */
+    void writeFromCrashHandler(const char *line) noexcept;
+
+    /**
+     * @brief 设置界面缓冲容量（条），0 表示不转交界面
+     */
+    void setUiCapacity(int entries);
+
+    /**
+     * @brief 取走界面缓冲中的全部条目
+     * @return 自上次取走以来因界面缓冲满被丢弃的条数
+     */
+    quint64 takeUiRecords(std::vector<LogRecord> &out);
+
+    void setFilePath(const QString &path);
+    QString filePath() const;
+    void setMaxFileSize(qint64 bytes);
+    void setFileOutputEnabled(bool enable);
+    void setConsoleOutputEnabled(bool enable);
+
+    LogStats stats() const;
+
+    static QByteArray format(const LogRecord &record);
+
+private:
+    void run();
+    // 在持有 m_fileMutex 时调用
+    size_t drainLocked(size_t limit);
+    void appendLocked(const QByteArray &line);
+    void writePendingLocked();
+    bool openLocked();
+    void closeLocked();
+    void rotateLocked();
+    void reportDroppedLocked();
+
+    LogRingBuffer<LogRecord> m_ring;
+    const int m_flushIntervalMs;
+    const int m_flushBatch;
+
+    // 写线程唤醒与 flush() 同步
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    bool m_wakeRequested{false};
+    bool m_stop{false};
+    quint64 m_flushRequests{0};
+    quint64 m_flushGeneration{0};
+    std::atomic<int> m_sinceWake{0};
+
+    // 文件状态，仅由写线程（或崩溃处理）在持锁时访问
+    mutable std::mutex m_fileMutex;
+    QFile m_file;
+    QString m_filePath;
+    QByteArray m_pending;
+    qint64 m_fileBytes{0};
+    qint64 m_maxFileSize{10 * 1024 * 1024};
+    bool m_fileEnabled{true};
+    bool m_openFailed{false};
+    quint64 m_reportedDropped{0};
+    // 与 m_file 同一文件的追加描述符，仅供崩溃处理 write 使用
+    std::atomic<int> m_crashFd{-1};
+
+    // 界面缓冲：只有写线程写入，界面线程取走
+    std::mutex m_uiMutex;
+    std::deque<LogRecord> m_uiPending;
+    std::atomic<int> m_uiCapacity{0};
+    quint64 m_uiDropped{0};
+
+    std::atomic<bool> m_consoleEnabled{true};
+    std::atomic<quint64> m_enqueued{0};
+    std::atomic<quint64> m_written{0};
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<quint64> m_flushes{0};
+    std::atomic<quint64> m_rotations{0};
+
+    std::thread m_thread;
+};
+
+#endif // ASYNCLOGWRITER_H
@@ -0,0 +1,79 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 有界生产者/消费者队列
+ * @details 生产者在队列满时阻塞（背压），消费者非阻塞地一次取走全部元素；
+ *          close() 后生产者不再阻塞，已入队的元素仍可取出。
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+    /**
+     * @brief 入队，队列满时等待消费者取走元素
+     * @param item 元素（移动入队）
+     * @param wasEmpty 入队前队列是否为空，可用于只在需要时通知消费者
+     * @return 队列已关闭时返回 false，元素被丢弃
+     */
+    bool push(T &&item, bool *wasEmpty = nullptr)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this]()
+                       { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+            return false;
+        if (wasEmpty)
+            *wasEmpty = m_items.empty();
+        m_items.push_back(std::move(item));
+        return true;
+    }
+
+    /**
+     * @brief 取走当前所有元素（不阻塞）
+     * @return 取出的元素个数
+     */
+    size_t drain(std::vector<T> &out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t n = m_items.size();
+        for (T &item : m_items)
+            out.push_back(std::move(item));
+        m_items.clear();
+        m_notFull.notify_all();
+        return n;
+    }
+
+    /**
+     * @brief 关闭队列并唤醒所有等待的生产者
+     */
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notFull.notify_all();
+    }
+
+    bool isClosed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::deque<T> m_items;
+    const size_t m_capacity;
+    bool m_closed{false};
+};
+
+#endif // BOUNDEDQUEUE_H
@@ -1,9 +1,34 @@
 #include "ErrorHandler.h"
+#include "AsyncLogWriter.h"
 #include <QCoreApplication>
 #include <QDir>
-#include <QDebug>
-#include <QIODevice>
-#include <QTextStream>
+#include <algorithm>
+#include <csignal>
+#include <utility>
+
+namespace
+{
+    // 信号处理函数只能访问全局状态
+    std::atomic<AsyncLogWriter *> g_crashWriter{nullptr};
+
+    // 预先格式化的终止说明：信号处理中不能分配内存或格式化
+    const char *fatalSignalLine(int signal)
+    {
+        switch (signal)
+        {
+        case SIGSEGV:
+            return "[CRITICAL] [Logging] Fatal signal SIGSEGV, process terminating\n";
+        case SIGABRT:
+            return "[CRITICAL] [Logging] Fatal signal SIGABRT, process terminating\n";
+        case SIGFPE:
+            return "[CRITICAL] [Logging] Fatal signal SIGFPE, process terminating\n";
+        case SIGILL:
+            return "[CRITICAL] [Logging] Fatal signal SIGILL, process terminating\n";
+        default:
+            return "[CRITICAL] [Logging] Fatal signal, process terminating\n";
+        }
+    }
+}
 
 /**
  * @brief 获取错误处理器的单例实例
@@ -19,8 +44,7 @@ ErrorHandler &ErrorHandler::instance()
  * @brief 构造函数，初始化默认设置
  */
 ErrorHandler::ErrorHandler()
-    : m_consoleOutputEnabled(true),
-      m_logLevel(ErrorType::INFO)
+    : m_writer(std::make_unique<AsyncLogWriter>())
 {
     // 设置默认日志文件路径（应用程序目录下的logs文件夹）
     QString appDir = QCoreApplication::applicationDirPath();
@@ -35,7 +59,35 @@ ErrorHandler::ErrorHandler()
 
     // 设置日志文件名称（当前日期）
     QString currentDate = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-    m_logFilePath = logDir + "/app_" + currentDate + ".log";
+    m_writer->setFilePath(logDir + "/app_" + currentDate + ".log");
+
+    // 崩溃时在日志末尾留下终止说明
+    g_crashWriter.store(m_writer.get());
+    std::signal(SIGSEGV, &ErrorHandler::handleFatalSignal);
+    std::signal(SIGABRT, &ErrorHandler::handleFatalSignal);
+    std::signal(SIGFPE, &ErrorHandler::handleFatalSignal);
+    std::signal(SIGILL, &ErrorHandler::handleFatalSignal);
+}
+
+/**
+ * @brief 析构函数，停止写线程前写出全部缓冲日志
+ */
+ErrorHandler::~ErrorHandler()
+{
+    g_crashWriter.store(nullptr);
+    m_writer.reset();
+}
+
+void ErrorHandler::handleFatalSignal(int signal)
+{
+    static std::atomic<bool> entered{false};
+    if (!entered.exchange(true))
+    {
+        if (AsyncLogWriter *writer = g_crashWriter.load())
+            writer->writeFromCrashHandler(fatalSignalLine(signal));
+    }
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
 }
 
 /**
@@ -44,15 +96,26 @@ ErrorHandler::ErrorHandler()
  */
 void ErrorHandler::setLogFilePath(const QString &logPath)
 {
-    QMutexLocker locker(&m_mutex);
+    // 写线程先写完旧文件中的待写内容再切换
+    m_writer->setFilePath(logPath);
+}
 
-    // 如果文件已打开，先关闭
-    if (m_logFile.isOpen())
-    {
-        m_logFile.close();
-    }
+/**
+ * @brief 设置单个日志文件的最大字节数
+ * @param bytes 最大字节数，<= 0 表示不轮转
+ */
+void ErrorHandler::setMaxLogSize(qint64 bytes)
+{
+    m_writer->setMaxFileSize(bytes);
+}
 
-    m_logFilePath = logPath;
+/**
+ * @brief 设置是否写日志文件
+ * @param enable 是否启用文件输出
+ */
+void ErrorHandler::setFileOutputEnabled(bool enable)
+{
+    m_writer->setFileOutputEnabled(enable);
 }
 
 /**
@@ -61,7 +124,7 @@ void ErrorHandler::setLogFilePath(const QString &logPath)
  */
 void ErrorHandler::setConsoleOutputEnabled(bool enable)
 {
-    m_consoleOutputEnabled = enable;
+    m_writer->setConsoleOutputEnabled(enable);
 }
 
 /**
@@ -70,7 +133,32 @@ void ErrorHandler::setConsoleOutputEnabled(bool enable)
  */
 void ErrorHandler::setLogLevel(ErrorType level)
 {
-    m_logLevel = level;
+    s_minSeverity.store(logSeverity(level), std::memory_order_relaxed);
+}
+
+/**
+ * @brief 按名称设置日志级别
+ * @param name 级别名称（不区分大小写）
+ * @return 是否识别该名称
+ */
+bool ErrorHandler::setLogLevel(const QString &name)
+{
+    const QString key = name.trimmed().toUpper();
+    static const std::pair<const char *, ErrorType> levels[] = {
+        {"DEBUG", ErrorType::DEBUG},
+        {"INFO", ErrorType::INFO},
+        {"WARNING", ErrorType::WARNING},
+        {"ERROR", ErrorType::ERROR},
+        {"CRITICAL", ErrorType::CRITICAL}};
+    for (const auto &level : levels)
+    {
+        if (key == QLatin1String(level.first))
+        {
+            setLogLevel(level.second);
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
@@ -83,49 +171,20 @@ void ErrorHandler::setLogLevel(ErrorType level)
 void ErrorHandler::log(ErrorType type, const QString &message,
                        const QString &module, int code)
 {
-    // 检查日志级别
-    if (type > m_logLevel)
+    // 检查日志级别（直接调用 log() 时同样生效；宏在求值参数前已检查过）
+    if (!isEnabled(type))
     {
         return;
     }
 
-    // 格式化日志条目
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss.zzz");
-    QString logType = errorTypeToString(type);
-    QString logEntry = QString("[%1] [%2] [%3] %4").arg(timestamp, logType, module, message);
-
-    // 如果有错误代码，添加到日志
-    if (code != 0)
-    {
-        logEntry += QString(" [Code: %1]").arg(code);
-    }
-
-    // 线程安全地写入日志文件
-    writeToLogFile(logEntry);
-
-    // 如果启用了控制台输出，打印到控制台
-    if (m_consoleOutputEnabled)
-    {
-        switch (type)
-        {
-        case ErrorType::INFO:
-            qInfo().noquote() << logEntry;
-            break;
-        case ErrorType::WARNING:
-            qWarning().noquote() << logEntry;
-            break;
-        case ErrorType::ERROR:
-        case ErrorType::CRITICAL:
-            qCritical().noquote() << logEntry;
-            break;
-        case ErrorType::DEBUG:
-            qDebug().noquote() << logEntry;
-            break;
-        }
-    }
-
-    // 发出信号，通知观察者
-    emit errorLogged(type, message, module, code);
+    // 只入队，时间戳格式化、控制台输出、写盘和转交界面都在后台写线程完成
+    LogRecord record;
+    record.timestampMs = QDateTime::currentMSecsSinceEpoch();
+    record.type = type;
+    record.module = module;
+    record.message = message;
+    record.code = code;
+    m_writer->enqueue(std::move(record), type == ErrorType::ERROR || type == ErrorType::CRITICAL);
 }
 
 /**
@@ -182,65 +241,39 @@ void ErrorHandler::debug(const QString &message, const QString &module)
 }
 
 /**
- * @brief 将错误类型转换为字符串
- * @param type 错误类型
- * @return 错误类型的字符串表示
+ * @brief 阻塞到此前记录的日志全部写入磁盘
  */
-QString ErrorHandler::errorTypeToString(ErrorType type) const
+void ErrorHandler::flush()
 {
-    switch (type)
-    {
-    case ErrorType::INFO:
-        return "INFO";
-    case ErrorType::WARNING:
-        return "WARNING";
-    case ErrorType::ERROR:
-        return "ERROR";
-    case ErrorType::CRITICAL:
-        return "CRITICAL";
-    case ErrorType::DEBUG:
-        return "DEBUG";
-    default:
-        return "UNKNOWN";
-    }
+    m_writer->flush();
 }
 
 /**
- * @brief 写入日志到文件
- * @param logEntry 日志条目
+ * @brief 获取日志写出统计
+ * @return 入队、写出、丢弃、刷新与轮转计数
  */
-void ErrorHandler::writeToLogFile(const QString &logEntry)
+LogStats ErrorHandler::stats() const
 {
-    QMutexLocker locker(&m_mutex);
-
-    // 打开日志文件（如果未打开）
-    if (!m_logFile.isOpen())
-    {
-        m_logFile.setFileName(m_logFilePath);
-        if (!m_logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
-        {
-            // 如果无法打开日志文件，只能输出到控制台
-            qWarning() << "Failed to open log file:" << m_logFilePath;
-            return;
-        }
-    }
-
-    // 写入日志条目
-    QTextStream out(&m_logFile);
-    out << logEntry << Qt::endl;
-    out.flush();
-
-    // 检查文件大小，防止日志文件过大
-    if (m_logFile.size() > 10 * 1024 * 1024) // 10MB
-    {
-        m_logFile.close();
+    return m_writer->stats();
+}
 
-        // 创建新的日志文件，使用时间戳作为后缀
-        QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss");
-        QString backupPath = m_logFilePath + "." + timestamp + ".bak";
+/**
+ * @brief 设置界面日志缓冲容量
+ * @param entries 最多保留的条数，0 表示关闭
+ */
+void ErrorHandler::setUiBufferCapacity(int entries)
+{
+    m_writer->setUiCapacity(entries);
+}
 
-        QFile::rename(m_logFilePath, backupPath);
-    }
+/**
+ * @brief 取走界面缓冲中的全部日志
+ * @param out 追加到该数组末尾
+ * @return 自上次取走以来被丢弃的条数
+ */
+quint64 ErrorHandler::takeUiEntries(std::vector<LogRecord> &out)
+{
+    return m_writer->takeUiRecords(out);
 }
 
 // 为了Qt的信号槽系统，需要包含这个宏
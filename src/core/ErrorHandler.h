@@ -4,9 +4,11 @@
 #include <QString>
 #include <QObject>
 #include <QDateTime>
-#include <QFile>
-#include <QTextStream>
-#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class AsyncLogWriter;
 
 /**
  * @brief 错误类型枚举
@@ -20,9 +22,60 @@ enum class ErrorType
     DEBUG
 };
 
+/**
+ * @brief 日志严重程度（DEBUG < INFO < WARNING < ERROR < CRITICAL）
+ * @details ErrorType 的枚举顺序不代表严重程度，级别比较统一经过此函数
+ */
+constexpr int logSeverity(ErrorType type)
+{
+    return type == ErrorType::DEBUG     ? 0
+           : type == ErrorType::INFO    ? 1
+           : type == ErrorType::WARNING ? 2
+           : type == ErrorType::ERROR   ? 3
+                                        : 4;
+}
+
+/**
+ * @brief 编译期最低日志级别（logSeverity 数值），低于该级别的 LOG_* 调用整体被编译器消除
+ * @details 默认 Release（NDEBUG）构建去掉 DEBUG，可通过编译选项覆盖
+ */
+#ifndef LOG_COMPILE_MIN_SEVERITY
+#ifdef NDEBUG
+#define LOG_COMPILE_MIN_SEVERITY 1
+#else
+#define LOG_COMPILE_MIN_SEVERITY 0
+#endif
+#endif
+
+/**
+ * @brief 一条日志（时间戳等格式化推迟到使用方）
+ */
+struct LogRecord
+{
+    qint64 timestampMs{0};
+    ErrorType type{ErrorType::INFO};
+    QString module;
+    QString message;
+    int code{0};
+};
+
+/**
+ * @brief 日志写出统计
+ */
+struct LogStats
+{
+    quint64 enqueued{0};  // 进入缓冲的条数
+    quint64 written{0};   // 已写出的条数
+    quint64 dropped{0};   // 缓冲满被丢弃的条数
+    quint64 flushes{0};   // 批量刷新次数
+    quint64 rotations{0}; // 文件轮转次数
+};
+
 /**
  * @brief 错误处理类
- * @details 单例模式，用于统一管理和记录应用程序中的错误和日志
+ * @details 单例模式，用于统一管理和记录应用程序中的错误和日志。
+ *          调用线程只把日志放入无锁缓冲，格式化与磁盘 I/O 由后台写线程批量完成；
+ *          进程收到致命信号时只用 write 追加一条预先格式化的终止说明（异步信号安全）。
  */
 class ErrorHandler : public QObject
 {
@@ -40,6 +93,16 @@ public:
      */
     void setLogFilePath(const QString &logPath);
 
+    /**
+     * @brief 设置单个日志文件的最大字节数，超过后轮转为 .bak（<= 0 表示不轮转）
+     */
+    void setMaxLogSize(qint64 bytes);
+
+    /**
+     * @brief 设置是否写日志文件
+     */
+    void setFileOutputEnabled(bool enable);
+
     /**
      * @brief 设置是否在控制台显示日志
      * @param enable 是否启用控制台输出
@@ -52,6 +115,22 @@ public:
      */
     void setLogLevel(ErrorType level);
 
+    /**
+     * @brief 按名称设置日志级别（DEBUG / INFO / WARNING / ERROR / CRITICAL，不区分大小写）
+     * @return 名称无法识别时返回 false，级别不变
+     */
+    bool setLogLevel(const QString &name);
+
+    /**
+     * @brief 该级别的日志当前是否会被记录
+     * @details 只读一个原子变量，不访问单例；LOG_* 宏在求值参数之前调用
+     */
+    static bool isEnabled(ErrorType type)
+    {
+        return logSeverity(type) >= LOG_COMPILE_MIN_SEVERITY &&
+               logSeverity(type) >= s_minSeverity.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief 记录一条日志
      * @param type 错误类型
@@ -100,44 +179,60 @@ public:
      */
     void debug(const QString &message, const QString &module = "General");
 
-signals:
     /**
-     * @brief 当新的错误被记录时发出的信号
-     * @param type 错误类型
-     * @param message 错误消息
-     * @param module 模块名称
-     * @param code 错误代码
+     * @brief 阻塞到此前记录的日志全部写入磁盘
+     */
+    void flush();
+
+    /**
+     * @brief 日志写出统计（含丢弃计数）
      */
-    void errorLogged(ErrorType type, const QString &message,
-                     const QString &module, int code);
+    LogStats stats() const;
+
+    /**
+     * @brief 设置界面日志缓冲容量（条），0 表示不为界面保留日志
+     * @details 日志不再逐条发信号，由后台写线程在排空缓冲时转交界面缓冲，调用 log()
+     *          的线程不再加锁；界面按固定刷新率调用 takeUiEntries() 批量取走，超出容量时丢弃最旧的条目
+     */
+    void setUiBufferCapacity(int entries);
+
+    /**
+     * @brief 取走界面缓冲中的全部日志（线程安全）
+     * @return 自上次取走以来因缓冲满被丢弃的条数
+     */
+    quint64 takeUiEntries(std::vector<LogRecord> &out);
 
 private:
     // 私有构造函数（单例模式）
     ErrorHandler();
+    ~ErrorHandler() override;
 
     // 禁止拷贝和赋值
     ErrorHandler(const ErrorHandler &) = delete;
     ErrorHandler &operator=(const ErrorHandler &) = delete;
 
-    // 将错误类型转换为字符串
-    QString errorTypeToString(ErrorType type) const;
-
-    // 写入日志到文件
-    void writeToLogFile(const QString &logEntry);
+    // 致命信号处理：写出终止说明后按默认方式终止
+    static void handleFatalSignal(int signal);
 
     // 成员变量
-    QString m_logFilePath;
-    QFile m_logFile;
-    QMutex m_mutex; // 用于线程安全
-    bool m_consoleOutputEnabled;
-    ErrorType m_logLevel;
+    std::unique_ptr<AsyncLogWriter> m_writer;
+    static inline std::atomic<int> s_minSeverity{logSeverity(ErrorType::INFO)};
 };
 
-// 便捷宏定义
-#define LOG_INFO(msg, module) ErrorHandler::instance().info(msg, module)
-#define LOG_WARNING(msg, module, code) ErrorHandler::instance().warning(msg, module, code)
-#define LOG_ERROR(msg, module, code) ErrorHandler::instance().error(msg, module, code)
-#define LOG_CRITICAL(msg, module, code) ErrorHandler::instance().critical(msg, module, code)
-#define LOG_DEBUG(msg, module) ErrorHandler::instance().debug(msg, module)
+// 便捷宏定义：先判断级别，未启用时 msg / module 表达式（含 .arg() 链）都不会求值；
+// 低于 LOG_COMPILE_MIN_SEVERITY 的级别判断为编译期常量，整条语句被消除
+#define LOG_AT(type, msg, module, code)                                   \
+    do                                                                    \
+    {                                                                     \
+        if (logSeverity(type) >= LOG_COMPILE_MIN_SEVERITY &&              \
+            ErrorHandler::isEnabled(type))                                \
+            ErrorHandler::instance().log(type, (msg), (module), (code));  \
+    } while (0)
+
+#define LOG_INFO(msg, module) LOG_AT(ErrorType::INFO, msg, module, 0)
+#define LOG_WARNING(msg, module, code) LOG_AT(ErrorType::WARNING, msg, module, code)
+#define LOG_ERROR(msg, module, code) LOG_AT(ErrorType::ERROR, msg, module, code)
+#define LOG_CRITICAL(msg, module, code) LOG_AT(ErrorType::CRITICAL, msg, module, code)
+#define LOG_DEBUG(msg, module) LOG_AT(ErrorType::DEBUG, msg, module, 0)
 
 #endif // ERRORHANDLER_H
\ No newline at end of file
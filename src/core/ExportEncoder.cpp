@@ -0,0 +1,245 @@
+#include "ExportEncoder.h"
+#include "AppConfig.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // QOI（Quite OK Image Format）操作码，见 https://qoiformat.org/qoi-specification.pdf
+    constexpr quint8 kQoiOpIndex = 0x00;
+    constexpr quint8 kQoiOpDiff = 0x40;
+    constexpr quint8 kQoiOpLuma = 0x80;
+    constexpr quint8 kQoiOpRun = 0xc0;
+    constexpr quint8 kQoiOpRgb = 0xfe;
+    constexpr quint8 kQoiOpRgba = 0xff;
+
+    struct QoiPixel
+    {
+        quint8 r{0}, g{0}, b{0}, a{255};
+        bool operator==(const QoiPixel &o) const { return r == o.r && g == o.g && b == o.b && a == o.a; }
+    };
+
+    void putU32(std::vector<quint8> &out, quint32 v)
+    {
+        out.push_back(static_cast<quint8>(v >> 24));
+        out.push_back(static_cast<quint8>(v >> 16));
+        out.push_back(static_cast<quint8>(v >> 8));
+        out.push_back(static_cast<quint8>(v));
+    }
+
+    bool isOpaque(const QImage &image)
+    {
+        // renderResult 的输出为 ARGB32 但不含透明像素
+        if (!image.hasAlphaChannel())
+            return true;
+        if (image.format() != QImage::Format_ARGB32 && image.format() != QImage::Format_ARGB32_Premultiplied)
+            return false;
+        for (int y = 0; y < image.height(); ++y)
+        {
+            const QRgb *row = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x = 0; x < image.width(); ++x)
+            {
+                if (qAlpha(row[x]) != 255)
+                    return false;
+            }
+        }
+        return true;
+    }
+}
+
+ExportEncoder::Options ExportEncoder::optionsFromConfig()
+{
+    const AppConfig &config = AppConfig::instance();
+    Options options;
+    options.imageFormat = (config.exportImageFormat() == QLatin1String("qoi")) ? ImageFormat::Qoi : ImageFormat::Png;
+    options.pngCompression = config.exportPngCompression();
+    options.maskFormat = (config.exportMaskFormat() == QLatin1String("rgba")) ? MaskFormat::Rgba : MaskFormat::LabelMap;
+    return options;
+}
+
+QString ExportEncoder::imageSuffix() const
+{
+    return (m_options.imageFormat == ImageFormat::Qoi) ? QStringLiteral("qoi") : QStringLiteral("png");
+}
+
+QString ExportEncoder::maskSuffix() const
+{
+    // 标签图始终为调色板 PNG（大面积背景压缩极快）；彩色掩码跟随结果图格式
+    return (m_options.maskFormat == MaskFormat::LabelMap) ? QStringLiteral("png") : imageSuffix();
+}
+
+bool ExportEncoder::writeImage(const QImage &image, const QString &path, QString *error) const
+{
+    if (image.isNull())
+    {
+        if (error)
+            *error = QStringLiteral("Empty image: %1").arg(path);
+        return false;
+    }
+    // 不透明图按 3 通道编码，比 ARGB32 少写 1/4 数据
+    const QImage rgb = isOpaque(image) ? image.convertToFormat(QImage::Format_RGB888) : image;
+    return encode(rgb, m_options.imageFormat, path, error);
+}
+
+bool ExportEncoder::writeMask(const QImage &labelMask, const QString &path, QString *error) const
+{
+    if (labelMask.isNull())
+    {
+        if (error)
+            *error = QStringLiteral("Empty mask: %1").arg(path);
+        return false;
+    }
+    if (m_options.maskFormat == MaskFormat::LabelMap && labelMask.format() == QImage::Format_Indexed8)
+        return encode(labelMask, ImageFormat::Png, path, error);
+    return encode(labelMask.convertToFormat(QImage::Format_ARGB32), m_options.imageFormat, path, error);
+}
+
+bool ExportEncoder::encode(const QImage &image, ImageFormat format, const QString &path, QString *error) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok = false;
+    if (format == ImageFormat::Qoi)
+    {
+        ok = writeQoi(image, path, error);
+    }
+    else
+    {
+        QImageWriter writer(path, "png");
+        writer.setCompression(m_options.pngCompression);
+        ok = writer.write(image);
+        if (!ok && error)
+            *error = QStringLiteral("Failed to save image: %1 (%2)").arg(path, writer.errorString());
+    }
+
+    if (ok)
+    {
+        m_nsecs += timer.nsecsElapsed();
+        m_files += 1;
+        m_pixels += static_cast<qint64>(image.width()) * image.height();
+        m_bytes += QFileInfo(path).size();
+    }
+    return ok;
+}
+
+bool ExportEncoder::writeQoi(const QImage &image, const QString &path, QString *error)
+{
+    const bool alpha = image.hasAlphaChannel();
+    const QImage src = image.convertToFormat(alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+    const int channels = alpha ? 4 : 3;
+    const int w = src.width();
+    const int h = src.height();
+
+    std::vector<quint8> out;
+    out.reserve(14 + static_cast<size_t>(w) * static_cast<size_t>(h) * (channels + 1) + 8);
+    out.insert(out.end(), {'q', 'o', 'i', 'f'});
+    putU32(out, static_cast<quint32>(w));
+    putU32(out, static_cast<quint32>(h));
+    out.push_back(static_cast<quint8>(channels));
+    out.push_back(0); // sRGB
+
+    std::array<QoiPixel, 64> index{};
+    for (QoiPixel &p : index)
+        p.a = 0;
+    QoiPixel prev;
+    int run = 0;
+    const qint64 last = static_cast<qint64>(w) * h - 1;
+    qint64 pos = 0;
+
+    for (int y = 0; y < h; ++y)
+    {
+        const quint8 *row = src.constScanLine(y);
+        for (int x = 0; x < w; ++x, ++pos)
+        {
+            QoiPixel px;
+            const quint8 *p = row + static_cast<size_t>(x) * channels;
+            px.r = p[0];
+            px.g = p[1];
+            px.b = p[2];
+            px.a = alpha ? p[3] : 255;
+
+            if (px == prev)
+            {
+                ++run;
+                if (run == 62 || pos == last)
+                {
+                    out.push_back(static_cast<quint8>(kQoiOpRun | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                out.push_back(static_cast<quint8>(kQoiOpRun | (run - 1)));
+                run = 0;
+            }
+
+            const int hash = (px.r * 3 + px.g * 5 + px.b * 7 + px.a * 11) % 64;
+            if (index[hash] == px)
+            {
+                out.push_back(static_cast<quint8>(kQoiOpIndex | hash));
+            }
+            else
+            {
+                index[hash] = px;
+                if (px.a == prev.a)
+                {
+                    const int vr = static_cast<qint8>(px.r - prev.r);
+                    const int vg = static_cast<qint8>(px.g - prev.g);
+                    const int vb = static_cast<qint8>(px.b - prev.b);
+                    const int vgr = vr - vg;
+                    const int vgb = vb - vg;
+                    if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+                    {
+                        out.push_back(static_cast<quint8>(kQoiOpDiff | ((vr + 2) << 4) | ((vg + 2) << 2) | (vb + 2)));
+                    }
+                    else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+                    {
+                        out.push_back(static_cast<quint8>(kQoiOpLuma | (vg + 32)));
+                        out.push_back(static_cast<quint8>(((vgr + 8) << 4) | (vgb + 8)));
+                    }
+                    else
+                    {
+                        out.insert(out.end(), {kQoiOpRgb, px.r, px.g, px.b});
+                    }
+                }
+                else
+                {
+                    out.insert(out.end(), {kQoiOpRgba, px.r, px.g, px.b, px.a});
+                }
+            }
+            prev = px;
+        }
+    }
+    out.insert(out.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(reinterpret_cast<const char *>(out.data()), static_cast<qint64>(out.size())) != static_cast<qint64>(out.size()))
+    {
+        if (error)
+            *error = QStringLiteral("Failed to save image: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+QString ExportEncoder::throughputSummary() const
+{
+    const double seconds = m_nsecs.load() / 1e9;
+    const double mpix = m_pixels.load() / 1e6;
+    const double mb = m_bytes.load() / (1024.0 * 1024.0);
+    // 耗时为各编码线程之和，速率即单线程编码吞吐
+    return QStringLiteral("%1 files, %2 MPix, %3 MPix/s, %4 MB/s per thread")
+        .arg(m_files.load())
+        .arg(mpix, 0, 'f', 1)
+        .arg(seconds > 0.0 ? mpix / seconds : 0.0, 0, 'f', 1)
+        .arg(seconds > 0.0 ? mb / seconds : 0.0, 0, 'f', 1);
+}
@@ -0,0 +1,368 @@
+#include "PredictionWriter.h"
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace
+{
+    void appendJsonString(QByteArray &out, const QString &text)
+    {
+        out.append('"');
+        const QByteArray utf8 = text.toUtf8();
+        for (char c : utf8)
+        {
+            switch (c)
+            {
+            case '"':
+                out.append("\\\"");
+                break;
+            case '\\':
+                out.append("\\\\");
+                break;
+            case '\n':
+                out.append("\\n");
+                break;
+            case '\r':
+                out.append("\\r");
+                break;
+            case '\t':
+                out.append("\\t");
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                    out.append(QByteArray("\\u00") + QByteArray::number(static_cast<unsigned char>(c), 16).rightJustified(2, '0'));
+                else
+                    out.append(c);
+            }
+        }
+        out.append('"');
+    }
+
+    void appendNumber(QByteArray &out, double value)
+    {
+        out.append(QByteArray::number(value, 'g', 7));
+    }
+
+    // COCO 多边形格式：每个轮廓为 [x1,y1,x2,y2,...]
+    void appendContours(QByteArray &out, const QVector<QPolygonF> &contours)
+    {
+        out.append('[');
+        for (int i = 0; i < contours.size(); ++i)
+        {
+            if (i > 0)
+                out.append(',');
+            out.append('[');
+            const QPolygonF &poly = contours[i];
+            for (int k = 0; k < poly.size(); ++k)
+            {
+                if (k > 0)
+                    out.append(',');
+                out.append(QByteArray::number(poly[k].x(), 'f', 1));
+                out.append(',');
+                out.append(QByteArray::number(poly[k].y(), 'f', 1));
+            }
+            out.append(']');
+        }
+        out.append(']');
+    }
+
+    // COCO 多边形中列出的每个环都按前景填充，孔洞无法表达：只保留外轮廓（鞋带有向面积为正）
+    QJsonArray cocoOuterRings(const QJsonArray &contours)
+    {
+        QJsonArray outer;
+        for (const QJsonValue &ring : contours)
+        {
+            const QJsonArray xy = ring.toArray();
+            const int n = xy.size() / 2;
+            double twiceArea = 0.0;
+            for (int i = 0; i < n; ++i)
+            {
+                const int j = (i + 1) % n;
+                twiceArea += xy.at(2 * i).toDouble() * xy.at(2 * j + 1).toDouble() -
+                             xy.at(2 * j).toDouble() * xy.at(2 * i + 1).toDouble();
+            }
+            if (n >= 3 && twiceArea > 0.0)
+                outer.append(xy);
+        }
+        return outer;
+    }
+
+    bool writeAll(QFile &file, const QByteArray &data)
+    {
+        return file.write(data) == data.size();
+    }
+}
+
+PredictionWriter::PredictionWriter(int flushEveryRecords, int flushIntervalMs)
+    : m_flushEveryRecords(std::max(1, flushEveryRecords)), m_flushIntervalMs(std::max(0, flushIntervalMs))
+{
+}
+
+PredictionWriter::~PredictionWriter()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool PredictionWriter::open(const QString &jsonlPath, QString *error)
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(jsonlPath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if (error)
+            *error = QStringLiteral("Failed to open %1: %2").arg(jsonlPath, m_file.errorString());
+        return false;
+    }
+    m_pending = 0;
+    m_records = 0;
+    m_failed = false;
+    m_sinceFlush.start();
+    return true;
+}
+
+QByteArray PredictionWriter::serialize(const Record &record)
+{
+    QByteArray out;
+    out.reserve(256 + static_cast<int>(record.predictions.size()) * 160);
+    const bool hasSpacing = record.pixelSpacing.width() > 0.0 && record.pixelSpacing.height() > 0.0;
+    const double mm2PerPixel = hasSpacing ? record.pixelSpacing.width() * record.pixelSpacing.height() : 0.0;
+
+    out.append("{\"image\":");
+    appendJsonString(out, record.imagePath);
+    if (record.frameIndex >= 0)
+    {
+        out.append(",\"frame\":");
+        out.append(QByteArray::number(record.frameIndex));
+    }
+    out.append(",\"width\":");
+    out.append(QByteArray::number(record.imageSize.width()));
+    out.append(",\"height\":");
+    out.append(QByteArray::number(record.imageSize.height()));
+    if (hasSpacing)
+    {
+        out.append(",\"pixel_spacing_mm\":[");
+        appendNumber(out, record.pixelSpacing.width());
+        out.append(',');
+        appendNumber(out, record.pixelSpacing.height());
+        out.append(']');
+    }
+    if (!record.maskFile.isEmpty())
+    {
+        out.append(",\"mask\":");
+        appendJsonString(out, record.maskFile);
+    }
+    out.append(",\"predictions\":[");
+    bool first = true;
+    for (const Prediction &p : record.predictions)
+    {
+        if (!first)
+            out.append(',');
+        first = false;
+        out.append("{\"class_id\":");
+        out.append(QByteArray::number(p.classId));
+        out.append(",\"class_name\":");
+        appendJsonString(out, p.className);
+        out.append(",\"score\":");
+        appendNumber(out, p.score);
+        out.append(",\"bbox\":[");
+        appendNumber(out, p.bbox.left());
+        out.append(',');
+        appendNumber(out, p.bbox.top());
+        out.append(',');
+        appendNumber(out, p.bbox.right());
+        out.append(',');
+        appendNumber(out, p.bbox.bottom());
+        out.append(']');
+        if (p.areaPixels > 0.0)
+        {
+            out.append(",\"area_px\":");
+            appendNumber(out, p.areaPixels);
+            if (hasSpacing)
+            {
+                out.append(",\"area_mm2\":");
+                appendNumber(out, p.areaPixels * mm2PerPixel);
+            }
+        }
+        if (!p.contours.isEmpty())
+        {
+            out.append(",\"polygon_area_px\":");
+            appendNumber(out, p.polygonAreaPixels);
+            out.append(",\"contours\":");
+            appendContours(out, p.contours);
+        }
+        out.append('}');
+    }
+    out.append("]}\n");
+    return out;
+}
+
+bool PredictionWriter::append(const Record &record)
+{
+    // 序列化在锁外完成，锁内只做写入
+    const QByteArray line = serialize(record);
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen() || m_failed)
+        return false;
+    if (!writeAll(m_file, line))
+    {
+        m_failed = true;
+        return false;
+    }
+    ++m_records;
+    if (++m_pending >= m_flushEveryRecords || m_sinceFlush.elapsed() >= m_flushIntervalMs)
+    {
+        m_file.flush();
+        m_pending = 0;
+        m_sinceFlush.restart();
+    }
+    return true;
+}
+
+qint64 PredictionWriter::recordCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_records;
+}
+
+bool PredictionWriter::finish(const QString &cocoPath, QString *error)
+{
+    QString jsonlPath;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_file.isOpen())
+        {
+            if (error)
+                *error = QStringLiteral("Prediction file is not open");
+            return false;
+        }
+        jsonlPath = m_file.fileName();
+        m_file.flush();
+        m_file.close();
+        if (m_failed)
+        {
+            if (error)
+                *error = QStringLiteral("Failed to write %1").arg(jsonlPath);
+            return false;
+        }
+    }
+    if (cocoPath.isEmpty())
+        return true;
+    return writeCoco(jsonlPath, cocoPath, error);
+}
+
+bool PredictionWriter::writeCoco(const QString &jsonlPath, const QString &cocoPath, QString *error)
+{
+    // 两遍读取 JSONL：第一遍写 images 并收集类别，第二遍写 annotations；内存只保存一行
+    QFile in(jsonlPath);
+    QFile out(cocoPath);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        if (error)
+            *error = QStringLiteral("Failed to write COCO file: %1").arg(cocoPath);
+        return false;
+    }
+
+    bool ok = true;
+    QMap<int, QString> categories;
+    QByteArray chunk("{\"images\":[");
+    qint64 imageId = 0;
+    while (!in.atEnd())
+    {
+        const QJsonObject rec = QJsonDocument::fromJson(in.readLine()).object();
+        if (rec.isEmpty())
+            continue;
+        ++imageId;
+        QJsonObject image;
+        image["id"] = imageId;
+        image["file_name"] = rec.value("image").toString();
+        if (rec.contains("frame"))
+            image["frame"] = rec.value("frame").toInt();
+        image["width"] = rec.value("width").toInt();
+        image["height"] = rec.value("height").toInt();
+        if (imageId > 1)
+            chunk.append(',');
+        chunk.append(QJsonDocument(image).toJson(QJsonDocument::Compact));
+        for (const QJsonValue &v : rec.value("predictions").toArray())
+        {
+            const QJsonObject p = v.toObject();
+            categories.insert(p.value("class_id").toInt(), p.value("class_name").toString());
+        }
+        if (chunk.size() > (1 << 16))
+        {
+            ok = writeAll(out, chunk) && ok;
+            chunk.clear();
+        }
+    }
+
+    chunk.append("],\"annotations\":[");
+    in.seek(0);
+    imageId = 0;
+    qint64 annotationId = 0;
+    while (!in.atEnd())
+    {
+        const QJsonObject rec = QJsonDocument::fromJson(in.readLine()).object();
+        if (rec.isEmpty())
+            continue;
+        ++imageId;
+        for (const QJsonValue &v : rec.value("predictions").toArray())
+        {
+            const QJsonObject p = v.toObject();
+            const QJsonArray box = p.value("bbox").toArray();
+            const double x1 = box.at(0).toDouble();
+            const double y1 = box.at(1).toDouble();
+            const double w = box.at(2).toDouble() - x1;
+            const double h = box.at(3).toDouble() - y1;
+            QJsonObject ann;
+            ann["id"] = ++annotationId;
+            ann["image_id"] = imageId;
+            ann["category_id"] = p.value("class_id").toInt();
+            ann["bbox"] = QJsonArray{x1, y1, w, h};
+            ann["area"] = p.contains("area_px") ? p.value("area_px").toDouble() : w * h;
+            ann["score"] = p.value("score").toDouble();
+            ann["iscrowd"] = 0;
+            if (p.contains("area_mm2"))
+                ann["area_mm2"] = p.value("area_mm2").toDouble();
+            if (p.contains("contours"))
+            {
+                const QJsonArray outer = cocoOuterRings(p.value("contours").toArray());
+                if (!outer.isEmpty())
+                    ann["segmentation"] = outer;
+            }
+            if (annotationId > 1)
+                chunk.append(',');
+            chunk.append(QJsonDocument(ann).toJson(QJsonDocument::Compact));
+        }
+        if (chunk.size() > (1 << 16))
+        {
+            ok = writeAll(out, chunk) && ok;
+            chunk.clear();
+        }
+    }
+
+    chunk.append("],\"categories\":[");
+    bool first = true;
+    for (auto it = categories.cbegin(); it != categories.cend(); ++it)
+    {
+        QJsonObject cat;
+        cat["id"] = it.key();
+        cat["name"] = it.value();
+        if (!first)
+            chunk.append(',');
+        first = false;
+        chunk.append(QJsonDocument(cat).toJson(QJsonDocument::Compact));
+    }
+    chunk.append("]}\n");
+    if (!writeAll(out, chunk) || !ok)
+    {
+        if (error)
+            *error = QStringLiteral("Failed to write COCO file: %1").arg(cocoPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef PREDICTIONWRITER_H
+#define PREDICTIONWRITER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QPolygonF>
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+/**
+ * @brief 批量预测结果的流式 JSON Lines 写出器
+ * @details 每幅图像追加一行紧凑 JSON 记录，不构建 DOM；按记录数或时间间隔刷新到磁盘。
+ *          finish() 时可选地再读一遍 JSONL，流式生成 COCO 格式的标注文件。
+ *          append() 可在多个线程中并发调用。
+ */
+class PredictionWriter
+{
+public:
+    struct Prediction
+    {
+        int classId{0};
+        QString className;
+        float score{0.f};
+        QRectF bbox;             // 原图像素坐标
+        double areaPixels{0.0};  // 掩码面积（像素），无掩码时为 0
+        QVector<QPolygonF> contours; // 掩码轮廓（原图像素坐标），可为空
+        double polygonAreaPixels{0.0};
+    };
+
+    struct Record
+    {
+        QString imagePath;
+        int frameIndex{-1};  // 多帧对象中的帧序号（从 0 开始），< 0 表示单帧文件
+        QSize imageSize;
+        QSizeF pixelSpacing; // 毫米/像素，无效表示未知（不输出 mm² 面积）
+        QString maskFile;    // 相对输出目录的掩码文件名，可为空
+        std::vector<Prediction> predictions;
+    };
+
+    /**
+     * @param flushEveryRecords 累计多少条记录后刷新
+     * @param flushIntervalMs 距上次刷新超过该时间后刷新
+     */
+    explicit PredictionWriter(int flushEveryRecords = 256, int flushIntervalMs = 1000);
+    ~PredictionWriter();
+
+    bool open(const QString &jsonlPath, QString *error = nullptr);
+
+    /**
+     * @brief 追加一条记录（线程安全）
+     */
+    bool append(const Record &record);
+
+    /**
+     * @brief 刷新并关闭 JSONL；cocoPath 非空时生成 COCO 标注文件
+     */
+    bool finish(const QString &cocoPath = QString(), QString *error = nullptr);
+
+    qint64 recordCount() const;
+
+private:
+    static QByteArray serialize(const Record &record);
+    static bool writeCoco(const QString &jsonlPath, const QString &cocoPath, QString *error);
+
+    mutable QMutex m_mutex;
+    QFile m_file;
+    QElapsedTimer m_sinceFlush;
+    const int m_flushEveryRecords;
+    const int m_flushIntervalMs;
+    int m_pending{0};
+    qint64 m_records{0};
+    bool m_failed{false};
+};
+
+#endif // PREDICTIONWRITER_H
@@ -1,8 +1,13 @@
 #include "DicomUtils.h"
 #include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QSysInfo>
 #include <QVector>
+#include <QtEndian>
 #include <cmath>
 #include <cstring>
+#include <memory>
 #include <vector>
 #include <string>
 #include <functional>
@@ -11,13 +16,17 @@
 
 #ifdef HAVE_GDCM
 #include <gdcmImageReader.h>
+#include <gdcmImageRegionReader.h>
+#include <gdcmBoxRegion.h>
 #include <gdcmReader.h>
 #include <gdcmImage.h>
 #include <gdcmPixelFormat.h>
 #include <gdcmAttribute.h>
 #include <gdcmPhotometricInterpretation.h>
 #include <gdcmDataSet.h>
+#include <gdcmSequenceOfItems.h>
 #include <gdcmTag.h>
+#include <gdcmTransferSyntax.h>
 #endif
 
 #ifdef HAVE_GDCM
@@ -46,6 +55,32 @@ static bool readFirstNumber(const gdcm::DataSet &ds, uint16_t g, uint16_t e, dou
         return false;
     }
 }
+
+// 访问序列中的第 index 个条目（从 0 开始）；SmartPointer 在回调期间保持有效
+template <typename Fn>
+static bool withSequenceItem(const gdcm::DataSet &ds, uint16_t g, uint16_t e, int index, Fn &&fn)
+{
+    gdcm::Tag t(g, e);
+    if (index < 0 || !ds.FindDataElement(t))
+        return false;
+    gdcm::SmartPointer<gdcm::SequenceOfItems> sq = ds.GetDataElement(t).GetValueAsSQ();
+    if (!sq || static_cast<size_t>(index) >= sq->GetNumberOfItems())
+        return false;
+    return fn(sq->GetItem(static_cast<size_t>(index) + 1).GetNestedDataSet());
+}
+
+// Enhanced 对象的属性位于功能组宏中：先查该帧的 Per-frame 组，再查 Shared 组
+template <typename Fn>
+static bool withFunctionalGroup(const gdcm::DataSet &ds, int frameIndex, uint16_t g, uint16_t e, Fn &&fn)
+{
+    auto visitMacro = [&](const gdcm::DataSet &group)
+    {
+        return withSequenceItem(group, g, e, 0, fn);
+    };
+    if (withSequenceItem(ds, 0x5200, 0x9230, frameIndex, visitMacro))
+        return true;
+    return withSequenceItem(ds, 0x5200, 0x9229, 0, visitMacro);
+}
 #endif
 
 // no additional processing namespace needed
@@ -87,11 +122,67 @@ void parsePixelSpacing(const QString &spacingStr, double &rowSpacing, double &co
     }
 }
 
+static bool readPositionZ(const gdcm::DataSet &ds, double &z)
+{
+    const QStringList parts = readStringTag(ds, 0x0020, 0x0032).split('\\');
+    if (parts.size() != 3)
+        return false;
+    bool ok = false;
+    const double value = parts[2].toDouble(&ok);
+    if (ok)
+        z = value;
+    return ok;
+}
+
+static int readDoubles(const gdcm::DataSet &ds, uint16_t g, uint16_t e, double *out, int count)
+{
+    const QStringList parts = readStringTag(ds, g, e).split('\\');
+    if (parts.size() != count)
+        return 0;
+    for (int i = 0; i < count; ++i)
+    {
+        bool ok = false;
+        out[i] = parts[i].toDouble(&ok);
+        if (!ok)
+            return 0;
+    }
+    return count;
+}
+
+// 该帧的 Image Position：单帧对象在顶层，Enhanced 对象在 Plane Position Sequence (0020,9113)
+static void applyFrameGeometry(const gdcm::DataSet &ds, int frameIndex, DicomUtils::SliceInfo &info)
+{
+    withFunctionalGroup(ds, frameIndex, 0x0020, 0x9113, [&](const gdcm::DataSet &item)
+                        {
+        if (readDoubles(item, 0x0020, 0x0032, info.imagePosition.data(), 3) != 3)
+            return false;
+        info.hasPosition = true;
+        info.sliceLocation = info.imagePosition[2];
+        return true; });
+}
+
+static int readFrameCount(const gdcm::DataSet &ds)
+{
+    double frames = 1.0;
+    if (!readFirstNumber(ds, 0x0028, 0x0008, frames))
+        return 1;
+    return std::max(1, static_cast<int>(std::lround(frames)));
+}
+
 DicomUtils::SliceInfo extractSliceInfo(const gdcm::DataSet &ds)
 {
     DicomUtils::SliceInfo info;
     info.seriesInstanceUID = readStringTag(ds, 0x0020, 0x000E);
+    info.frameCount = readFrameCount(ds);
     QString spacing = readStringTag(ds, 0x0028, 0x0030);
+    if (spacing.isEmpty())
+    {
+        // Enhanced MR：Pixel Measures Sequence (0028,9110)
+        withFunctionalGroup(ds, 0, 0x0028, 0x9110, [&](const gdcm::DataSet &item)
+                            {
+            spacing = readStringTag(item, 0x0028, 0x0030);
+            return !spacing.isEmpty(); });
+    }
     parsePixelSpacing(spacing, info.spacingY, info.spacingX);
     double instance = 0.0;
     if (readFirstNumber(ds, 0x0020, 0x0013, instance))
@@ -99,17 +190,49 @@ DicomUtils::SliceInfo extractSliceInfo(const gdcm::DataSet &ds)
     double loc = 0.0;
     if (readFirstNumber(ds, 0x0020, 0x1041, loc))
         info.sliceLocation = loc;
+    else if (!readPositionZ(ds, info.sliceLocation))
+    {
+        // Enhanced MR：Plane Position Sequence (0020,9113)
+        withFunctionalGroup(ds, 0, 0x0020, 0x9113, [&](const gdcm::DataSet &item)
+                            { return readPositionZ(item, info.sliceLocation); });
+    }
+
+    // 体数据重建所需的几何信息
+    if (readDoubles(ds, 0x0020, 0x0032, info.imagePosition.data(), 3) == 3)
+        info.hasPosition = true;
     else
+        applyFrameGeometry(ds, 0, info);
+    double iop[6];
+    bool hasOrientation = readDoubles(ds, 0x0020, 0x0037, iop, 6) == 6;
+    if (!hasOrientation)
     {
-        QString ipp = readStringTag(ds, 0x0020, 0x0032);
-        const QStringList parts = ipp.split('\\');
-        if (parts.size() == 3)
-        {
-            bool ok = false;
-            double z = parts[2].toDouble(&ok);
-            if (ok)
-                info.sliceLocation = z;
-        }
+        // Enhanced MR：Plane Orientation Sequence (0020,9116)
+        hasOrientation = withFunctionalGroup(ds, 0, 0x0020, 0x9116, [&](const gdcm::DataSet &item)
+                                             { return readDoubles(item, 0x0020, 0x0037, iop, 6) == 6; });
+    }
+    if (hasOrientation)
+    {
+        std::copy(iop, iop + 3, info.rowCosines.begin());
+        std::copy(iop + 3, iop + 6, info.colCosines.begin());
+    }
+    double thickness = 0.0;
+    if (readFirstNumber(ds, 0x0018, 0x0088, thickness) || readFirstNumber(ds, 0x0018, 0x0050, thickness))
+        info.sliceThickness = thickness;
+    else
+        withFunctionalGroup(ds, 0, 0x0028, 0x9110, [&](const gdcm::DataSet &item)
+                            {
+            if (!readFirstNumber(item, 0x0018, 0x0088, thickness) && !readFirstNumber(item, 0x0018, 0x0050, thickness))
+                return false;
+            info.sliceThickness = thickness;
+            return true; });
+    if (ds.FindDataElement(gdcm::Tag(0x0028, 0x0010)) && ds.FindDataElement(gdcm::Tag(0x0028, 0x0011)))
+    {
+        gdcm::Attribute<0x0028, 0x0010> rows;
+        rows.SetFromDataElement(ds.GetDataElement(gdcm::Tag(0x0028, 0x0010)));
+        gdcm::Attribute<0x0028, 0x0011> columns;
+        columns.SetFromDataElement(ds.GetDataElement(gdcm::Tag(0x0028, 0x0011)));
+        info.rows = static_cast<int>(rows.GetValue());
+        info.columns = static_cast<int>(columns.GetValue());
     }
     return info;
 }
@@ -118,91 +241,320 @@ DicomUtils::SliceInfo extractSliceInfo(const gdcm::DataSet &ds)
 namespace DicomUtils
 {
 
-    static QImage toQImage8bit(const uint8_t *data, int w, int h)
+    // 8 位输出缓冲池：QImage 直接包装池中的缓冲，最后一个引用释放时归还
+    struct PooledBuffer
     {
-        QImage img(w, h, QImage::Format_Indexed8);
-        QVector<QRgb> table(256);
-        for (int i = 0; i < 256; ++i)
-            table[i] = qRgb(i, i, i);
-        img.setColorTable(table);
-        for (int y = 0; y < h; ++y)
-        {
-            std::memcpy(img.scanLine(y), data + y * w, static_cast<size_t>(w));
-        }
-        return img;
-    }
+        std::unique_ptr<uchar[]> data;
+        size_t capacity{0};
+    };
 
-#ifdef HAVE_GDCM
-    bool loadDicomToQImage(const QString &path, QImage &out, QMap<QString, QString> *meta, SliceInfo *info)
+    class FrameBufferPool
     {
-        gdcm::ImageReader ir;
-        ir.SetFileName(path.toStdString().c_str());
-        if (!ir.Read())
+    public:
+        static FrameBufferPool &instance()
         {
-            qWarning() << "GDCM: read failed:" << path;
-            return false;
+            // 有意不析构：退出时仍存活的 QImage 会回调 release
+            static FrameBufferPool *pool = new FrameBufferPool;
+            return *pool;
         }
 
-        const gdcm::Image &gimg = ir.GetImage();
-        const unsigned int *dims = gimg.GetDimensions();
-        const int w = static_cast<int>(dims[0]);
-        const int h = static_cast<int>(dims[1]);
-        if (w <= 0 || h <= 0)
+        PooledBuffer *acquire(size_t size)
         {
-            qWarning() << "GDCM: invalid image size";
-            return false;
+            {
+                QMutexLocker lock(&m_mutex);
+                for (auto it = m_free.begin(); it != m_free.end(); ++it)
+                {
+                    // 只复用大小相近的缓冲，避免小图长期占用大块内存
+                    if ((*it)->capacity >= size && (*it)->capacity / 2 <= size)
+                    {
+                        PooledBuffer *buf = it->release();
+                        m_free.erase(it);
+                        return buf;
+                    }
+                }
+            }
+            auto *buf = new PooledBuffer;
+            buf->data.reset(new uchar[size]);
+            buf->capacity = size;
+            return buf;
         }
 
-        const size_t pixelCount = static_cast<size_t>(w) * static_cast<size_t>(h);
-        const size_t bufferLen = gimg.GetBufferLength();
-        const gdcm::PixelFormat &pf = gimg.GetPixelFormat();
-        const int bitsAlloc = pf.GetBitsAllocated();
-        const bool is16 = bitsAlloc > 8;
-        const bool isSigned = (pf.GetPixelRepresentation() == 1);
-        const unsigned int spp = std::max(1u, static_cast<unsigned int>(pf.GetSamplesPerPixel()));
-        const unsigned int planar = gimg.GetPlanarConfiguration();
-        const gdcm::PhotometricInterpretation::PIType pi =
-            gimg.GetPhotometricInterpretation().GetType();
-
-        std::vector<uint16_t> buffer16;
-        std::vector<uint8_t> buffer8;
-        if (is16)
+        void release(PooledBuffer *buf)
         {
-            buffer16.resize(bufferLen / sizeof(uint16_t));
-            if (!gimg.GetBuffer(reinterpret_cast<char *>(buffer16.data())))
-            {
-                qWarning() << "GDCM: GetBuffer failed";
-                return false;
-            }
+            QMutexLocker lock(&m_mutex);
+            if (m_free.size() < kMaxFree)
+                m_free.emplace_back(buf);
+            else
+                delete buf;
         }
-        else
+
+    private:
+        static constexpr size_t kMaxFree = 16;
+        QMutex m_mutex;
+        std::vector<std::unique_ptr<PooledBuffer>> m_free;
+    };
+
+    static void releasePooledBuffer(void *info)
+    {
+        FrameBufferPool::instance().release(static_cast<PooledBuffer *>(info));
+    }
+
+    // 分配灰度 8 位图像，扫描行按 4 字节对齐
+    static QImage allocGray8(int w, int h)
+    {
+        const qsizetype bytesPerLine = (static_cast<qsizetype>(w) + 3) & ~qsizetype(3);
+        PooledBuffer *buf = FrameBufferPool::instance().acquire(static_cast<size_t>(bytesPerLine) * static_cast<size_t>(h));
+        QImage img(buf->data.get(), w, h, bytesPerLine, QImage::Format_Indexed8, releasePooledBuffer, buf);
+        static const QVector<QRgb> table = []()
         {
-            buffer8.resize(bufferLen);
-            if (!gimg.GetBuffer(reinterpret_cast<char *>(buffer8.data())))
-            {
-                qWarning() << "GDCM: GetBuffer failed";
-                return false;
-            }
+            QVector<QRgb> t(256);
+            for (int i = 0; i < 256; ++i)
+                t[i] = qRgb(i, i, i);
+            return t;
+        }();
+        img.setColorTable(table);
+        return img;
+    }
+
+#ifdef HAVE_GDCM
+    struct FrameLayout
+    {
+        int width{0};
+        int height{0};
+        int bitsAlloc{8};
+        int bitsStored{8};
+        int highBit{7};
+        bool isSigned{false};
+        unsigned int spp{1};
+        unsigned int planar{0};
+        gdcm::PhotometricInterpretation::PIType pi{gdcm::PhotometricInterpretation::MONOCHROME2};
+    };
+
+    struct FrameWindow
+    {
+        double wc{0.0};
+        double ww{0.0};
+        double slope{1.0};
+        double inter{0.0};
+    };
+
+    // 存储值 -> 像素值：按 BitsStored / HighBit 去掉高位覆盖位并做符号扩展
+    struct SampleBits
+    {
+        int shift{0};
+        uint32_t mask{0xFFFF};
+        uint32_t signBit{0}; // 0 表示无符号
+    };
+
+    // shiftStored 只对文件原始字节为真；GDCM 解码输出已移位，掩码与符号扩展对其是幂等的
+    static SampleBits sampleBitsOf(const FrameLayout &layout, bool shiftStored)
+    {
+        SampleBits bits;
+        const int allocated = std::clamp(layout.bitsAlloc, 1, 32);
+        const int stored = std::clamp(layout.bitsStored, 1, allocated);
+        const int highBit = std::clamp(layout.highBit, stored - 1, allocated - 1);
+        bits.shift = shiftStored ? highBit + 1 - stored : 0;
+        bits.mask = stored >= 32 ? 0xFFFFFFFFu : (1u << stored) - 1u;
+        bits.signBit = layout.isSigned ? 1u << (stored - 1) : 0u;
+        return bits;
+    }
+
+    inline int32_t storedValue(uint32_t raw, const SampleBits &bits)
+    {
+        const uint32_t v = (raw >> bits.shift) & bits.mask;
+        if (bits.signBit && (v & bits.signBit))
+            return static_cast<int32_t>(v) - static_cast<int32_t>(bits.signBit) * 2;
+        return static_cast<int32_t>(v);
+    }
+
+    // 帧像素视图：原生传输语法直接指向内存映射的文件，其他情况指向解码缓冲
+    struct FramePixels
+    {
+        const char *data{nullptr};
+        size_t size{0};
+        std::vector<char> storage;
+        std::unique_ptr<QFile> mapped;
+        SampleBits bits;
+
+        void adoptStorage()
+        {
+            data = storage.data();
+            size = storage.size();
         }
+    };
 
-        const gdcm::DataSet &ds = ir.GetFile().GetDataSet();
-        double wc = 0.0, ww = 0.0, slope = 1.0, inter = 0.0;
+    static FrameLayout layoutOf(const gdcm::Image &gimg)
+    {
+        FrameLayout layout;
+        const unsigned int *dims = gimg.GetDimensions();
+        const gdcm::PixelFormat &pf = gimg.GetPixelFormat();
+        layout.width = static_cast<int>(dims[0]);
+        layout.height = static_cast<int>(dims[1]);
+        layout.bitsAlloc = pf.GetBitsAllocated();
+        layout.bitsStored = pf.GetBitsStored();
+        layout.highBit = pf.GetHighBit();
+        layout.isSigned = (pf.GetPixelRepresentation() == 1);
+        layout.spp = std::max(1u, static_cast<unsigned int>(pf.GetSamplesPerPixel()));
+        layout.planar = gimg.GetPlanarConfiguration();
+        layout.pi = gimg.GetPhotometricInterpretation().GetType();
+        return layout;
+    }
 
-        (void)readFirstNumber(ds, 0x0028, 0x1050, wc);
-        (void)readFirstNumber(ds, 0x0028, 0x1051, ww);
+    static FrameWindow windowOf(const gdcm::DataSet &ds, int frameIndex)
+    {
+        FrameWindow win;
+        (void)readFirstNumber(ds, 0x0028, 0x1050, win.wc);
+        (void)readFirstNumber(ds, 0x0028, 0x1051, win.ww);
 
         if (ds.FindDataElement(gdcm::Tag(0x0028, 0x1053)))
         {
             gdcm::Attribute<0x0028, 0x1053> at;
             at.SetFromDataElement(ds.GetDataElement(gdcm::Tag(0x0028, 0x1053)));
-            slope = at.GetValue();
+            win.slope = at.GetValue();
         }
         if (ds.FindDataElement(gdcm::Tag(0x0028, 0x1052)))
         {
             gdcm::Attribute<0x0028, 0x1052> at;
             at.SetFromDataElement(ds.GetDataElement(gdcm::Tag(0x0028, 0x1052)));
-            inter = at.GetValue();
+            win.inter = at.GetValue();
+        }
+
+        // Enhanced 对象：Frame VOI LUT (0028,9132) 与 Pixel Value Transformation (0028,9145)
+        withFunctionalGroup(ds, frameIndex, 0x0028, 0x9132, [&](const gdcm::DataSet &item)
+                            {
+            (void)readFirstNumber(item, 0x0028, 0x1050, win.wc);
+            return readFirstNumber(item, 0x0028, 0x1051, win.ww); });
+        withFunctionalGroup(ds, frameIndex, 0x0028, 0x9145, [&](const gdcm::DataSet &item)
+                            {
+            (void)readFirstNumber(item, 0x0028, 0x1053, win.slope);
+            return readFirstNumber(item, 0x0028, 0x1052, win.inter); });
+        return win;
+    }
+
+    // 按区域只读取一帧：原生语法直接定位偏移，封装语法只解码该帧对应的片段
+    static bool readFrameRegion(gdcm::ImageRegionReader &reader, const FrameLayout &layout,
+                                int frameIndex, std::vector<char> &pixels)
+    {
+        gdcm::BoxRegion box;
+        box.SetDomain(0, static_cast<unsigned int>(layout.width - 1),
+                      0, static_cast<unsigned int>(layout.height - 1),
+                      static_cast<unsigned int>(frameIndex), static_cast<unsigned int>(frameIndex));
+        reader.SetRegion(box);
+        const size_t len = reader.ComputeBufferLength();
+        if (len == 0)
+            return false;
+        pixels.resize(len);
+        return reader.ReadIntoBuffer(pixels.data(), len);
+    }
+
+    // Pixel Data (7FE0,0010) 值域起始偏移：取解析器读完头部时的流位置（位于元素头或值域起始），
+    // 只在该位置核对元素头，不做字节扫描
+    static qint64 pixelDataValueOffset(const gdcm::ImageRegionReader &reader, const uchar *base, qint64 size,
+                                       size_t valueLen, bool explicitVR)
+    {
+        const qint64 header = explicitVR ? 12 : 8;
+        const qint64 position = static_cast<qint64>(reader.GetStreamCurrentPosition());
+        auto elementAt = [&](qint64 p) -> bool
+        {
+            if (p < 0 || p + header > size)
+                return false;
+            if (base[p] != 0xE0 || base[p + 1] != 0x7F || base[p + 2] != 0x10 || base[p + 3] != 0x00)
+                return false;
+            if (explicitVR && !(base[p + 4] == 'O' && (base[p + 5] == 'W' || base[p + 5] == 'B') &&
+                                base[p + 6] == 0 && base[p + 7] == 0))
+                return false;
+            const quint32 len = qFromLittleEndian<quint32>(base + p + header - 4);
+            // 奇数长度的 8 位数据带一个填充字节；未定义长度为封装数据
+            return len >= valueLen && len <= valueLen + 1 && p + header + static_cast<qint64>(len) <= size;
+        };
+        if (elementAt(position))
+            return position + header;
+        if (elementAt(position - header))
+            return position;
+        return -1;
+    }
+
+    // 原生小端语法：映射文件并直接定位目标帧，省去 GDCM 的缓冲拷贝
+    static bool mapNativeFrame(const gdcm::ImageRegionReader &reader, const QString &path, const FrameLayout &layout,
+                               int frameIndex, int frameCount, FramePixels &pixels)
+    {
+        if (QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+            return false;
+        const gdcm::TransferSyntax ts = reader.GetFile().GetHeader().GetDataSetTransferSyntax();
+        const bool explicitVR = (ts == gdcm::TransferSyntax::ExplicitVRLittleEndian);
+        if (!explicitVR && ts != gdcm::TransferSyntax::ImplicitVRLittleEndian)
+            return false;
+        if (layout.spp != 1 || (layout.bitsAlloc != 8 && layout.bitsAlloc != 16))
+            return false;
+
+        const size_t frameLen = static_cast<size_t>(layout.width) * static_cast<size_t>(layout.height) *
+                                layout.spp * static_cast<size_t>(layout.bitsAlloc / 8);
+        const size_t totalLen = frameLen * static_cast<size_t>(frameCount);
+
+        auto file = std::make_unique<QFile>(path);
+        if (!file->open(QIODevice::ReadOnly))
+            return false;
+        const qint64 fileSize = file->size();
+        if (fileSize < static_cast<qint64>(totalLen))
+            return false;
+        const uchar *base = file->map(0, fileSize);
+        if (!base)
+            return false;
+
+        const qint64 valueOffset = pixelDataValueOffset(reader, base, fileSize, totalLen, explicitVR);
+        // 16 位样本要求偶数偏移，保证按 uint16 对齐访问
+        if (valueOffset < 0 || (valueOffset % 2) != 0)
+            return false;
+
+        pixels.data = reinterpret_cast<const char *>(base + valueOffset) + frameLen * static_cast<size_t>(frameIndex);
+        pixels.size = frameLen;
+        pixels.mapped = std::move(file);
+        pixels.bits = sampleBitsOf(layout, true);
+        return true;
+    }
+
+    // 兜底：整对象解码后截取目标帧（区域读取不支持的传输语法）
+    static bool readFrameFull(const QString &path, int frameIndex, int frameCount, std::vector<char> &pixels)
+    {
+        gdcm::ImageReader ir;
+        ir.SetFileName(path.toStdString().c_str());
+        if (!ir.Read())
+            return false;
+        const gdcm::Image &gimg = ir.GetImage();
+        const size_t bufferLen = gimg.GetBufferLength();
+        std::vector<char> all(bufferLen);
+        if (!gimg.GetBuffer(all.data()))
+            return false;
+        const size_t frameLen = bufferLen / static_cast<size_t>(std::max(1, frameCount));
+        const size_t offset = frameLen * static_cast<size_t>(frameIndex);
+        if (frameLen == 0 || offset + frameLen > bufferLen)
+            return false;
+        if (frameCount <= 1)
+        {
+            pixels.swap(all);
+            return true;
         }
+        pixels.assign(all.begin() + static_cast<std::ptrdiff_t>(offset),
+                      all.begin() + static_cast<std::ptrdiff_t>(offset + frameLen));
+        return true;
+    }
+
+    // 逐像素回调 Rescale 后的模态值（彩色输入取亮度）
+    template <typename Fn>
+    static void visitSamples(const FramePixels &pixels, const FrameLayout &layout, const FrameWindow &win, Fn &&fn)
+    {
+        const size_t pixelCount = static_cast<size_t>(layout.width) * static_cast<size_t>(layout.height);
+        const bool is16 = layout.bitsAlloc > 8;
+        const SampleBits &bits = pixels.bits;
+        const unsigned int spp = layout.spp;
+        const unsigned int planar = layout.planar;
+        const gdcm::PhotometricInterpretation::PIType pi = layout.pi;
+        const double slope = win.slope;
+        const double inter = win.inter;
+
+        const uint16_t *buffer16 = reinterpret_cast<const uint16_t *>(pixels.data);
+        const uint8_t *buffer8 = reinterpret_cast<const uint8_t *>(pixels.data);
+        const size_t sampleCount = is16 ? pixels.size / sizeof(uint16_t) : pixels.size;
 
         auto readChannel = [&](size_t idx, unsigned int channel) -> double
         {
@@ -210,16 +562,9 @@ namespace DicomUtils
                 return 0.0;
             size_t offset = (planar == 0) ? idx * spp + channel
                                           : static_cast<size_t>(channel) * pixelCount + idx;
-            if (is16)
-            {
-                if (offset >= buffer16.size())
-                    return 0.0;
-                const uint16_t raw = buffer16[offset];
-                return isSigned ? static_cast<int16_t>(raw) : raw;
-            }
-            if (offset >= buffer8.size())
+            if (offset >= sampleCount)
                 return 0.0;
-            return buffer8[offset];
+            return storedValue(is16 ? buffer16[offset] : buffer8[offset], bits);
         };
 
         auto sampleAt = [&](size_t idx) -> double
@@ -243,22 +588,107 @@ namespace DicomUtils
                 return inter + slope * y;
             }
 
-            double raw = is16 ? (isSigned ? static_cast<int16_t>(buffer16[idx]) : buffer16[idx])
-                              : buffer8[idx];
+            if (idx >= sampleCount)
+                return inter;
+            const double raw = storedValue(is16 ? buffer16[idx] : buffer8[idx], bits);
             return inter + slope * raw;
         };
 
-        double minSample = std::numeric_limits<double>::max();
-        double maxSample = std::numeric_limits<double>::lowest();
         for (size_t idx = 0; idx < pixelCount; ++idx)
+            fn(idx, sampleAt(idx));
+    }
+
+    // 单通道：原始值 -> 8 位查找表，直接扫描（映射的）像素写入输出缓冲
+    static bool renderMonochromeLut(const FramePixels &pixels, const FrameLayout &layout, const FrameWindow &win, QImage &img)
+    {
+        const int w = layout.width;
+        const int h = layout.height;
+        const size_t pixelCount = static_cast<size_t>(w) * static_cast<size_t>(h);
+        const bool is16 = layout.bitsAlloc > 8;
+        if (layout.spp != 1 || layout.bitsAlloc > 16 || pixels.size < pixelCount * (is16 ? 2 : 1))
+            return false;
+
+        const uint16_t *buffer16 = reinterpret_cast<const uint16_t *>(pixels.data);
+        const uint8_t *buffer8 = reinterpret_cast<const uint8_t *>(pixels.data);
+        // 查找表覆盖全部存储值，覆盖位掩码与符号扩展在建表时完成，逐像素不增加开销
+        auto rawValue = [&](uint32_t raw) -> double
         {
-            double v = sampleAt(idx);
-            minSample = std::min(minSample, v);
-            maxSample = std::max(maxSample, v);
+            return storedValue(raw, pixels.bits);
+        };
+
+        double useWc = win.wc;
+        double useWw = win.ww;
+        if (!(useWw > 0.0))
+        {
+            // 只有文件未给出窗宽时才需要扫描数据范围
+            double rawMin = std::numeric_limits<double>::max();
+            double rawMax = std::numeric_limits<double>::lowest();
+            for (size_t idx = 0; idx < pixelCount; ++idx)
+            {
+                const double v = rawValue(is16 ? buffer16[idx] : buffer8[idx]);
+                rawMin = std::min(rawMin, v);
+                rawMax = std::max(rawMax, v);
+            }
+            const double a = win.inter + win.slope * rawMin;
+            const double b = win.inter + win.slope * rawMax;
+            useWw = std::fabs(b - a);
+            useWc = 0.5 * (a + b);
+            if (!(useWw > 0.0))
+                useWw = 1.0;
+        }
+
+        const double low = useWc - useWw / 2.0;
+        const double high = useWc + useWw / 2.0;
+        const bool invert = (layout.pi == gdcm::PhotometricInterpretation::MONOCHROME1);
+        std::vector<uint8_t> lut(is16 ? 65536 : 256);
+        for (size_t raw = 0; raw < lut.size(); ++raw)
+        {
+            const double v = win.inter + win.slope * rawValue(static_cast<uint32_t>(raw));
+            int mapped = (v <= low) ? 0 : (v >= high) ? 255
+                                                      : static_cast<int>(std::round((v - low) / (high - low) * 255.0));
+            mapped = std::clamp(mapped, 0, 255);
+            lut[raw] = static_cast<uint8_t>(invert ? 255 - mapped : mapped);
         }
 
-        double useWc = wc;
-        double useWw = ww;
+        img = allocGray8(w, h);
+        for (int y = 0; y < h; ++y)
+        {
+            uchar *line = img.scanLine(y);
+            const size_t rowStart = static_cast<size_t>(y) * static_cast<size_t>(w);
+            if (is16)
+            {
+                const uint16_t *row = buffer16 + rowStart;
+                for (int x = 0; x < w; ++x)
+                    line[x] = lut[row[x]];
+            }
+            else
+            {
+                const uint8_t *row = buffer8 + rowStart;
+                for (int x = 0; x < w; ++x)
+                    line[x] = lut[row[x]];
+            }
+        }
+        return true;
+    }
+
+    static QImage renderFrame(const FramePixels &pixels, const FrameLayout &layout, const FrameWindow &win)
+    {
+        QImage img;
+        if (renderMonochromeLut(pixels, layout, win, img))
+            return img;
+
+        const int w = layout.width;
+        const int h = layout.height;
+
+        double minSample = std::numeric_limits<double>::max();
+        double maxSample = std::numeric_limits<double>::lowest();
+        visitSamples(pixels, layout, win, [&](size_t, double v)
+                     {
+            minSample = std::min(minSample, v);
+            maxSample = std::max(maxSample, v); });
+
+        double useWc = win.wc;
+        double useWw = win.ww;
         if (!(useWw > 0.0))
         {
             useWw = maxSample - minSample;
@@ -269,6 +699,7 @@ namespace DicomUtils
 
         const double low = useWc - useWw / 2.0;
         const double high = useWc + useWw / 2.0;
+        const bool invert = (layout.pi == gdcm::PhotometricInterpretation::MONOCHROME1);
 
         auto mapToU8 = [&](double v) -> uint8_t
         {
@@ -281,26 +712,78 @@ namespace DicomUtils
             return static_cast<uint8_t>(std::clamp(mapped, 0, 255));
         };
 
-        std::vector<uint8_t> outbuf(pixelCount);
-        for (size_t idx = 0; idx < pixelCount; ++idx)
-            outbuf[idx] = mapToU8(sampleAt(idx));
+        img = allocGray8(w, h);
+        uchar *bits = img.bits();
+        const qsizetype bpl = img.bytesPerLine();
+        visitSamples(pixels, layout, win, [&](size_t idx, double v)
+                     {
+            const uint8_t mapped = mapToU8(v);
+            bits[static_cast<qsizetype>(idx / static_cast<size_t>(w)) * bpl + static_cast<qsizetype>(idx % static_cast<size_t>(w))] =
+                invert ? static_cast<uint8_t>(255 - mapped) : mapped; });
+        return img;
+    }
+
+    // 打开文件并只解码一帧；reader 在返回后仍持有头部数据集
+    static bool readSingleFrame(gdcm::ImageRegionReader &reader, const QString &path, int frameIndex,
+                                FrameLayout &layout, int &frameCount, FramePixels &pixels)
+    {
+        reader.SetFileName(path.toStdString().c_str());
+        if (!reader.ReadInformation())
+        {
+            qWarning() << "GDCM: read failed:" << path;
+            return false;
+        }
 
-        if (pi == gdcm::PhotometricInterpretation::MONOCHROME1)
+        layout = layoutOf(reader.GetImage());
+        if (layout.width <= 0 || layout.height <= 0)
         {
-            for (auto &v : outbuf)
-                v = 255 - v;
+            qWarning() << "GDCM: invalid image size";
+            return false;
         }
 
-        out = toQImage8bit(outbuf.data(), w, h);
+        frameCount = readFrameCount(reader.GetFile().GetDataSet());
+        if (frameIndex < 0 || frameIndex >= frameCount)
+        {
+            qWarning() << "GDCM: frame index out of range:" << frameIndex << "/" << frameCount;
+            return false;
+        }
+
+        if (mapNativeFrame(reader, path, layout, frameIndex, frameCount, pixels))
+            return true;
+
+        if (!readFrameRegion(reader, layout, frameIndex, pixels.storage) &&
+            !readFrameFull(path, frameIndex, frameCount, pixels.storage))
+        {
+            qWarning() << "GDCM: GetBuffer failed";
+            return false;
+        }
+        pixels.adoptStorage();
+        pixels.bits = sampleBitsOf(layout, false);
+        return true;
+    }
+
+    bool loadDicomFrameToQImage(const QString &path, int frameIndex, QImage &out, QMap<QString, QString> *meta, SliceInfo *info)
+    {
+        gdcm::ImageRegionReader reader;
+        FrameLayout layout;
+        int frameCount = 1;
+        FramePixels pixels;
+        if (!readSingleFrame(reader, path, frameIndex, layout, frameCount, pixels))
+            return false;
+
+        const gdcm::DataSet &ds = reader.GetFile().GetDataSet();
+        const int w = layout.width;
+        const int h = layout.height;
+        const FrameWindow win = windowOf(ds, frameIndex);
+        out = renderFrame(pixels, layout, win);
         // out = enhanceMonochrome(out);
 
-        SliceInfo sliceInfo;
-        sliceInfo.spacingX = 1.0;
-        sliceInfo.spacingY = 1.0;
-        sliceInfo.sliceLocation = 0.0;
-        sliceInfo.instanceNumber = 0;
-        sliceInfo.seriesInstanceUID.clear();
-        sliceInfo = extractSliceInfo(ds);
+        SliceInfo sliceInfo = extractSliceInfo(ds);
+        if (frameCount > 1)
+        {
+            sliceInfo.instanceNumber = frameIndex + 1;
+            applyFrameGeometry(ds, frameIndex, sliceInfo);
+        }
         if (info)
             *info = sliceInfo;
 
@@ -311,48 +794,268 @@ namespace DicomUtils
             meta->insert("PatientName", readStringTag(ds, 0x0010, 0x0010));
             meta->insert("StudyDate", readStringTag(ds, 0x0008, 0x0020));
             meta->insert("SeriesDescription", readStringTag(ds, 0x0008, 0x103E));
-            meta->insert("WindowCenter", QString::number(wc));
-            meta->insert("WindowWidth", QString::number(ww));
-            meta->insert("RescaleSlope", QString::number(slope));
-            meta->insert("RescaleIntercept", QString::number(inter));
+            meta->insert("WindowCenter", QString::number(win.wc));
+            meta->insert("WindowWidth", QString::number(win.ww));
+            meta->insert("RescaleSlope", QString::number(win.slope));
+            meta->insert("RescaleIntercept", QString::number(win.inter));
             meta->insert("Size", QString("%1 x %2").arg(w).arg(h));
-            meta->insert("SamplesPerPixel", QString::number(spp));
-            meta->insert("PlanarConfiguration", QString::number(planar));
-            meta->insert("BitsAllocated", QString::number(bitsAlloc));
-            meta->insert("PixelRepresentation", isSigned ? "SIGNED" : "UNSIGNED");
-            meta->insert("Photometric", QString::fromLatin1(gdcm::PhotometricInterpretation::GetPIString(pi)));
+            meta->insert("SamplesPerPixel", QString::number(layout.spp));
+            meta->insert("PlanarConfiguration", QString::number(layout.planar));
+            meta->insert("BitsAllocated", QString::number(layout.bitsAlloc));
+            meta->insert("PixelRepresentation", layout.isSigned ? "SIGNED" : "UNSIGNED");
+            meta->insert("Photometric", QString::fromLatin1(gdcm::PhotometricInterpretation::GetPIString(layout.pi)));
             meta->insert("Path", path);
             meta->insert("PixelSpacing", QString("%1 mm / %2 mm").arg(sliceInfo.spacingY, 0, 'f', 3).arg(sliceInfo.spacingX, 0, 'f', 3));
             meta->insert("InstanceNumber", QString::number(sliceInfo.instanceNumber));
             meta->insert("SliceLocation", QString::number(sliceInfo.sliceLocation, 'f', 3));
+            if (frameCount > 1)
+            {
+                meta->insert("NumberOfFrames", QString::number(frameCount));
+                meta->insert("Frame", QString("%1 / %2").arg(frameIndex + 1).arg(frameCount));
+            }
             if (!sliceInfo.seriesInstanceUID.isEmpty())
                 meta->insert("SeriesInstanceUID", sliceInfo.seriesInstanceUID);
         }
 
         return true;
     }
-#else
+
     bool loadDicomToQImage(const QString &path, QImage &out, QMap<QString, QString> *meta, SliceInfo *info)
+    {
+        return loadDicomFrameToQImage(path, 0, out, meta, info);
+    }
+
+    // 写出 16 位存储值：单通道 8/16 位数据保留存储值并携带 Rescale；
+    // 彩色或 32 位数据退回取整后的模态值，按值域决定有无符号
+    static void storeSamples(const FramePixels &pixels, const FrameLayout &layout, const FrameWindow &win,
+                             uint16_t *dst, FrameSamples &format)
+    {
+        const size_t pixelCount = static_cast<size_t>(layout.width) * static_cast<size_t>(layout.height);
+        const bool is16 = layout.bitsAlloc > 8;
+        if (layout.spp == 1 && layout.bitsAlloc <= 16 && pixels.size >= pixelCount * (is16 ? 2 : 1))
+        {
+            format.isSigned = layout.isSigned;
+            format.slope = win.slope;
+            format.intercept = win.inter;
+            const uint16_t *buffer16 = reinterpret_cast<const uint16_t *>(pixels.data);
+            const uint8_t *buffer8 = reinterpret_cast<const uint8_t *>(pixels.data);
+            for (size_t idx = 0; idx < pixelCount; ++idx)
+                dst[idx] = static_cast<uint16_t>(storedValue(is16 ? buffer16[idx] : buffer8[idx], pixels.bits));
+            return;
+        }
+
+        double minV = std::numeric_limits<double>::max();
+        visitSamples(pixels, layout, win, [&](size_t, double v)
+                     { minV = std::min(minV, v); });
+        format.isSigned = minV < 0.0;
+        format.slope = 1.0;
+        format.intercept = 0.0;
+        const long lo = format.isSigned ? -32768L : 0L;
+        const long hi = format.isSigned ? 32767L : 65535L;
+        visitSamples(pixels, layout, win, [&](size_t idx, double v)
+                     { dst[idx] = static_cast<uint16_t>(std::clamp(std::lround(v), lo, hi)); });
+    }
+
+    // 读出一帧后由 target 按实际尺寸给出目标缓冲（返回空表示拒绝），存储值直接写入该缓冲
+    template <typename Target>
+    static bool decodeStoredFrame(const QString &path, int frameIndex, Target &&target, FrameSamples &format, SliceInfo *info)
+    {
+        gdcm::ImageRegionReader reader;
+        FrameLayout layout;
+        int frameCount = 1;
+        FramePixels pixels;
+        if (!readSingleFrame(reader, path, frameIndex, layout, frameCount, pixels))
+            return false;
+        uint16_t *dst = target(layout.width, layout.height);
+        if (!dst)
+        {
+            qWarning() << "GDCM: frame size mismatch:" << path;
+            return false;
+        }
+
+        const gdcm::DataSet &ds = reader.GetFile().GetDataSet();
+        const FrameWindow win = windowOf(ds, frameIndex);
+        format.width = layout.width;
+        format.height = layout.height;
+        format.windowCenter = win.wc;
+        format.windowWidth = win.ww;
+        format.invert = (layout.pi == gdcm::PhotometricInterpretation::MONOCHROME1);
+        storeSamples(pixels, layout, win, dst, format);
+
+        if (info)
+        {
+            *info = extractSliceInfo(ds);
+            if (frameCount > 1)
+            {
+                info->instanceNumber = frameIndex + 1;
+                applyFrameGeometry(ds, frameIndex, *info);
+            }
+        }
+        return true;
+    }
+
+    bool decodeFrameSamplesInto(const QString &path, int frameIndex, uint16_t *dst, int width, int height,
+                                FrameSamples &format, SliceInfo *info)
+    {
+        return decodeStoredFrame(
+            path, frameIndex, [dst, width, height](int w, int h)
+            { return (w == width && h == height) ? dst : nullptr; },
+            format, info);
+    }
+
+    bool decodeFrameSamples(const QString &path, int frameIndex, FrameSamples &out, SliceInfo *info)
+    {
+        return decodeStoredFrame(
+            path, frameIndex, [&out](int w, int h)
+            {
+                out.values.resize(static_cast<size_t>(w) * static_cast<size_t>(h));
+                return out.values.data(); },
+            out, info);
+    }
+#else
+    bool loadDicomFrameToQImage(const QString &path, int frameIndex, QImage &out, QMap<QString, QString> *meta, SliceInfo *info)
     {
         Q_UNUSED(path);
+        Q_UNUSED(frameIndex);
         Q_UNUSED(out);
         Q_UNUSED(info);
         if (meta)
             meta->insert("Info", "Built without GDCM support");
         return false;
     }
+
+    bool loadDicomToQImage(const QString &path, QImage &out, QMap<QString, QString> *meta, SliceInfo *info)
+    {
+        return loadDicomFrameToQImage(path, 0, out, meta, info);
+    }
+
+    bool decodeFrameSamples(const QString &path, int frameIndex, FrameSamples &out, SliceInfo *info)
+    {
+        Q_UNUSED(path);
+        Q_UNUSED(frameIndex);
+        Q_UNUSED(out);
+        Q_UNUSED(info);
+        return false;
+    }
+
+    bool decodeFrameSamplesInto(const QString &path, int frameIndex, uint16_t *dst, int width, int height,
+                                FrameSamples &format, SliceInfo *info)
+    {
+        Q_UNUSED(path);
+        Q_UNUSED(frameIndex);
+        Q_UNUSED(dst);
+        Q_UNUSED(width);
+        Q_UNUSED(height);
+        Q_UNUSED(format);
+        Q_UNUSED(info);
+        return false;
+    }
 #endif
 
+    QImage windowToQImage(const uint16_t *data, bool isSigned, int width, int height, qsizetype stride,
+                          double slope, double intercept,
+                          double windowCenter, double windowWidth, bool invert)
+    {
+        if (!data || width <= 0 || height <= 0)
+            return {};
+
+        auto storedAt = [isSigned](uint16_t raw) -> int
+        {
+            return isSigned ? static_cast<int>(static_cast<int16_t>(raw)) : static_cast<int>(raw);
+        };
+
+        double useWc = windowCenter;
+        double useWw = windowWidth;
+        if (!(useWw > 0.0))
+        {
+            int minV = std::numeric_limits<int>::max();
+            int maxV = std::numeric_limits<int>::min();
+            for (int y = 0; y < height; ++y)
+            {
+                const uint16_t *row = data + y * stride;
+                for (int x = 0; x < width; ++x)
+                {
+                    const int v = storedAt(row[x]);
+                    minV = std::min(minV, v);
+                    maxV = std::max(maxV, v);
+                }
+            }
+            const double a = intercept + slope * minV;
+            const double b = intercept + slope * maxV;
+            useWw = std::fabs(b - a);
+            useWc = 0.5 * (a + b);
+            if (!(useWw > 0.0))
+                useWw = 1.0;
+        }
+
+        const double low = useWc - useWw / 2.0;
+        const double high = useWc + useWw / 2.0;
+        const double gain = 255.0 / (high - low);
+
+        QImage img = allocGray8(width, height);
+        for (int y = 0; y < height; ++y)
+        {
+            const uint16_t *row = data + y * stride;
+            uchar *line = img.scanLine(y);
+            for (int x = 0; x < width; ++x)
+            {
+                const double v = intercept + slope * storedAt(row[x]);
+                int mapped = (v <= low) ? 0 : (v >= high) ? 255
+                                                          : static_cast<int>(std::round((v - low) * gain));
+                mapped = std::clamp(mapped, 0, 255);
+                line[x] = static_cast<uchar>(invert ? 255 - mapped : mapped);
+            }
+        }
+        return img;
+    }
+
+
 #ifdef HAVE_GDCM
     bool probeSliceInfo(const QString &path, SliceInfo &info)
     {
         gdcm::Reader reader;
         reader.SetFileName(path.toStdString().c_str());
-        if (!reader.Read())
+        // 头部探测不需要像素数据，多帧大文件下避免整体读入
+        if (!reader.ReadUpToTag(gdcm::Tag(0x7FE0, 0x0010)))
             return false;
         info = extractSliceInfo(reader.GetFile().GetDataSet());
         return true;
     }
+
+    bool probeFrames(const QString &path, QVector<SliceInfo> &frames)
+    {
+        gdcm::Reader reader;
+        reader.SetFileName(path.toStdString().c_str());
+        if (!reader.ReadUpToTag(gdcm::Tag(0x7FE0, 0x0010)))
+            return false;
+        const gdcm::DataSet &ds = reader.GetFile().GetDataSet();
+        const SliceInfo base = extractSliceInfo(ds);
+        frames.clear();
+        frames.reserve(base.frameCount);
+        for (int f = 0; f < base.frameCount; ++f)
+        {
+            SliceInfo frame = base;
+            if (base.frameCount > 1)
+            {
+                frame.instanceNumber = f + 1;
+                applyFrameGeometry(ds, f, frame);
+            }
+            frames.append(frame);
+        }
+        return true;
+    }
+
+    bool probeFrameLocations(const QString &path, QVector<double> &locations)
+    {
+        QVector<SliceInfo> frames;
+        if (!probeFrames(path, frames))
+            return false;
+        locations.clear();
+        locations.reserve(frames.size());
+        for (const SliceInfo &frame : frames)
+            locations.append(frame.sliceLocation);
+        return true;
+    }
 #else
     bool probeSliceInfo(const QString &path, SliceInfo &info)
     {
@@ -360,6 +1063,20 @@ namespace DicomUtils
         Q_UNUSED(info);
         return false;
     }
+
+    bool probeFrames(const QString &path, QVector<SliceInfo> &frames)
+    {
+        Q_UNUSED(path);
+        frames.clear();
+        return false;
+    }
+
+    bool probeFrameLocations(const QString &path, QVector<double> &locations)
+    {
+        Q_UNUSED(path);
+        locations.clear();
+        return false;
+    }
 #endif
 
 } // namespace DicomUtils
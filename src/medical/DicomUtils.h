@@ -2,6 +2,10 @@
 #include <QImage>
 #include <QMap>
 #include <QString>
+#include <QVector>
+#include <array>
+#include <cstdint>
+#include <vector>
 
 namespace DicomUtils
 {
@@ -11,13 +15,73 @@ namespace DicomUtils
         double spacingY{1.0}; // 行方向（毫米/像素）
         double sliceLocation{0.0};
         int instanceNumber{0};
+        int frameCount{1}; // 多帧对象（Enhanced MR 等）的帧数
         QString seriesInstanceUID;
+        // 患者坐标系几何信息（Image Position / Orientation Patient）
+        bool hasPosition{false};
+        std::array<double, 3> imagePosition{0.0, 0.0, 0.0};
+        std::array<double, 3> rowCosines{1.0, 0.0, 0.0};
+        std::array<double, 3> colCosines{0.0, 1.0, 0.0};
+        double sliceThickness{0.0};
+        int columns{0}; // 头部给出的图像尺寸，不解码像素即可分配缓冲
+        int rows{0};
     };
 
+    // 单帧解码后的 16 位存储值（已去掉覆盖位并做符号扩展，未应用 Rescale），不经过 8 位显示转换；
+    // 模态值 = intercept + slope * 存储值，无符号 16 位数据完整保留
+    struct FrameSamples
+    {
+        int width{0};
+        int height{0};
+        std::vector<uint16_t> values; // isSigned 时按 int16_t 解读
+        bool isSigned{false};
+        double slope{1.0};
+        double intercept{0.0};
+        double windowCenter{0.0};
+        double windowWidth{0.0}; // <= 0 表示文件未给出窗宽
+        bool invert{false};      // MONOCHROME1
+    };
+
+    // 读取第一帧（单帧文件的常规入口）
     bool loadDicomToQImage(const QString &path,
                            QImage &out,
                            QMap<QString, QString> *meta = nullptr,
                            SliceInfo *info = nullptr);
 
+    // 仅解码指定帧；封装传输语法按片段读取，不会解码整个多帧对象
+    bool loadDicomFrameToQImage(const QString &path,
+                                int frameIndex,
+                                QImage &out,
+                                QMap<QString, QString> *meta = nullptr,
+                                SliceInfo *info = nullptr);
+
+    bool decodeFrameSamples(const QString &path,
+                            int frameIndex,
+                            FrameSamples &out,
+                            SliceInfo *info = nullptr);
+
+    // 解码到调用方提供的 width * height 缓冲；帧尺寸不符时返回 false。
+    // format 只填写尺寸、符号、Rescale 与窗宽窗位，其 values 不使用
+    bool decodeFrameSamplesInto(const QString &path,
+                                int frameIndex,
+                                uint16_t *dst,
+                                int width,
+                                int height,
+                                FrameSamples &format,
+                                SliceInfo *info = nullptr);
+
+    // 16 位存储值经 Rescale 后按窗宽窗位映射为 8 位灰度图；stride 以采样为单位，
+    // windowWidth <= 0 时按数据范围自动取窗
+    QImage windowToQImage(const uint16_t *data, bool isSigned, int width, int height, qsizetype stride,
+                          double slope, double intercept,
+                          double windowCenter, double windowWidth, bool invert = false);
+
+    // 只读取像素数据之前的头部
     bool probeSliceInfo(const QString &path, SliceInfo &info);
+
+    // 逐帧头部信息（单帧文件返回一项）
+    bool probeFrames(const QString &path, QVector<SliceInfo> &frames);
+
+    // 多帧对象中每一帧的位置（取自 Per-frame Functional Groups），数量等于帧数
+    bool probeFrameLocations(const QString &path, QVector<double> &locations);
 }
@@ -0,0 +1,303 @@
+#include "DicomVolume.h"
+#include "SeriesDecoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    double dot(const std::array<double, 3> &a, const std::array<double, 3> &b)
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    std::array<double, 3> cross(const std::array<double, 3> &a, const std::array<double, 3> &b)
+    {
+        return {a[1] * b[2] - a[2] * b[1],
+                a[2] * b[0] - a[0] * b[2],
+                a[0] * b[1] - a[1] * b[0]};
+    }
+}
+
+namespace DicomUtils
+{
+
+    bool Volume::build(const QVector<Source> &sources, QString *error)
+    {
+        clear();
+        if (sources.isEmpty())
+        {
+            if (error)
+                *error = QStringLiteral("序列为空");
+            return false;
+        }
+
+        // 尺寸取自第一层头部，体数据一次分配，各层解码直接写入自己的平面
+        SliceInfo first;
+        if (!probeSliceInfo(sources.front().path, first) || first.columns <= 0 || first.rows <= 0)
+        {
+            if (error)
+                *error = QStringLiteral("无法读取切层尺寸: %1").arg(sources.front().path);
+            return false;
+        }
+        m_width = first.columns;
+        m_height = first.rows;
+        m_depth = static_cast<int>(sources.size());
+        const size_t plane = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+        m_voxels.resize(plane * static_cast<size_t>(m_depth));
+        m_windows.resize(m_depth);
+
+        struct Decoded
+        {
+            bool ok{false};
+            FrameSamples format;
+            SliceInfo info;
+        };
+
+        QVector<SliceInfo> infos(sources.size());
+        int bad = -1;
+        const bool completed = SeriesDecoder::instance().run<Decoded>(
+            static_cast<int>(sources.size()),
+            [this, &sources, plane](int z)
+            {
+                Decoded d;
+                d.ok = decodeFrameSamplesInto(sources[z].path, sources[z].frameIndex,
+                                              m_voxels.data() + plane * static_cast<size_t>(z),
+                                              m_width, m_height, d.format, &d.info);
+                return d;
+            },
+            [&](int z, Decoded &&d)
+            {
+                if (!d.ok)
+                {
+                    bad = z;
+                    return false;
+                }
+                if (z == 0)
+                {
+                    m_invert = d.format.invert;
+                    m_isSigned = d.format.isSigned;
+                    m_slope = d.format.slope;
+                    m_intercept = d.format.intercept;
+                }
+                else
+                {
+                    requantize(z, d.format);
+                }
+                m_windows[z] = {d.format.windowCenter, d.format.windowWidth};
+                infos[z] = d.info;
+                return true;
+            });
+
+        if (!completed)
+        {
+            if (error)
+                *error = QStringLiteral("切层解码失败或尺寸不一致: %1").arg(sources[std::max(bad, 0)].path);
+            clear();
+            return false;
+        }
+
+        computeGeometry(infos);
+        return true;
+    }
+
+    // PET 等逐层 Rescale 不同的序列：在原平面内把存储值换算到第一层的 Rescale
+    void Volume::requantize(int z, const FrameSamples &format)
+    {
+        if (format.isSigned == m_isSigned && format.slope == m_slope && format.intercept == m_intercept)
+            return;
+        const double slope = (m_slope != 0.0) ? m_slope : 1.0;
+        const long lo = m_isSigned ? -32768L : 0L;
+        const long hi = m_isSigned ? 32767L : 65535L;
+        uint16_t *data = m_voxels.data() + static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * static_cast<size_t>(z);
+        const size_t count = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double stored = format.isSigned ? static_cast<double>(static_cast<int16_t>(data[i])) : static_cast<double>(data[i]);
+            const double value = format.intercept + format.slope * stored;
+            data[i] = static_cast<uint16_t>(std::clamp(std::lround((value - m_intercept) / slope), lo, hi));
+        }
+    }
+
+    void Volume::clear()
+    {
+        std::vector<uint16_t>().swap(m_voxels);
+        m_windows.clear();
+        m_width = m_height = m_depth = 0;
+        m_spacingX = m_spacingY = m_spacingZ = 1.0;
+        m_origin = {0.0, 0.0, 0.0};
+        m_rowDir = {1.0, 0.0, 0.0};
+        m_colDir = {0.0, 1.0, 0.0};
+        m_sliceDir = {0.0, 0.0, 1.0};
+        m_zTowardsHead = false;
+        m_invert = false;
+        m_isSigned = false;
+        m_slope = 1.0;
+        m_intercept = 0.0;
+    }
+
+    void Volume::computeGeometry(const QVector<SliceInfo> &infos)
+    {
+        const SliceInfo &ref = infos.front();
+        m_spacingX = (ref.spacingX > 0.0) ? ref.spacingX : 1.0;
+        m_spacingY = (ref.spacingY > 0.0) ? ref.spacingY : 1.0;
+        m_origin = ref.imagePosition;
+        m_rowDir = ref.rowCosines;
+        m_colDir = ref.colCosines;
+        m_sliceDir = cross(m_rowDir, m_colDir);
+
+        // 层间距取相邻层位置在法向上投影差的中位数，缺少位置时退回层厚
+        std::vector<double> gaps;
+        gaps.reserve(static_cast<size_t>(infos.size()));
+        for (int z = 1; z < infos.size(); ++z)
+        {
+            if (!infos[z].hasPosition || !infos[z - 1].hasPosition)
+                continue;
+            const double d = dot(infos[z].imagePosition, m_sliceDir) - dot(infos[z - 1].imagePosition, m_sliceDir);
+            if (std::fabs(d) > 1e-6)
+                gaps.push_back(std::fabs(d));
+        }
+        if (!gaps.empty())
+        {
+            std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+            m_spacingZ = gaps[gaps.size() / 2];
+        }
+        else
+        {
+            m_spacingZ = (ref.sliceThickness > 0.0) ? ref.sliceThickness : 1.0;
+        }
+
+        // LPS 坐标系中 +Z 指向头侧
+        const SliceInfo &last = infos.back();
+        if (ref.hasPosition && last.hasPosition)
+        {
+            m_zTowardsHead = last.imagePosition[2] > ref.imagePosition[2];
+            if (dot(last.imagePosition, m_sliceDir) < dot(ref.imagePosition, m_sliceDir))
+                m_sliceDir = {-m_sliceDir[0], -m_sliceDir[1], -m_sliceDir[2]};
+        }
+    }
+
+    const uint16_t *Volume::slice(int z) const
+    {
+        if (z < 0 || z >= m_depth)
+            return nullptr;
+        return m_voxels.data() + static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * static_cast<size_t>(z);
+    }
+
+    void Volume::sliceWindow(int z, double &center, double &width) const
+    {
+        center = width = 0.0;
+        if (z < 0 || z >= m_windows.size())
+            return;
+        center = m_windows[z].center;
+        width = m_windows[z].width;
+    }
+
+    int Volume::sliceCount(Axis axis) const
+    {
+        switch (axis)
+        {
+        case Axis::Axial:
+            return m_depth;
+        case Axis::Coronal:
+            return m_height;
+        case Axis::Sagittal:
+            return m_width;
+        }
+        return 0;
+    }
+
+    QSizeF Volume::pixelSpacing(Axis axis) const
+    {
+        switch (axis)
+        {
+        case Axis::Axial:
+            return {m_spacingX, m_spacingY};
+        case Axis::Coronal:
+            return {m_spacingX, m_spacingZ};
+        case Axis::Sagittal:
+            return {m_spacingY, m_spacingZ};
+        }
+        return {1.0, 1.0};
+    }
+
+    std::vector<uint16_t> Volume::reslice(Axis axis, int index, int &outWidth, int &outHeight) const
+    {
+        outWidth = outHeight = 0;
+        if (isEmpty() || index < 0 || index >= sliceCount(axis))
+            return {};
+
+        const size_t plane = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+        std::vector<uint16_t> out;
+        switch (axis)
+        {
+        case Axis::Axial:
+        {
+            outWidth = m_width;
+            outHeight = m_height;
+            const uint16_t *src = slice(index);
+            out.assign(src, src + plane);
+            break;
+        }
+        case Axis::Coronal:
+        {
+            // 每个 z 层取第 index 行，整行连续拷贝
+            outWidth = m_width;
+            outHeight = m_depth;
+            out.resize(static_cast<size_t>(m_width) * static_cast<size_t>(m_depth));
+            for (int z = 0; z < m_depth; ++z)
+            {
+                const uint16_t *src = slice(z) + static_cast<size_t>(index) * static_cast<size_t>(m_width);
+                std::memcpy(out.data() + static_cast<size_t>(rowForSlice(z)) * static_cast<size_t>(m_width),
+                            src, static_cast<size_t>(m_width) * sizeof(uint16_t));
+            }
+            break;
+        }
+        case Axis::Sagittal:
+        {
+            // 按层顺序读取，每层内沿行步进，输出行顺序写入
+            outWidth = m_height;
+            outHeight = m_depth;
+            out.resize(static_cast<size_t>(m_height) * static_cast<size_t>(m_depth));
+            for (int z = 0; z < m_depth; ++z)
+            {
+                const uint16_t *src = slice(z) + index;
+                uint16_t *dst = out.data() + static_cast<size_t>(rowForSlice(z)) * static_cast<size_t>(m_height);
+                for (int y = 0; y < m_height; ++y)
+                    dst[y] = src[static_cast<size_t>(y) * static_cast<size_t>(m_width)];
+            }
+            break;
+        }
+        }
+        return out;
+    }
+
+    QImage Volume::render(Axis axis, int index) const
+    {
+        if (isEmpty() || index < 0 || index >= sliceCount(axis))
+            return {};
+
+        if (axis == Axis::Axial)
+        {
+            const SliceWindow &win = m_windows[index];
+            return windowToQImage(slice(index), m_isSigned, m_width, m_height, m_width, m_slope, m_intercept,
+                                  win.center, win.width, m_invert);
+        }
+
+        int w = 0;
+        int h = 0;
+        const std::vector<uint16_t> plane = reslice(axis, index, w, h);
+        const SliceWindow &win = m_windows.front();
+        QImage img = windowToQImage(plane.data(), m_isSigned, w, h, w, m_slope, m_intercept,
+                                    win.center, win.width, m_invert);
+
+        const QSizeF px = pixelSpacing(axis);
+        if (px.width() > 0.0 && std::fabs(px.height() - px.width()) > 1e-3)
+        {
+            const int scaledH = std::max(1, static_cast<int>(std::lround(h * px.height() / px.width())));
+            img = img.scaled(w, scaledH, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        return img;
+    }
+
+} // namespace DicomUtils
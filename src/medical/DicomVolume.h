@@ -0,0 +1,103 @@
+#pragma once
+#include <QImage>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "DicomUtils.h"
+
+namespace DicomUtils
+{
+    /**
+     * @brief 由排好序的序列组装的连续 16 位体数据
+     * @details 体素按 [z][y][x] 行主序存放，z 与序列导航器中的切层序号一致，保存 16 位存储值，
+     *          模态值 = rescaleIntercept() + rescaleSlope() * 存储值；
+     *          几何信息取自 Image Position / Orientation Patient。
+     */
+    class Volume
+    {
+    public:
+        enum class Axis
+        {
+            Axial,
+            Coronal,
+            Sagittal
+        };
+
+        struct Source
+        {
+            QString path;
+            int frameIndex{0};
+        };
+
+        /**
+         * @brief 通过 SeriesDecoder 并行解码所有切层，直接写入各自的体数据平面
+         * @details Rescale 与第一层不同的切层在原平面内换算到体数据的 Rescale
+         * @param sources 切层来源，顺序即 z 序号
+         * @param error 失败原因（可选）
+         */
+        bool build(const QVector<Source> &sources, QString *error = nullptr);
+        void clear();
+
+        bool isEmpty() const { return m_voxels.empty(); }
+        int width() const { return m_width; }
+        int height() const { return m_height; }
+        int depth() const { return m_depth; }
+        double spacingX() const { return m_spacingX; }
+        double spacingY() const { return m_spacingY; }
+        double spacingZ() const { return m_spacingZ; }
+        const std::array<double, 3> &origin() const { return m_origin; }
+        const std::array<double, 3> &rowDirection() const { return m_rowDir; }
+        const std::array<double, 3> &columnDirection() const { return m_colDir; }
+        const std::array<double, 3> &sliceDirection() const { return m_sliceDir; }
+
+        // 轴位切层的连续内存（width * height 个体素）；isSigned() 时按 int16_t 解读
+        const uint16_t *slice(int z) const;
+        bool isSigned() const { return m_isSigned; }
+        double rescaleSlope() const { return m_slope; }
+        double rescaleIntercept() const { return m_intercept; }
+        // 切层自带的窗宽窗位（width <= 0 表示未给出）
+        void sliceWindow(int z, double &center, double &width) const;
+        bool isInverted() const { return m_invert; }
+        int sliceCount(Axis axis) const;
+        // 切面图像的像素物理尺寸（毫米，宽 x 高）
+        QSizeF pixelSpacing(Axis axis) const;
+
+        // 原始采样的 16 位切面；冠状/矢状面每行对应一个 z，头侧在上
+        std::vector<uint16_t> reslice(Axis axis, int index, int &outWidth, int &outHeight) const;
+        // 显示用 8 位切面；非轴位切面按层间距重采样为方形像素
+        QImage render(Axis axis, int index) const;
+
+    private:
+        struct SliceWindow
+        {
+            double center{0.0};
+            double width{0.0};
+        };
+
+        int rowForSlice(int z) const { return m_zTowardsHead ? (m_depth - 1 - z) : z; }
+        void computeGeometry(const QVector<SliceInfo> &infos);
+        void requantize(int z, const FrameSamples &format);
+
+        std::vector<uint16_t> m_voxels;
+        QVector<SliceWindow> m_windows;
+        int m_width{0};
+        int m_height{0};
+        int m_depth{0};
+        double m_spacingX{1.0};
+        double m_spacingY{1.0};
+        double m_spacingZ{1.0};
+        std::array<double, 3> m_origin{0.0, 0.0, 0.0};
+        std::array<double, 3> m_rowDir{1.0, 0.0, 0.0};
+        std::array<double, 3> m_colDir{0.0, 1.0, 0.0};
+        std::array<double, 3> m_sliceDir{0.0, 0.0, 1.0};
+        bool m_zTowardsHead{false}; // z 增大指向头侧时，冠状/矢状面需要翻转行序
+        bool m_invert{false};
+        bool m_isSigned{false};
+        double m_slope{1.0};
+        double m_intercept{0.0};
+    };
+}
@@ -0,0 +1,40 @@
+#include "SeriesDecoder.h"
+#include "AppConfig.h"
+#include <QThread>
+
+namespace DicomUtils
+{
+
+    SeriesDecoder &SeriesDecoder::instance()
+    {
+        static SeriesDecoder decoder;
+        return decoder;
+    }
+
+    SeriesDecoder::SeriesDecoder()
+    {
+        m_pool.setObjectName(QStringLiteral("SeriesDecoder"));
+        applyConfig();
+    }
+
+    void SeriesDecoder::setThreadCount(int threads)
+    {
+        m_pool.setMaxThreadCount(std::max(1, threads));
+    }
+
+    void SeriesDecoder::applyConfig()
+    {
+        const AppConfig &config = AppConfig::instance();
+        int threads = config.decodeThreadCount();
+        if (threads <= 0)
+        {
+            // 未显式配置时为推理预留线程：InferenceThreads 未设置则预留一半核心
+            const int ideal = std::max(1, QThread::idealThreadCount());
+            const int inference = config.inferenceThreadCount();
+            const int reserved = (inference > 0) ? inference : ideal / 2;
+            threads = ideal - reserved;
+        }
+        setThreadCount(threads);
+    }
+
+} // namespace DicomUtils
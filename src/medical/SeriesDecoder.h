@@ -0,0 +1,83 @@
+#pragma once
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <deque>
+#include <functional>
+
+namespace DicomUtils
+{
+    /**
+     * @brief 序列解码服务：在有界线程池中并行解压各帧，并按输入顺序交付
+     * @details JPEG 2000 / JPEG-LS 等封装传输语法的解压是单线程的，整序列加载时
+     *          由本服务把各帧分散到工作线程上。线程数由 Performance/DecodeThreads
+     *          控制，默认为推理线程预留核心，避免与 ONNX Runtime 争抢 CPU。
+     */
+    class SeriesDecoder
+    {
+    public:
+        static SeriesDecoder &instance();
+
+        int threadCount() const { return m_pool.maxThreadCount(); }
+        void setThreadCount(int threads);
+        // 按配置重新计算线程数（DecodeThreads <= 0 时自动扣除推理线程）
+        void applyConfig();
+
+        /**
+         * @brief 并行解码 count 帧，按 0..count-1 的顺序把结果交给 sink
+         * @param decode 在工作线程中执行，须可重入
+         * @param sink 在调用线程中执行；返回 false 时停止提交并等待在途任务结束
+         * @return 全部交付完成时返回 true
+         * @details 在途任务数不超过线程数的两倍，内存占用与序列长度无关。
+         */
+        template <typename T>
+        bool run(int count,
+                 const std::function<T(int)> &decode,
+                 const std::function<bool(int, T &&)> &sink)
+        {
+            if (count <= 0)
+                return true;
+
+            const int window = std::max(1, 2 * m_pool.maxThreadCount());
+            std::deque<QFuture<T>> inFlight;
+            int next = 0;
+            auto submit = [&]()
+            {
+                while (next < count && static_cast<int>(inFlight.size()) < window)
+                {
+                    const int index = next++;
+                    inFlight.push_back(QtConcurrent::run(&m_pool, [&decode, index]()
+                                                         { return decode(index); }));
+                }
+            };
+
+            submit();
+            bool completed = true;
+            for (int i = 0; i < count; ++i)
+            {
+                QFuture<T> future = inFlight.front();
+                inFlight.pop_front();
+                future.waitForFinished();
+                if (!sink(i, future.takeResult()))
+                {
+                    completed = false;
+                    break;
+                }
+                submit();
+            }
+
+            // decode 以引用方式被捕获，返回前必须等在途任务结束
+            for (QFuture<T> &future : inFlight)
+                future.waitForFinished();
+            return completed;
+        }
+
+    private:
+        SeriesDecoder();
+        SeriesDecoder(const SeriesDecoder &) = delete;
+        SeriesDecoder &operator=(const SeriesDecoder &) = delete;
+
+        QThreadPool m_pool;
+    };
+}
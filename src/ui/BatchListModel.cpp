@@ -0,0 +1,186 @@
+#include "BatchListModel.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    inline quint64 trigramKey(const QChar *s)
+    {
+        return (quint64(s[0].unicode()) << 32) | (quint64(s[1].unicode()) << 16) | quint64(s[2].unicode());
+    }
+}
+
+BatchListModel::BatchListModel(QObject *parent) : QAbstractListModel(parent) {}
+
+int BatchListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_visible.size());
+}
+
+QVariant BatchListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= static_cast<int>(m_visible.size()))
+        return {};
+    if (role == Qt::DisplayRole || role == Qt::ToolTipRole)
+        return m_paths[m_visible[static_cast<size_t>(index.row())]];
+    return {};
+}
+
+void BatchListModel::clear()
+{
+    beginResetModel();
+    m_paths.clear();
+    m_keys.clear();
+    m_order.clear();
+    m_rank.clear();
+    m_trigrams.clear();
+    m_visible.clear();
+    endResetModel();
+}
+
+void BatchListModel::appendPaths(const QStringList &paths)
+{
+    if (paths.isEmpty())
+        return;
+
+    std::vector<int> added;
+    added.reserve(static_cast<size_t>(paths.size()));
+    for (const QString &path : paths)
+    {
+        const int id = static_cast<int>(m_paths.size());
+        const QString key = path.toLower();
+        m_paths.append(path);
+        m_keys.append(key);
+        m_order.push_back(id);
+        m_rank.push_back(id);
+
+        // 同一路径内重复的三字符组只记一次，保证 id 列表升序且无重复
+        const QChar *chars = key.constData();
+        for (int i = 0; i + 3 <= key.size(); ++i)
+        {
+            std::vector<int> &posting = m_trigrams[trigramKey(chars + i)];
+            if (posting.empty() || posting.back() != id)
+                posting.push_back(id);
+        }
+
+        if (matches(id))
+            added.push_back(id);
+    }
+
+    if (added.empty())
+        return;
+    const int first = static_cast<int>(m_visible.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+    m_visible.insert(m_visible.end(), added.begin(), added.end());
+    endInsertRows();
+}
+
+void BatchListModel::sortPaths()
+{
+    beginResetModel();
+    std::sort(m_order.begin(), m_order.end(), [this](int a, int b)
+              { return m_paths[a] < m_paths[b]; });
+    for (size_t pos = 0; pos < m_order.size(); ++pos)
+        m_rank[static_cast<size_t>(m_order[pos])] = static_cast<int>(pos);
+    rebuildVisible();
+    endResetModel();
+}
+
+void BatchListModel::setFilterText(const QString &text)
+{
+    const QString filter = text.toLower();
+    if (filter == m_filter)
+        return;
+    beginResetModel();
+    m_filter = filter;
+    rebuildVisible();
+    endResetModel();
+}
+
+bool BatchListModel::matches(int id) const
+{
+    return m_filter.isEmpty() || m_keys[id].contains(m_filter);
+}
+
+std::vector<int> BatchListModel::candidatesFor(const QString &needle) const
+{
+    // 过滤串的所有三字符组对应 id 列表求交集，从最短的列表开始
+    std::vector<const std::vector<int> *> lists;
+    const QChar *chars = needle.constData();
+    for (int i = 0; i + 3 <= needle.size(); ++i)
+    {
+        auto it = m_trigrams.constFind(trigramKey(chars + i));
+        if (it == m_trigrams.constEnd())
+            return {};
+        lists.push_back(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<int> *a, const std::vector<int> *b)
+              { return a->size() < b->size(); });
+
+    std::vector<int> result = *lists.front();
+    std::vector<int> scratch;
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i)
+    {
+        scratch.clear();
+        std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(scratch));
+        result.swap(scratch);
+    }
+    return result;
+}
+
+void BatchListModel::rebuildVisible()
+{
+    m_visible.clear();
+    if (m_filter.isEmpty())
+    {
+        m_visible = m_order;
+        return;
+    }
+
+    if (m_filter.size() >= 3)
+    {
+        // 三字符组只能说明可能包含，仍需校验子串
+        for (int id : candidatesFor(m_filter))
+        {
+            if (m_keys[id].contains(m_filter))
+                m_visible.push_back(id);
+        }
+        std::sort(m_visible.begin(), m_visible.end(), [this](int a, int b)
+                  { return m_rank[static_cast<size_t>(a)] < m_rank[static_cast<size_t>(b)]; });
+        return;
+    }
+
+    // 一两个字符的过滤串不走索引，直接在预先转好小写的路径上查找
+    for (int id : m_order)
+    {
+        if (m_keys[id].contains(m_filter))
+            m_visible.push_back(id);
+    }
+}
+
+QString BatchListModel::pathAt(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_visible.size()))
+        return {};
+    return m_paths[m_visible[static_cast<size_t>(row)]];
+}
+
+int BatchListModel::rowOfPath(const QString &path) const
+{
+    for (size_t row = 0; row < m_visible.size(); ++row)
+    {
+        if (m_paths[m_visible[row]] == path)
+            return static_cast<int>(row);
+    }
+    return -1;
+}
+
+QStringList BatchListModel::allPaths() const
+{
+    QStringList out;
+    out.reserve(static_cast<qsizetype>(m_order.size()));
+    for (int id : m_order)
+        out.append(m_paths[id]);
+    return out;
+}
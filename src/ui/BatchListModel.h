@@ -0,0 +1,43 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// 批量文件列表模型：只保存路径与过滤索引，由 QListView 按需绘制可见行
+class BatchListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit BatchListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void clear();
+    // 追加一批路径（扫描过程中按块调用），同时更新过滤索引
+    void appendPaths(const QStringList &paths);
+    // 扫描结束后按路径整体排序一次
+    void sortPaths();
+    void setFilterText(const QString &text);
+
+    QString pathAt(int row) const;
+    int rowOfPath(const QString &path) const;
+    int totalCount() const { return static_cast<int>(m_paths.size()); }
+    // 全部路径（不受过滤影响），按当前排序
+    QStringList allPaths() const;
+
+private:
+    bool matches(int id) const;
+    std::vector<int> candidatesFor(const QString &needle) const;
+    void rebuildVisible();
+
+    QStringList m_paths;                          // 按追加顺序，下标即条目 id
+    QStringList m_keys;                           // 小写路径，用于校验匹配
+    std::vector<int> m_order;                     // 排序后的 id 序列
+    std::vector<int> m_rank;                      // id -> 在 m_order 中的位置
+    QHash<quint64, std::vector<int>> m_trigrams;  // 三字符组 -> 升序 id 列表
+    QString m_filter;                             // 小写过滤串
+    std::vector<int> m_visible;                   // 当前显示的 id
+};
@@ -0,0 +1,74 @@
+#include "FolderScanner.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QPointer>
+#include <QtConcurrent>
+#include <algorithm>
+
+FolderScanner::FolderScanner(QObject *parent) : QObject(parent) {}
+
+FolderScanner::~FolderScanner()
+{
+    cancel();
+    m_future.waitForFinished();
+}
+
+void FolderScanner::cancel()
+{
+    if (m_cancel)
+        m_cancel->store(true);
+    ++m_generation;
+}
+
+bool FolderScanner::isRunning() const
+{
+    return m_future.isRunning();
+}
+
+void FolderScanner::start(const QString &root, std::function<bool(const QString &)> accept, int chunkSize)
+{
+    cancel();
+    const int generation = m_generation;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_cancel = cancelled;
+    QPointer<FolderScanner> guard(this);
+    chunkSize = std::max(1, chunkSize);
+
+    m_future = QtConcurrent::run([guard, generation, cancelled, root, accept = std::move(accept), chunkSize]()
+                                 {
+        QStringList chunk;
+        int total = 0;
+        auto deliver = [&](bool last)
+        {
+            QStringList out;
+            out.swap(chunk);
+            if (!guard)
+                return;
+            QMetaObject::invokeMethod(
+                guard,
+                [guard, generation, out, last, total]()
+                {
+                    // 取消或重新扫描后，队列中残留的旧结果不再转发
+                    if (!guard || guard->m_generation != generation)
+                        return;
+                    if (!out.isEmpty())
+                        emit guard->chunkReady(out);
+                    if (last)
+                        emit guard->finished(total);
+                },
+                Qt::QueuedConnection);
+        };
+
+        QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext() && !cancelled->load())
+        {
+            const QString path = it.next();
+            if (!accept(path))
+                continue;
+            chunk << path;
+            ++total;
+            if (chunk.size() >= chunkSize)
+                deliver(false);
+        }
+        deliver(true); });
+}
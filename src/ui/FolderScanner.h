@@ -0,0 +1,31 @@
+#pragma once
+#include <QFuture>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// 后台遍历目录，按块把匹配的文件路径送回 GUI 线程
+class FolderScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FolderScanner(QObject *parent = nullptr);
+    ~FolderScanner() override;
+
+    // 启动新的扫描会取消上一次扫描；被取消的扫描不再发出任何信号
+    void start(const QString &root, std::function<bool(const QString &)> accept, int chunkSize = 512);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void chunkReady(const QStringList &paths);
+    void finished(int total);
+
+private:
+    QFuture<void> m_future;
+    std::shared_ptr<std::atomic_bool> m_cancel;
+    int m_generation{0};
+};
@@ -8,7 +8,13 @@ ImageView::ImageView(QWidget *parent) : QGraphicsView(parent), m_scene(new QGrap
     setScene(m_scene);
     setDragMode(QGraphicsView::NoDrag);
     setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+    // 瓦片按可见区域绘制，只重绘暴露区域
+    setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
     setBackgroundBrush(QColor(244, 246, 250));
+
+    m_overlay = new OverlayLayer;
+    m_overlay->setZValue(1.0);
+    m_scene->addItem(m_overlay);
 }
 
 // void ImageView::setImage(const QImage &img)
@@ -43,9 +49,11 @@ ImageView::ImageView(QWidget *parent) : QGraphicsView(parent), m_scene(new QGrap
 void ImageView::setImage(const QImage &img, bool fitToWindow)
 {
     if (!m_pix)
-        m_pix = m_scene->addPixmap(QPixmap::fromImage(img));
-    else
-        m_pix->setPixmap(QPixmap::fromImage(img));
+    {
+        m_pix = new TiledImageItem;
+        m_scene->addItem(m_pix);
+    }
+    m_pix->setImage(img);
     m_scene->setSceneRect(m_pix->boundingRect());
     if (fitToWindow || !transform().isScaling())
         resetZoom(); // 首次或要求 fit：自适应视口
@@ -60,10 +68,36 @@ void ImageView::clearImage()
         delete m_pix;
         m_pix = nullptr;
     }
-    m_scene->clear();
+    clearOverlay();
+    m_scene->setSceneRect(QRectF());
     m_scale = 1.0;
 }
 
+void ImageView::setOverlay(const QVector<OverlayLayer::Box> &boxes, const QImage &labelMask, OverlayLayer::Style style)
+{
+    m_overlay->setContent(boxes, labelMask, style);
+}
+
+void ImageView::clearOverlay()
+{
+    m_overlay->clearContent();
+}
+
+void ImageView::setClassVisible(int cls, bool visible)
+{
+    m_overlay->setClassVisible(cls, visible);
+}
+
+void ImageView::setClassOpacity(int cls, qreal opacity)
+{
+    m_overlay->setClassOpacity(cls, opacity);
+}
+
+void ImageView::setMasksVisible(bool visible)
+{
+    m_overlay->setMasksVisible(visible);
+}
+
 void ImageView::setSliceNavigationEnabled(bool enabled)
 {
     m_sliceNavigationEnabled = enabled;
@@ -72,7 +106,7 @@ void ImageView::resetZoom()
 {
     resetTransform();
     m_scale = 1.0;
-    fitInView(m_scene->itemsBoundingRect(), Qt::KeepAspectRatio);
+    fitInView(m_pix ? m_pix->boundingRect() : m_scene->itemsBoundingRect(), Qt::KeepAspectRatio);
 }
 void ImageView::wheelEvent(QWheelEvent *e)
 {
@@ -1,7 +1,8 @@
 #pragma once
 #include <QGraphicsView>
 #include <QImage>
-#include <QGraphicsPixmapItem>
+#include "OverlayLayer.h"
+#include "TiledImageItem.h"
 class ImageView : public QGraphicsView
 {
     Q_OBJECT
@@ -11,6 +12,12 @@ public:
     // fitToWindow=true: 以视口自适应方式显示；false: 保持当前缩放（用于输出图与输入图一致显示）
     void setImage(const QImage &img, bool fitToWindow = true);
     void clearImage();
+    // 结果叠加层：底图不变时只替换图元，类别可见性/不透明度在多次 setOverlay 之间保留
+    void setOverlay(const QVector<OverlayLayer::Box> &boxes, const QImage &labelMask, OverlayLayer::Style style);
+    void clearOverlay();
+    void setClassVisible(int cls, bool visible);
+    void setClassOpacity(int cls, qreal opacity);
+    void setMasksVisible(bool visible);
     QTransform viewTransform() const { return transform(); }
     void applyViewTransform(const QTransform &t) { setTransform(t); }
     void setSliceNavigationEnabled(bool enabled);
@@ -28,7 +35,8 @@ protected:
 private:
     void resetZoom();
     QGraphicsScene *m_scene;
-    QGraphicsPixmapItem *m_pix{nullptr};
+    TiledImageItem *m_pix{nullptr}; // 分块金字塔显示，同尺寸图像只刷新变化瓦片
+    OverlayLayer *m_overlay{nullptr};
     double m_scale{1.0};
     QPoint m_lastPos;
     bool m_panning{false};
@@ -0,0 +1,178 @@
+#include "LogModel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <algorithm>
+
+namespace
+{
+    QString levelName(ErrorType type)
+    {
+        switch (type)
+        {
+        case ErrorType::INFO:
+            return QStringLiteral("INFO");
+        case ErrorType::WARNING:
+            return QStringLiteral("WARNING");
+        case ErrorType::ERROR:
+            return QStringLiteral("ERROR");
+        case ErrorType::CRITICAL:
+            return QStringLiteral("CRITICAL");
+        case ErrorType::DEBUG:
+            return QStringLiteral("DEBUG");
+        }
+        return QStringLiteral("UNKNOWN");
+    }
+}
+
+LogModel::LogModel(int maxEntries, QObject *parent)
+    : QAbstractTableModel(parent), m_maxEntries(std::max(1, maxEntries))
+{
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int LogModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= static_cast<int>(m_rows.size()))
+        return {};
+
+    const LogRecord &r = m_rows[static_cast<size_t>(index.row())];
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        switch (index.column())
+        {
+        case TimeColumn:
+            // 只在行可见时格式化时间戳
+            return QDateTime::fromMSecsSinceEpoch(r.timestampMs).toString(QStringLiteral("HH:mm:ss.zzz"));
+        case LevelColumn:
+            return levelName(r.type);
+        case ModuleColumn:
+            return r.module;
+        case MessageColumn:
+            return r.code != 0 ? QStringLiteral("%1 [Code: %2]").arg(r.message).arg(r.code) : r.message;
+        default:
+            return {};
+        }
+    case Qt::ForegroundRole:
+        switch (r.type)
+        {
+        case ErrorType::WARNING:
+            return QBrush(QColor(230, 160, 40));
+        case ErrorType::ERROR:
+        case ErrorType::CRITICAL:
+            return QBrush(QColor(230, 70, 70));
+        case ErrorType::DEBUG:
+            return QBrush(QColor(140, 140, 140));
+        default:
+            return {};
+        }
+    case Qt::ToolTipRole:
+        return index.column() == MessageColumn ? r.message : QVariant();
+    case SeverityRole:
+        return logSeverity(r.type);
+    case ModuleRole:
+        return r.module;
+    default:
+        return {};
+    }
+}
+
+QVariant LogModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return {};
+    switch (section)
+    {
+    case TimeColumn:
+        return tr("Time");
+    case LevelColumn:
+        return tr("Level");
+    case ModuleColumn:
+        return tr("Module");
+    case MessageColumn:
+        return tr("Message");
+    default:
+        return {};
+    }
+}
+
+void LogModel::appendBatch(std::vector<LogRecord> &&records)
+{
+    if (records.empty())
+        return;
+
+    // 单批超过上限时只保留最新的部分
+    size_t first = 0;
+    if (records.size() > static_cast<size_t>(m_maxEntries))
+        first = records.size() - static_cast<size_t>(m_maxEntries);
+    const int incoming = static_cast<int>(records.size() - first);
+
+    const int overflow = static_cast<int>(m_rows.size()) + incoming - m_maxEntries;
+    if (overflow > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_rows.erase(m_rows.begin(), m_rows.begin() + overflow);
+        endRemoveRows();
+    }
+
+    const int start = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), start, start + incoming - 1);
+    for (size_t i = first; i < records.size(); ++i)
+    {
+        LogRecord &r = records[i];
+        if (!m_modules.contains(r.module))
+        {
+            m_modules.insert(r.module);
+            m_moduleList.append(r.module);
+            emit moduleAdded(r.module);
+        }
+        m_rows.push_back(std::move(r));
+    }
+    endInsertRows();
+}
+
+void LogModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    endResetModel();
+}
+
+LogFilterModel::LogFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+}
+
+void LogFilterModel::setMinimumSeverity(int severity)
+{
+    if (severity == m_minSeverity)
+        return;
+    m_minSeverity = severity;
+    invalidateFilter();
+}
+
+void LogFilterModel::setModule(const QString &module)
+{
+    if (module == m_module)
+        return;
+    m_module = module;
+    invalidateFilter();
+}
+
+bool LogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    const QModelIndex idx = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (sourceModel()->data(idx, LogModel::SeverityRole).toInt() < m_minSeverity)
+        return false;
+    return m_module.isEmpty() || sourceModel()->data(idx, LogModel::ModuleRole).toString() == m_module;
+}
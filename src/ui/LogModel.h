@@ -0,0 +1,70 @@
+#pragma once
+#include <QAbstractTableModel>
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QString>
+#include <QStringList>
+#include <deque>
+#include <vector>
+
+#include "ErrorHandler.h"
+
+// 运行日志模型：有界滚动缓冲，按批追加；视图只绘制可见行
+class LogModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column
+    {
+        TimeColumn,
+        LevelColumn,
+        ModuleColumn,
+        MessageColumn,
+        ColumnCount
+    };
+    enum Role
+    {
+        SeverityRole = Qt::UserRole + 1,
+        ModuleRole
+    };
+
+    explicit LogModel(int maxEntries = 5000, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // 追加一批日志，超出上限时先整段移除最旧的行
+    void appendBatch(std::vector<LogRecord> &&records);
+    void clear();
+    QStringList modules() const { return m_moduleList; }
+
+signals:
+    void moduleAdded(const QString &module);
+
+private:
+    std::deque<LogRecord> m_rows;
+    int m_maxEntries;
+    QSet<QString> m_modules;
+    QStringList m_moduleList;
+};
+
+// 按最低级别与模块过滤；新行到达时只对新行求值，不重建整个视图
+class LogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit LogFilterModel(QObject *parent = nullptr);
+
+    void setMinimumSeverity(int severity);
+    // 空字符串表示全部模块
+    void setModule(const QString &module);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    int m_minSeverity{0};
+    QString m_module;
+};
@@ -2,13 +2,24 @@
 #include "ImageView.h"
 #include "InferenceEngine.h"
 #include "DicomUtils.h"
+#include "SeriesDecoder.h"
 #include "MetaTable.h"
 #include "AppConfig.h"
 #include "ErrorHandler.h"
+#include "BatchListModel.h"
+#include "FolderScanner.h"
+#include "ExportEncoder.h"
+#include "PredictionWriter.h"
+#include "PrecisionReport.h"
+#include "ResultCache.h"
+#include "LogModel.h"
 #include <QToolBar>
 #include <QFileDialog>
 #include <QTabWidget>
-#include <QPlainTextEdit>
+#include <QTableView>
+#include <QComboBox>
+#include <QPushButton>
+#include <QScrollBar>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QStatusBar>
@@ -16,8 +27,9 @@
 #include <QMessageBox>
 #include <QLabel>
 #include <QDockWidget>
-#include <QListWidget>
-#include <QDirIterator>
+#include <QListView>
+#include <QItemSelectionModel>
+#include <QDir>
 #include <QFileInfo>
 #include <QWidget>
 #include <QJsonDocument>
@@ -38,38 +50,106 @@
 #include <QTableWidget>
 #include <QTableWidgetItem>
 #include <QHeaderView>
+#include <QCheckBox>
+#include <QSlider>
+#include <QSignalBlocker>
 #include <QAbstractItemView>
 #include <cmath>
 #include <algorithm>
 #include <QResizeEvent>
+#include <QActionGroup>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <atomic>
+#include <deque>
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 {
-    // 初始化配置和错误处理器
-    AppConfig::instance().loadConfig();
+    // 初始化配置和错误处理器；配置文件被修改后自动重新加载并重新应用
+    AppConfig &config = AppConfig::instance();
+    config.loadConfig();
+    config.setWatchEnabled(true);
+    applyConfig(*config.current());
+    m_configSubscription = config.subscribe([this](const AppConfig::Snapshot &snapshot)
+                                            { applyConfig(snapshot); });
 
     m_singleWatcher.setParent(this);
     m_batchWatcher.setParent(this);
     connect(&m_singleWatcher, &QFutureWatcher<InferenceEngine::Result>::finished,
             this, &MainWindow::handleSingleInferenceFinished);
-    connect(&m_batchWatcher, &QFutureWatcher<std::vector<BatchItem>>::finished,
+    m_restoreWatcher.setParent(this);
+    connect(&m_restoreWatcher, &QFutureWatcher<InferenceEngine::Result>::finished,
+            this, &MainWindow::handleRestoreFinished);
+    connect(&m_batchWatcher, &QFutureWatcher<void>::finished,
             this, &MainWindow::handleBatchInferenceFinished);
+    m_exportWatcher.setParent(this);
+    connect(&m_exportWatcher, &QFutureWatcher<ExportSummary>::finished,
+            this, &MainWindow::handleBatchExportFinished);
+    m_reportWatcher.setParent(this);
+    connect(&m_reportWatcher, &QFutureWatcher<PrecisionReport::Summary>::finished,
+            this, &MainWindow::handlePrecisionReportFinished);
+    m_volumeWatcher.setParent(this);
+    connect(&m_volumeWatcher, &QFutureWatcher<std::shared_ptr<const DicomUtils::Volume>>::finished,
+            this, &MainWindow::handleVolumeBuildFinished);
 
     setupUi();
 }
 
 MainWindow::~MainWindow()
 {
+    AppConfig::instance().unsubscribe(m_configSubscription);
     if (m_singleWatcher.isRunning())
     {
         m_singleWatcher.cancel();
         m_singleWatcher.waitForFinished();
     }
+    if (m_restoreWatcher.isRunning())
+        m_restoreWatcher.waitForFinished();
     if (m_batchWatcher.isRunning())
     {
+        // 先关闭结果队列，避免工作线程阻塞在背压等待上
+        if (m_batchQueue)
+            m_batchQueue->close();
         m_batchWatcher.cancel();
         m_batchWatcher.waitForFinished();
     }
+    if (m_exportWatcher.isRunning())
+    {
+        if (m_exportCancel)
+            m_exportCancel->store(true);
+        m_exportWatcher.waitForFinished();
+    }
+    if (m_reportWatcher.isRunning())
+    {
+        if (m_reportCancel)
+            m_reportCancel->store(true);
+        m_reportWatcher.waitForFinished();
+    }
+    if (m_volumeWatcher.isRunning())
+        m_volumeWatcher.waitForFinished();
+}
+
+void MainWindow::applyConfig(const AppConfig::Snapshot &config)
+{
+    ErrorHandler &logger = ErrorHandler::instance();
+    if (!logger.setLogLevel(config.logLevel))
+        LOG_WARNING(QStringLiteral("未知日志级别: %1，使用 INFO").arg(config.logLevel), "Config", 1201);
+    logger.setFileOutputEnabled(config.logToFile);
+    logger.setMaxLogSize(config.maxLogSize);
+    if (!config.logFilePath.isEmpty())
+        logger.setLogFilePath(config.logFilePath);
+
+    // 阈值对两个引擎即时生效，无需重新加载模型
+    m_engine.setThresholds(config.confidenceThreshold, config.iouThreshold);
+    m_mriEngine.setThresholds(config.confidenceThreshold, config.iouThreshold);
+    // 类别名变化时刷新叠加层控件
+    if (config.mriClassNames != m_appliedClassNames)
+    {
+        m_appliedClassNames = config.mriClassNames;
+        if (m_layerTable)
+            rebuildLayerControls(m_currentTask);
+    }
 }
 
 void MainWindow::setTaskType(TaskSelectionDialog::TaskType taskType)
@@ -131,6 +211,10 @@ void MainWindow::createToolBar()
     m_actExportAll = tb->addAction(tr("Batch Export"));
     connect(m_actExportAll, &QAction::triggered, this, &MainWindow::exportBatch);
 
+    m_actPrecisionReport = tb->addAction(tr("Precision Report"));
+    m_actPrecisionReport->setToolTip(tr("Compare an FP16 / INT8 model against the FP32 model on a validation folder"));
+    connect(m_actPrecisionReport, &QAction::triggered, this, &MainWindow::runPrecisionReport);
+
     tb->addSeparator();
 
     auto *actClear = tb->addAction(tr("Clear"));
@@ -143,6 +227,28 @@ void MainWindow::createToolBar()
 
     tb->addSeparator();
 
+    // MPR 视图（体数据就绪后可用）
+    auto *axisGroup = new QActionGroup(this);
+    axisGroup->setExclusive(true);
+    m_actAxial = tb->addAction(tr("Axial"));
+    m_actCoronal = tb->addAction(tr("Coronal"));
+    m_actSagittal = tb->addAction(tr("Sagittal"));
+    for (QAction *act : {m_actAxial, m_actCoronal, m_actSagittal})
+    {
+        act->setCheckable(true);
+        act->setEnabled(false);
+        axisGroup->addAction(act);
+    }
+    m_actAxial->setChecked(true);
+    connect(m_actAxial, &QAction::triggered, this, [this]()
+            { setViewAxis(DicomUtils::Volume::Axis::Axial); });
+    connect(m_actCoronal, &QAction::triggered, this, [this]()
+            { setViewAxis(DicomUtils::Volume::Axis::Coronal); });
+    connect(m_actSagittal, &QAction::triggered, this, [this]()
+            { setViewAxis(DicomUtils::Volume::Axis::Sagittal); });
+
+    tb->addSeparator();
+
     m_actToggleLog = tb->addAction(tr("Show Log"));
     m_actToggleLog->setCheckable(true);
     connect(m_actToggleLog, &QAction::toggled, this, &MainWindow::toggleLogDock);
@@ -202,7 +308,14 @@ void MainWindow::createDockWidgets()
     headerLayout->addStretch();
     headerLayout->addWidget(m_batchFilter);
 
-    m_list = new QListWidget(batchContainer);
+    // 大目录下只绘制可见行：统一行高 + 模型按需提供数据
+    m_batchModel = new BatchListModel(this);
+    m_list = new QListView(batchContainer);
+    m_list->setModel(m_batchModel);
+    m_list->setUniformItemSizes(true);
+    m_list->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_list->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_folderScanner = new FolderScanner(this);
     batchLayout->addLayout(headerLayout);
     batchLayout->addWidget(m_list, 1);
     batchContainer->setLayout(batchLayout);
@@ -213,23 +326,72 @@ void MainWindow::createDockWidgets()
 
     connect(m_batchFilter, &QLineEdit::textChanged, this, [this](const QString &text)
             {
-        if (!m_list)
-            return;
-        for (int i = 0; i < m_list->count(); ++i)
-        {
-            auto *item = m_list->item(i);
-            item->setHidden(!item->text().contains(text, Qt::CaseInsensitive));
-        } });
-    connect(m_list, &QListWidget::itemSelectionChanged, this, &MainWindow::onListActivated);
+        m_batchModel->setFilterText(text);
+        selectBatchPath(m_currentPath); });
+    connect(m_list->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::onListActivated);
+    connect(m_folderScanner, &FolderScanner::chunkReady, this, &MainWindow::handleFolderChunk);
+    connect(m_folderScanner, &FolderScanner::finished, this, &MainWindow::handleFolderScanFinished);
 
     // Log dock
     m_logDock = new QDockWidget(tr("Runtime Log"), this);
     m_logDock->setObjectName("LogDock");
     m_logDock->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
-    m_logView = new QPlainTextEdit(m_logDock);
-    m_logView->setReadOnly(true);
-    m_logDock->setWidget(m_logView);
+    auto *logContainer = new QWidget(m_logDock);
+    auto *logLayout = new QVBoxLayout(logContainer);
+    logLayout->setContentsMargins(6, 6, 6, 6);
+    logLayout->setSpacing(4);
+    auto *logFilterLayout = new QHBoxLayout();
+    m_logLevelFilter = new QComboBox(logContainer);
+    m_logLevelFilter->addItem(tr("All levels"), logSeverity(ErrorType::DEBUG));
+    m_logLevelFilter->addItem(tr("Info and above"), logSeverity(ErrorType::INFO));
+    m_logLevelFilter->addItem(tr("Warnings and above"), logSeverity(ErrorType::WARNING));
+    m_logLevelFilter->addItem(tr("Errors only"), logSeverity(ErrorType::ERROR));
+    m_logModuleFilter = new QComboBox(logContainer);
+    m_logModuleFilter->addItem(tr("All modules"), QString());
+    auto *clearLogButton = new QPushButton(tr("Clear"), logContainer);
+    logFilterLayout->addWidget(m_logLevelFilter);
+    logFilterLayout->addWidget(m_logModuleFilter);
+    logFilterLayout->addStretch(1);
+    logFilterLayout->addWidget(clearLogButton);
+
+    // 日志以模型/视图显示：有界滚动缓冲，过滤只作用于代理模型，视图只绘制可见行
+    m_logModel = new LogModel(kLogScrollback, this);
+    m_logFilter = new LogFilterModel(this);
+    m_logFilter->setSourceModel(m_logModel);
+    m_logView = new QTableView(logContainer);
+    m_logView->setModel(m_logFilter);
+    m_logView->setWordWrap(false);
+    m_logView->setShowGrid(false);
+    m_logView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_logView->setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_logView->verticalHeader()->setVisible(false);
+    m_logView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_logView->verticalHeader()->setDefaultSectionSize(m_logView->fontMetrics().height() + 4);
+    m_logView->horizontalHeader()->setSectionResizeMode(LogModel::TimeColumn, QHeaderView::ResizeToContents);
+    m_logView->horizontalHeader()->setSectionResizeMode(LogModel::LevelColumn, QHeaderView::ResizeToContents);
+    m_logView->horizontalHeader()->setSectionResizeMode(LogModel::ModuleColumn, QHeaderView::Interactive);
+    m_logView->horizontalHeader()->setStretchLastSection(true);
+    logLayout->addLayout(logFilterLayout);
+    logLayout->addWidget(m_logView, 1);
+    logContainer->setLayout(logLayout);
+    m_logDock->setWidget(logContainer);
     addDockWidget(Qt::BottomDockWidgetArea, m_logDock);
+
+    connect(m_logLevelFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int)
+            { m_logFilter->setMinimumSeverity(m_logLevelFilter->currentData().toInt()); });
+    connect(m_logModuleFilter, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int)
+            { m_logFilter->setModule(m_logModuleFilter->currentData().toString()); });
+    connect(m_logModel, &LogModel::moduleAdded, this, [this](const QString &module)
+            { m_logModuleFilter->addItem(module, module); });
+    connect(clearLogButton, &QPushButton::clicked, m_logModel, &LogModel::clear);
+
+    // 日志不逐条发信号：按固定刷新率从 ErrorHandler 批量取走，一次插入一段行
+    ErrorHandler::instance().setUiBufferCapacity(kLogScrollback);
+    m_logTimer = new QTimer(this);
+    m_logTimer->setInterval(kLogRefreshMs);
+    connect(m_logTimer, &QTimer::timeout, this, &MainWindow::drainLogEntries);
+    m_logTimer->start();
     m_logDock->hide();
     if (m_actToggleLog)
         m_actToggleLog->setChecked(false);
@@ -262,6 +424,75 @@ void MainWindow::createDockWidgets()
     m_segStatsDock->setWidget(statsContainer);
     addDockWidget(Qt::RightDockWidgetArea, m_segStatsDock);
     m_segStatsDock->hide();
+
+    // Overlay layers dock：按类别控制输出视图叠加层
+    m_layerDock = new QDockWidget(tr("Overlay Layers"), this);
+    m_layerDock->setObjectName("LayerDock");
+    m_layerDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    auto *layerContainer = new QWidget(m_layerDock);
+    auto *layerLayout = new QVBoxLayout(layerContainer);
+    layerLayout->setContentsMargins(12, 12, 12, 12);
+    layerLayout->setSpacing(8);
+    m_showMasks = new QCheckBox(tr("Show masks"), layerContainer);
+    m_showMasks->setChecked(true);
+    m_layerTable = new QTableWidget(0, 2, layerContainer);
+    m_layerTable->setHorizontalHeaderLabels({tr("Class"), tr("Opacity")});
+    m_layerTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_layerTable->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    m_layerTable->verticalHeader()->setVisible(false);
+    m_layerTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_layerTable->setSelectionMode(QAbstractItemView::NoSelection);
+    layerLayout->addWidget(m_showMasks);
+    layerLayout->addWidget(m_layerTable, 1);
+    layerContainer->setLayout(layerLayout);
+    m_layerDock->setWidget(layerContainer);
+    addDockWidget(Qt::RightDockWidgetArea, m_layerDock);
+    tabifyDockWidget(m_batchDock, m_layerDock);
+    m_metadataDock->raise();
+
+    connect(m_showMasks, &QCheckBox::toggled, this, [this](bool checked)
+            { m_outputView->setMasksVisible(checked); });
+    connect(m_layerTable, &QTableWidget::itemChanged, this, [this](QTableWidgetItem *item)
+            {
+        if (item->column() != 0)
+            return;
+        m_outputView->setClassVisible(item->data(Qt::UserRole).toInt(), item->checkState() == Qt::Checked); });
+}
+
+void MainWindow::rebuildLayerControls(TaskSelectionDialog::TaskType taskType)
+{
+    if (!m_layerTable || !m_outputView)
+        return;
+
+    const bool segmentation = (taskType == TaskSelectionDialog::MRI_Segmentation);
+    const int count = segmentation ? InferenceEngine::segmentationClassCount() : 4;
+
+    QSignalBlocker blocker(m_layerTable);
+    m_layerTable->setRowCount(count);
+    for (int cls = 0; cls < count; ++cls)
+    {
+        const QString name = segmentation ? InferenceEngine::segmentationClassName(cls) : InferenceEngine::className(cls);
+        const QColor color = segmentation ? InferenceEngine::segmentationClassColor(cls) : InferenceEngine::classColor(cls);
+        auto *item = new QTableWidgetItem(name);
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+        item->setData(Qt::UserRole, cls);
+        item->setData(Qt::DecorationRole, color);
+        m_layerTable->setItem(cls, 0, item);
+
+        auto *slider = new QSlider(Qt::Horizontal, m_layerTable);
+        slider->setRange(0, 100);
+        slider->setValue(100);
+        connect(slider, &QSlider::valueChanged, this, [this, cls](int value)
+                { m_outputView->setClassOpacity(cls, value / 100.0); });
+        m_layerTable->setCellWidget(cls, 1, slider);
+
+        m_outputView->setClassVisible(cls, true);
+        m_outputView->setClassOpacity(cls, 1.0);
+    }
+    if (m_showMasks)
+        m_showMasks->setVisible(segmentation);
+    m_outputView->setMasksVisible(!segmentation || !m_showMasks || m_showMasks->isChecked());
 }
 
 void MainWindow::createStatusBar()
@@ -338,31 +569,66 @@ void MainWindow::openFolder()
     QString dir = QFileDialog::getExistingDirectory(this, "Open Folder");
     if (dir.isEmpty())
         return;
-    m_batch.clear();
-    m_list->clear();
-    QDirIterator it(dir, QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext())
+    m_batchModel->clear();
+    statusBar()->showMessage(tr("Scanning %1 ...").arg(dir));
+    m_folderScanner->start(dir, [](const QString &path)
+                           { return isImageFile(path) || isDicomFile(path); });
+}
+
+void MainWindow::handleFolderChunk(const QStringList &paths)
+{
+    const bool firstChunk = (m_batchModel->totalCount() == 0);
+    m_batchModel->appendPaths(paths);
+    statusBar()->showMessage(tr("Scanning... %1 files").arg(m_batchModel->totalCount()));
+    // 第一块到达即显示第一个文件，无需等待整个目录扫描完成
+    if (firstChunk && m_batchModel->rowCount() > 0)
+        m_list->setCurrentIndex(m_batchModel->index(0));
+}
+
+void MainWindow::handleFolderScanFinished(int total)
+{
+    m_batchModel->sortPaths();
+    selectBatchPath(m_currentPath);
+    statusBar()->showMessage(tr("Folder loaded: %1 files").arg(total), 3000);
+    log(QString("Folder loaded: %1 files").arg(total));
+}
+
+void MainWindow::selectBatchPath(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+    const int row = m_batchModel->rowOfPath(path);
+    if (row < 0)
+        return;
+    // 重新选中当前文件只恢复高亮，onListActivated 会识别出路径未变
+    const QModelIndex index = m_batchModel->index(row);
+    m_list->setCurrentIndex(index);
+    m_list->scrollTo(index);
+}
+
+bool MainWindow::ensureBatchListReady(const QString &title)
+{
+    if (m_folderScanner && m_folderScanner->isRunning())
     {
-        QString path = it.next();
-        if (isImageFile(path) || isDicomFile(path))
-            m_batch << path;
+        QMessageBox::information(this, title, tr("Folder scan is still in progress."));
+        return false;
     }
-    m_batch.sort();
-    for (const auto &p : m_batch)
-        m_list->addItem(p);
-    log(QString("Folder loaded: %1 files").arg(m_batch.size()));
-    if (!m_batch.isEmpty())
+    if (!m_batchModel || m_batchModel->totalCount() == 0)
     {
-        m_list->setCurrentRow(0);
-        loadPath(m_batch.first());
+        QMessageBox::information(this, title, "Batch list is empty.");
+        return false;
     }
+    return true;
 }
+
 void MainWindow::onListActivated()
 {
-    auto items = m_list->selectedItems();
-    if (items.isEmpty())
+    const QModelIndexList rows = m_list->selectionModel()->selectedRows();
+    if (rows.isEmpty())
+        return;
+    const QString sel = m_batchModel->pathAt(rows.first().row());
+    if (sel.isEmpty() || (sel == m_currentPath && !m_input.isNull()))
         return;
-    const QString sel = items.first()->text();
 
     loadPath(sel); // 会更新输入视图、元数据、m_currentPath
 
@@ -372,21 +638,22 @@ void MainWindow::onListActivated()
         m_lastDets = m_cacheDets.value(sel);
         m_segmentationMask = m_cacheSegMasks.value(sel);
         const bool focus = (m_currentTask != TaskSelectionDialog::MRI_Segmentation);
-        setOutputImage(m_output, focus);
+        showOutput(focus);
         annotateCachedSegmentationIfNeeded(sel);
     }
     else if (m_currentTask == TaskSelectionDialog::FAI_XRay && m_modelReady)
     {
-        // 自动对当前文件推理一次
+        // 自动对当前文件推理一次（工作线程中先查磁盘结果缓存）
         runInference();
     }
     else
     {
-        // 未加载模型且没有缓存：清空输出
+        // 没有内存缓存：先清空输出，磁盘结果缓存命中（之前会话或其它路径下的相同图像）时再显示
         m_output = QImage();
         m_lastDets.clear();
         m_segmentationMask = QImage();
         m_outputView->clearImage();
+        restorePersistedResult();
     }
 }
 void MainWindow::runInference()
@@ -406,9 +673,16 @@ void MainWindow::runInference()
     if (!ensureModelReadyForCurrentTask(tr("Run Inference")))
         return;
 
+    if (m_viewAxis != DicomUtils::Volume::Axis::Axial)
+    {
+        QMessageBox::information(this, tr("Run Inference"),
+                                 tr("Segmentation runs on axial slices. Switch back to the axial view first."));
+        return;
+    }
+
     const InferenceEngine::Task task = inferenceTaskForMode(m_currentTask);
     m_isInferenceRunning = true;
-    m_pendingInferencePath = m_currentPath;
+    m_pendingInferencePath = currentCacheKey();
     m_pendingTask = task;
 
     const QString busyText = (task == InferenceEngine::Task::HipMRI_Seg)
@@ -420,9 +694,8 @@ void MainWindow::runInference()
 
     auto future = QtConcurrent::run([this, inputCopy, task]()
                                     {
-        if (task == InferenceEngine::Task::HipMRI_Seg)
-            return m_mriEngine.run(inputCopy, task);
-        return m_engine.run(inputCopy, task); });
+        const InferenceEngine &engine = (task == InferenceEngine::Task::HipMRI_Seg) ? m_mriEngine : m_engine;
+        return ResultCache::instance().run(engine, inputCopy, task, true); });
     m_singleWatcher.setFuture(future);
 }
 
@@ -437,16 +710,25 @@ void MainWindow::runBatchInference()
     if (!ensureModelReadyForCurrentTask(tr("Batch Infer")))
         return;
 
-    if (!m_list || m_list->count() == 0)
-    {
-        QMessageBox::information(this, "Batch Infer", "Batch list is empty.");
+    // MRI 模式下体数据已就绪时，对整个序列分割，切层直接取自体数据而不再解码
+    const bool seriesBatch = (m_currentTask == TaskSelectionDialog::MRI_Segmentation) && volumeCoversSeries();
+    if (!seriesBatch && !ensureBatchListReady(tr("Batch Infer")))
         return;
-    }
 
     QStringList paths;
-    paths.reserve(m_list->count());
-    for (int i = 0; i < m_list->count(); ++i)
-        paths.append(m_list->item(i)->text());
+    std::shared_ptr<const DicomUtils::Volume> volume;
+    if (seriesBatch)
+    {
+        volume = m_volume;
+        paths.reserve(m_dicomSeries.size());
+        for (const DicomSliceEntry &entry : m_dicomSeries)
+            paths.append(frameCacheKey(entry.path, entry.frameIndex));
+        log(tr("Segmenting %1 slices of the current series from the volume").arg(paths.size()));
+    }
+    else
+    {
+        paths = m_batchModel->allPaths();
+    }
 
     const int total = paths.size();
     m_isBatchRunning = true;
@@ -455,80 +737,169 @@ void MainWindow::runBatchInference()
     const QString busyText = (task == InferenceEngine::Task::HipMRI_Seg)
                                  ? tr("Running MRI batch segmentation...")
                                  : tr("Running batch detection...");
-    setBusyState(true, busyText, total);
+    m_batchTotal = total;
+    m_batchOk = 0;
+    m_batchFail = 0;
+    m_batchCached = 0;
+    // 级联初筛统计按批次计
+    m_engine.resetCascadeStats();
+    // 结果逐项流式交付 GUI；队列满时推理线程等待，内存占用与批量大小无关
+    auto queue = std::make_shared<BoundedQueue<BatchItem>>(kBatchQueueCapacity);
+    m_batchQueue = queue;
+    setBusyState(true, busyText, total, true);
 
     QPointer<MainWindow> guard(this);
+    // 保留 8 位底图供导出补绘结果图；整序列分割的切层不参与批量导出
+    const bool keepBase = !volume && AppConfig::instance().current()->exportBaseCacheMB > 0;
 
-    auto future = QtConcurrent::run([this, guard, task, paths = std::move(paths)]() -> std::vector<BatchItem>
+    auto future = QtConcurrent::run([this, guard, task, volume, queue, keepBase, paths = std::move(paths)]()
                                     {
-        std::vector<BatchItem> results;
-        results.reserve(static_cast<size_t>(paths.size()));
-        int index = 0;
-        const int totalCount = static_cast<int>(paths.size());
-        for (const QString &path : paths)
+        // DICOM 输入只解码到 16 位存储值（随附 Rescale），直接生成张量；结果图在导出时再补绘
+        struct DecodedInput
         {
-            BatchItem item;
-            item.path = path;
             QImage image;
+            DicomUtils::FrameSamples samples;
+            QSizeF spacing;
             QString error;
-            bool ok = false;
+        };
 
-            if (isImageFile(path))
-            {
-                ok = image.load(path);
-                if (!ok)
-                    error = QStringLiteral("Failed to load image: %1").arg(path);
-            }
-            else if (isDicomFile(path))
-            {
-#ifdef HAVE_GDCM
-                ok = DicomUtils::loadDicomToQImage(path, image, nullptr);
-                if (!ok)
-                    error = QStringLiteral("Failed to load DICOM: %1").arg(path);
-#else
-                error = QStringLiteral("Built without GDCM support");
-#endif
-            }
-            else
-            {
-                error = QStringLiteral("Unsupported file: %1").arg(path);
-            }
+        // 多帧 DICOM 按帧展开为独立条目；体数据路径中的键已是逐帧键
+        std::vector<BatchFrame> frames;
+        if (volume)
+        {
+            frames.reserve(static_cast<size_t>(paths.size()));
+            for (const QString &key : paths)
+                frames.push_back({key, 0, key, false});
+        }
+        else
+        {
+            frames = expandBatchFrames(paths);
+        }
+        const int totalCount = static_cast<int>(frames.size());
+        if (totalCount != paths.size() && guard)
+        {
+            QMetaObject::invokeMethod(
+                guard,
+                [guard, files = static_cast<int>(paths.size()), totalCount]()
+                {
+                    if (!guard)
+                        return;
+                    guard->m_batchTotal = totalCount;
+                    guard->log(tr("Batch: %1 file(s) expanded to %2 frame(s)").arg(files).arg(totalCount));
+                },
+                Qt::QueuedConnection);
+        }
 
-            if (ok)
+        // 解码在 SeriesDecoder 线程池中提前进行，本线程按顺序取结果并推理
+        DicomUtils::SeriesDecoder::instance().run<DecodedInput>(
+            totalCount,
+            [&frames, &volume](int index)
             {
-                item.success = true;
-                item.result = (task == InferenceEngine::Task::HipMRI_Seg)
-                                   ? m_mriEngine.run(image, task)
-                                   : m_engine.run(image, task);
-            }
-            else
+                const BatchFrame &frame = frames[static_cast<size_t>(index)];
+                DecodedInput in;
+                if (volume)
+                {
+                    // 体数据中的切层已是连续存储值，推理时直接引用
+                    if (!volume->slice(index))
+                        in.error = QStringLiteral("Slice %1 missing from volume").arg(index + 1);
+                }
+                else if (isDicomFile(frame.path))
+                {
+                    DicomUtils::SliceInfo info;
+                    if (!DicomUtils::decodeFrameSamples(frame.path, frame.frameIndex, in.samples, &info))
+                        in.error = QStringLiteral("Failed to load DICOM: %1").arg(frame.key);
+                    else
+                        in.spacing = QSizeF(info.spacingX, info.spacingY);
+                }
+                else
+                {
+                    loadInputImage(frame.path, in.image, &in.error);
+                }
+                return in;
+            },
+            [&](int index, DecodedInput &&in)
             {
-                item.success = false;
-                item.error = error;
-            }
+                if (queue->isClosed())
+                    return false;
+                BatchItem item;
+                item.path = frames[static_cast<size_t>(index)].key;
+                const InferenceEngine &engine = (task == InferenceEngine::Task::HipMRI_Seg) ? m_mriEngine : m_engine;
+                InferenceEngine::PixelView view;
+                if (volume && volume->slice(index))
+                {
+                    view.data = volume->slice(index);
+                    view.width = volume->width();
+                    view.height = volume->height();
+                    view.isSigned = volume->isSigned();
+                    view.slope = volume->rescaleSlope();
+                    view.intercept = volume->rescaleIntercept();
+                    view.invert = volume->isInverted();
+                    volume->sliceWindow(index, view.windowCenter, view.windowWidth);
+                    item.pixelSpacing = QSizeF(volume->spacingX(), volume->spacingY());
+                }
+                else if (!in.samples.values.empty())
+                {
+                    item.pixelSpacing = in.spacing;
+                    view.data = in.samples.values.data();
+                    view.width = in.samples.width;
+                    view.height = in.samples.height;
+                    view.isSigned = in.samples.isSigned;
+                    view.slope = in.samples.slope;
+                    view.intercept = in.samples.intercept;
+                    view.windowCenter = in.samples.windowCenter;
+                    view.windowWidth = in.samples.windowWidth;
+                    view.invert = in.samples.invert;
+                }
+                view.stride = static_cast<qsizetype>(view.width) * static_cast<qsizetype>(sizeof(uint16_t));
 
-            results.push_back(item);
-            ++index;
-            if (guard)
-            {
-                QMetaObject::invokeMethod(
-                    guard,
-                    [guard, index, totalCount]()
-                    {
-                        if (guard)
-                            guard->updateProgressValue(index, totalCount);
-                    },
-                    Qt::QueuedConnection);
-            }
-        }
-        return results; });
+                // 先查跨会话结果缓存，命中时不推理
+                if (view.data)
+                {
+                    item.success = true;
+                    // 结果缓存按取窗后的 8 位灰度哈希，同一幅图直接留作底图
+                    item.result = ResultCache::instance().run(engine, view, task, &item.cached,
+                                                              keepBase ? &item.baseImage : nullptr);
+                    item.imageSize = QSize(view.width, view.height);
+                    if (keepBase && item.baseImage.isNull())
+                        item.baseImage = InferenceEngine::windowedImage(view);
+                }
+                else if (!in.image.isNull())
+                {
+                    item.success = true;
+                    item.result = ResultCache::instance().run(engine, in.image, task, false, &item.cached);
+                    item.imageSize = in.image.size();
+                    if (keepBase)
+                        item.baseImage = std::move(in.image);
+                }
+                else
+                {
+                    item.success = false;
+                    item.error = in.error;
+                }
+
+                bool wasEmpty = false;
+                if (!queue->push(std::move(item), &wasEmpty))
+                    return false; // 已取消
+                if (wasEmpty && guard)
+                {
+                    QMetaObject::invokeMethod(
+                        guard,
+                        [guard]()
+                        {
+                            if (guard)
+                                guard->drainBatchResults();
+                        },
+                        Qt::QueuedConnection);
+                }
+                return true;
+            }); });
 
     m_batchWatcher.setFuture(future);
 }
 
 void MainWindow::refreshActionStates()
 {
-    const bool busy = m_isInferenceRunning || m_isBatchRunning;
+    const bool busy = m_isInferenceRunning || m_isBatchRunning || m_isExportRunning || m_isReportRunning;
     const bool hasModel = isModelReadyForTask(m_currentTask);
 
     if (m_actRun)
@@ -537,8 +908,10 @@ void MainWindow::refreshActionStates()
         m_actBatch->setEnabled(hasModel && !busy);
     if (m_actExportAll)
         m_actExportAll->setEnabled(hasModel && !busy);
+    if (m_actPrecisionReport)
+        m_actPrecisionReport->setEnabled(hasModel && !busy);
     if (m_actExport)
-        m_actExport->setEnabled(!m_output.isNull() && !busy);
+        m_actExport->setEnabled((!m_lastDets.empty() || !m_segmentationMask.isNull()) && !busy);
 
     updateStatusSummary();
 }
@@ -557,6 +930,11 @@ void MainWindow::updateTaskUi(TaskSelectionDialog::TaskType taskType)
         m_actLoadFAI->setVisible(!isSegmentation);
     if (m_actLoadMRI)
         m_actLoadMRI->setVisible(isSegmentation);
+    for (QAction *act : {m_actAxial, m_actCoronal, m_actSagittal})
+    {
+        if (act)
+            act->setVisible(isSegmentation);
+    }
     if (m_batchDock)
     {
         const QString title = isSegmentation ? tr("Batch Files (Segmentation)") : tr("Batch Files");
@@ -567,6 +945,7 @@ void MainWindow::updateTaskUi(TaskSelectionDialog::TaskType taskType)
     if (m_segStatsDock)
         m_segStatsDock->setVisible(isSegmentation);
     clearSegmentationStats();
+    rebuildLayerControls(taskType);
     updateStatusSummary();
 }
 
@@ -590,19 +969,23 @@ void MainWindow::updateStatusSummary()
     }
 }
 
-void MainWindow::setBusyState(bool busy, const QString &message, int maximum)
+void MainWindow::setBusyState(bool busy, const QString &message, int maximum, bool cancellable)
 {
     if (busy)
     {
         if (!m_progressDialog)
         {
             m_progressDialog = new QProgressDialog(message, QString(), 0, 0, this);
-            m_progressDialog->setCancelButton(nullptr);
             m_progressDialog->setWindowModality(Qt::WindowModal);
             m_progressDialog->setMinimumDuration(0);
             m_progressDialog->setAutoClose(false);
             m_progressDialog->setAutoReset(false);
+            connect(m_progressDialog, &QProgressDialog::canceled, this, &MainWindow::cancelBackgroundWork);
         }
+        if (cancellable)
+            m_progressDialog->setCancelButtonText(tr("Cancel"));
+        else
+            m_progressDialog->setCancelButton(nullptr);
         m_progressDialog->setLabelText(message);
         if (maximum > 0)
         {
@@ -714,38 +1097,85 @@ void MainWindow::handleSingleInferenceFinished()
     }
 
     InferenceEngine::Result result = m_singleWatcher.result();
-    const bool wasSegmentation = (m_pendingTask == InferenceEngine::Task::HipMRI_Seg);
+    applySingleResult(std::move(result), m_pendingInferencePath, m_pendingTask);
+    m_pendingInferencePath.clear();
+    LOG_INFO(QStringLiteral("Inference summary: %1").arg(m_lastSummary), "Inference");
+
+    refreshActionStates();
+}
+
+void MainWindow::applySingleResult(InferenceEngine::Result &&result, const QString &cacheKey, InferenceEngine::Task task)
+{
+    const bool wasSegmentation = (task == InferenceEngine::Task::HipMRI_Seg);
     if (wasSegmentation)
         postProcessSegmentationResult(result);
     else
         clearSegmentationStats();
 
-    if (!m_pendingInferencePath.isEmpty())
+    if (!cacheKey.isEmpty())
     {
-        m_cacheImg[m_pendingInferencePath] = result.outputImage;
-        m_cacheDets[m_pendingInferencePath] = result.dets;
+        m_cacheImg[cacheKey] = result.outputImage;
+        m_cacheDets[cacheKey] = result.dets;
+        m_cacheSizes[cacheKey] = m_input.size();
+        if (!m_dicomSeries.isEmpty())
+            m_cacheSpacings[cacheKey] = QSizeF(m_spacingX, m_spacingY);
         if (!result.segmentationMask.isNull())
-            m_cacheSegMasks[m_pendingInferencePath] = result.segmentationMask;
+            m_cacheSegMasks[cacheKey] = result.segmentationMask;
         else
-            m_cacheSegMasks.remove(m_pendingInferencePath);
+            m_cacheSegMasks.remove(cacheKey);
     }
-    m_pendingInferencePath.clear();
 
     m_output = result.outputImage;
     m_lastDets = result.dets;
     m_segmentationMask = result.segmentationMask;
 
-    if (!result.outputImage.isNull())
-    {
-        const bool focusOutput = (m_pendingTask != InferenceEngine::Task::HipMRI_Seg);
-        setOutputImage(result.outputImage, focusOutput);
-    }
+    if (!m_input.isNull())
+        showOutput(!wasSegmentation);
     else
         m_outputView->clearImage();
 
+    m_lastSummary = result.summary;
     statusBar()->showMessage(result.summary, 5000);
-    LOG_INFO(QStringLiteral("Inference summary: %1").arg(result.summary), "Inference");
+}
+
+void MainWindow::restorePersistedResult()
+{
+    if (m_input.isNull() || !isModelReadyForTask(m_currentTask) || m_viewAxis != DicomUtils::Volume::Axis::Axial)
+        return;
+    // 键的引擎部分在此取得（模型已加载）；哈希整幅图像与查表在工作线程中进行，不再访问引擎
+    const InferenceEngine::Task task = inferenceTaskForMode(m_currentTask);
+    const InferenceEngine &engine = (task == InferenceEngine::Task::HipMRI_Seg) ? m_mriEngine : m_engine;
+    const QByteArray context = engine.resultKeyContext(task);
+    if (context.isEmpty())
+        return;
+    m_restoreKey = currentCacheKey();
+    m_restoreContext = context;
+    m_restoreTask = task;
+    const QImage input = m_input;
+    // setFuture 替换时旧查询的 finished 不再送达
+    m_restoreWatcher.setFuture(QtConcurrent::run([context, input]()
+                                                 {
+        InferenceEngine::Result result;
+        if (!ResultCache::instance().lookup(context, input, result))
+            result.valid = false;
+        return result; }));
+}
 
+void MainWindow::handleRestoreFinished()
+{
+    InferenceEngine::Result result = m_restoreWatcher.result();
+    const InferenceEngine::Task task = m_restoreTask;
+    const QString cacheKey = m_restoreKey;
+    // 命中且仍停留在同一图像、同一模式与同一模型上时才显示
+    if (!result.valid || m_isInferenceRunning || currentCacheKey() != cacheKey || m_cacheDets.contains(cacheKey) ||
+        inferenceTaskForMode(m_currentTask) != task || !isModelReadyForTask(m_currentTask))
+        return;
+    const InferenceEngine &engine = (task == InferenceEngine::Task::HipMRI_Seg) ? m_mriEngine : m_engine;
+    if (engine.resultKeyContext(task) != m_restoreContext)
+        return;
+    // 显示走叠加层，结果图留空，导出时由 renderOutputForExport 补绘
+    applySingleResult(std::move(result), cacheKey, task);
+    log(tr("Result restored from cache: %1").arg(m_lastSummary));
     refreshActionStates();
 }
 
@@ -760,50 +1190,132 @@ void MainWindow::handleBatchInferenceFinished()
         return;
     }
 
-    std::vector<BatchItem> results = m_batchWatcher.result();
-    int ok = 0;
-    int fail = 0;
-
+    drainBatchResults();
+    const bool cancelled = m_batchQueue && m_batchQueue->isClosed();
+    m_batchQueue.reset();
     const bool segTask = (m_lastBatchTask == InferenceEngine::Task::HipMRI_Seg);
-    for (auto &item : results)
+    if (!segTask)
+        clearSegmentationStats();
+    m_lastBatchTask = InferenceEngine::Task::Auto;
+    refreshActionStates();
+
+    if (cancelled)
     {
-        if (!item.success)
-        {
-            ++fail;
-            LOG_WARNING(QStringLiteral("Batch inference failed: %1 (%2)").arg(item.path, item.error), "BatchInference", 1003);
-            continue;
-        }
+        const int skipped = std::max(0, m_batchTotal - m_batchOk - m_batchFail);
+        LOG_INFO(QStringLiteral("Batch inference cancelled, %1 item(s) skipped").arg(skipped), "BatchInference");
+        QMessageBox::information(this, "Batch Infer",
+                                 QString("Cancelled. Success: %1, Failed: %2, Skipped: %3").arg(m_batchOk).arg(m_batchFail).arg(skipped));
+        return;
+    }
+    LOG_INFO(QStringLiteral("Batch inference done, %1 of %2 result(s) from the result cache").arg(m_batchCached).arg(m_batchOk), "BatchInference");
+    QString message = QString("Done. Success: %1 (%2 from cache), Failed: %3").arg(m_batchOk).arg(m_batchCached).arg(m_batchFail);
+    const InferenceEngine::CascadeStats cascade = m_engine.cascadeStats();
+    if (!segTask && cascade.screened > 0)
+    {
+        LOG_INFO(QStringLiteral("Triage cascade: %1").arg(cascade.toText()), "BatchInference");
+        log(tr("Triage cascade: %1").arg(cascade.toText()));
+        message += QStringLiteral("\nTriage cascade: %1 of %2 skipped full detection (%3%), saved ~%4 s")
+                       .arg(cascade.earlyExits)
+                       .arg(cascade.screened)
+                       .arg(cascade.hitRate() * 100.0, 0, 'f', 1)
+                       .arg(cascade.savedMs() / 1000.0, 0, 'f', 1);
+    }
+    QMessageBox::information(this, "Batch Infer", message);
+}
+
+void MainWindow::drainBatchResults()
+{
+    if (!m_batchQueue)
+        return;
+    std::vector<BatchItem> items;
+    if (m_batchQueue->drain(items) == 0)
+        return;
+    for (BatchItem &item : items)
+        applyBatchItem(std::move(item));
+    if (m_isBatchRunning)
+        updateProgressValue(m_batchOk + m_batchFail, m_batchTotal);
+}
 
-        ++ok;
-        if (segTask && item.path == m_currentPath)
-            postProcessSegmentationResult(item.result);
+void MainWindow::applyBatchItem(BatchItem &&item)
+{
+    if (!item.success)
+    {
+        ++m_batchFail;
+        LOG_WARNING(QStringLiteral("Batch inference failed: %1 (%2)").arg(item.path, item.error), "BatchInference", 1003);
+        return;
+    }
 
-        m_cacheImg[item.path] = item.result.outputImage;
-        m_cacheDets[item.path] = item.result.dets;
-        if (!item.result.segmentationMask.isNull())
-            m_cacheSegMasks[item.path] = item.result.segmentationMask;
-        else
-            m_cacheSegMasks.remove(item.path);
+    ++m_batchOk;
+    if (item.cached)
+        ++m_batchCached;
+    const bool segTask = (m_lastBatchTask == InferenceEngine::Task::HipMRI_Seg);
+    const bool isCurrent = (item.path == currentCacheKey());
+    if (segTask && isCurrent)
+        postProcessSegmentationResult(item.result);
 
-        if (item.path == m_currentPath)
-        {
-            m_output = item.result.outputImage;
-            m_lastDets = item.result.dets;
-            m_segmentationMask = item.result.segmentationMask;
-            const bool focus = !segTask;
-            setOutputImage(item.result.outputImage, focus);
-            statusBar()->showMessage(item.result.summary, 5000);
-        }
+    if (isCurrent)
+    {
+        m_output = item.result.outputImage;
+        m_lastDets = item.result.dets;
+        m_segmentationMask = item.result.segmentationMask;
+        showOutput(!segTask);
+        statusBar()->showMessage(item.result.summary, 5000);
     }
 
-    refreshActionStates();
+    m_cacheImg[item.path] = std::move(item.result.outputImage);
+    m_cacheDets[item.path] = std::move(item.result.dets);
+    m_cacheSizes[item.path] = item.imageSize;
+    if (item.pixelSpacing.isValid())
+        m_cacheSpacings[item.path] = item.pixelSpacing;
+    if (!item.result.segmentationMask.isNull())
+        m_cacheSegMasks[item.path] = std::move(item.result.segmentationMask);
+    else
+        m_cacheSegMasks.remove(item.path);
+    storeBaseImage(item.path, item.baseImage);
+}
 
-    QMessageBox::information(this, "Batch Infer",
-                             QString("Done. Success: %1, Failed: %2").arg(ok).arg(fail));
+void MainWindow::storeBaseImage(const QString &key, const QImage &image)
+{
+    const qint64 budget = static_cast<qint64>(AppConfig::instance().current()->exportBaseCacheMB) * 1024 * 1024;
+    if (image.isNull() || image.sizeInBytes() > budget)
+        return;
+    auto it = m_cacheBase.find(key);
+    if (it != m_cacheBase.end())
+        m_cacheBaseBytes -= it.value().sizeInBytes();
+    else
+        m_cacheBaseOrder.push_back(key);
+    m_cacheBase.insert(key, image);
+    m_cacheBaseBytes += image.sizeInBytes();
+    // 超出预算时淘汰最早写入的底图，这些条目导出时退回解码源文件
+    while (m_cacheBaseBytes > budget && !m_cacheBaseOrder.empty())
+    {
+        auto oldest = m_cacheBase.find(m_cacheBaseOrder.front());
+        m_cacheBaseOrder.pop_front();
+        if (oldest == m_cacheBase.end())
+            continue;
+        m_cacheBaseBytes -= oldest.value().sizeInBytes();
+        m_cacheBase.erase(oldest);
+    }
+}
 
-    if (!segTask)
-        clearSegmentationStats();
-    m_lastBatchTask = InferenceEngine::Task::Auto;
+void MainWindow::cancelBackgroundWork()
+{
+    // 协作式取消：工作线程在下一项之前退出，已完成的结果照常入缓存/写盘
+    if (m_isBatchRunning && m_batchQueue)
+    {
+        m_batchQueue->close();
+        statusBar()->showMessage(tr("Cancelling batch..."));
+    }
+    if (m_isExportRunning && m_exportCancel)
+    {
+        m_exportCancel->store(true);
+        statusBar()->showMessage(tr("Cancelling export..."));
+    }
+    if (m_isReportRunning && m_reportCancel)
+    {
+        m_reportCancel->store(true);
+        statusBar()->showMessage(tr("Cancelling precision report..."));
+    }
 }
 
 void MainWindow::loadFAIModel()
@@ -833,8 +1345,9 @@ void MainWindow::loadFAIModel()
         bool keepPrompting = true;
         while (keepPrompting)
         {
-            m_faiOnnxPath = modelPath;
-            log(tr("正在加载FAI模型: %1").arg(modelPath));
+            // 配置中保存原模型路径，精度变体（Models/Precision）只在加载时解析
+            m_faiOnnxPath = InferenceEngine::resolveModelVariant(modelPath);
+            log(tr("正在加载FAI模型: %1").arg(m_faiOnnxPath));
             m_modelReady = m_engine.loadModel(m_faiOnnxPath);
             if (m_modelReady)
             {
@@ -864,8 +1377,15 @@ void MainWindow::loadFAIModel()
             }
         }
 
+        // 初筛模型随检测模型加载；未配置时级联用检测模型低分辨率初筛（TriageCascade 可热切换）
+        const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+        if (config->triageCascade || !config->faiTriageModelPath.isEmpty())
+            m_engine.loadTriageModel(config->faiTriageModelPath);
+
         AppConfig::instance().setFaiModelPath(modelPath);
         AppConfig::instance().saveConfig();
+        // 模型元数据可能带来新的类别名与颜色
+        rebuildLayerControls(m_currentTask);
         refreshActionStates();
         updateStatusSummary();
 
@@ -896,7 +1416,7 @@ void MainWindow::loadMRIModel()
         bool keepPrompting = true;
         while (keepPrompting)
         {
-            m_mriOnnxPath = modelPath;
+            m_mriOnnxPath = InferenceEngine::resolveModelVariant(modelPath);
             m_mriModelReady = m_mriEngine.loadModel(m_mriOnnxPath);
             if (m_mriModelReady)
             {
@@ -924,6 +1444,7 @@ void MainWindow::loadMRIModel()
 
         AppConfig::instance().setMriModelPath(modelPath);
         AppConfig::instance().saveConfig();
+        rebuildLayerControls(m_currentTask);
         refreshActionStates();
         updateStatusSummary();
 
@@ -939,7 +1460,7 @@ void MainWindow::loadMRIModel()
 
 void MainWindow::switchTask()
 {
-    if (m_isInferenceRunning || m_isBatchRunning)
+    if (m_isInferenceRunning || m_isBatchRunning || m_isExportRunning)
     {
         QMessageBox::information(this,
                                  tr("Switch Task"),
@@ -970,33 +1491,48 @@ void MainWindow::clearAll()
     m_outputView->clearImage();
     m_meta->clearAll();
     m_currentPath.clear();
-    m_batch.clear();
-    if (m_list)
-        m_list->clear();
+    if (m_folderScanner)
+        m_folderScanner->cancel();
+    if (m_batchModel)
+        m_batchModel->clear();
     if (m_batchFilter)
         m_batchFilter->clear();
     m_segmentationMask = QImage();
     clearDicomSeries();
     clearSegmentationStats();
     statusBar()->showMessage(tr("Workspace cleared"));
-    appendLog(tr("Workspace cleared"));
+    LOG_INFO(tr("Workspace cleared"), "MainWindow");
     refreshActionStates();
 }
 
-void MainWindow::appendLog(const QString &message)
+void MainWindow::drainLogEntries()
 {
-    if (!m_logView)
+    std::vector<LogRecord> records;
+    const quint64 dropped = ErrorHandler::instance().takeUiEntries(records);
+    if (dropped > 0)
+    {
+        LogRecord note;
+        note.timestampMs = QDateTime::currentMSecsSinceEpoch();
+        note.type = ErrorType::WARNING;
+        note.module = QStringLiteral("MainWindow");
+        note.message = tr("%1 log entries skipped in the log view").arg(dropped);
+        records.insert(records.begin(), std::move(note));
+    }
+    if (records.empty())
         return;
-    const QString line = QStringLiteral("[%1] %2")
-                             .arg(QDateTime::currentDateTime().toString("HH:mm:ss"),
-                                  message);
-    m_logView->appendPlainText(line);
+
+    // 只有视图原本停在底部时才跟随滚动，避免打断用户查看历史日志
+    QScrollBar *bar = m_logView->verticalScrollBar();
+    const bool follow = bar->value() >= bar->maximum() - 2;
+    m_logModel->appendBatch(std::move(records));
+    if (follow && m_logDock->isVisible())
+        m_logView->scrollToBottom();
 }
 
 void MainWindow::log(const QString &s)
 {
+    // 运行日志面板通过 ErrorHandler 的界面缓冲统一接收
     statusBar()->showMessage(s, 5000);
-    appendLog(s);
     LOG_INFO(s, "MainWindow");
 }
 
@@ -1008,11 +1544,15 @@ void MainWindow::setInputImage(const QImage &img)
     if (m_viewTabs && m_inputView)
         m_viewTabs->setCurrentWidget(m_inputView);
 }
-void MainWindow::setOutputImage(const QImage &img, bool focusOutput)
+void MainWindow::showOutput(bool focusOutput)
 {
     if (!m_outputView)
         return;
-    m_outputView->setImage(img, false);
+    // 底图与输入一致，检测框与掩码作为叠加图元，缓存结果切换时不做逐像素绘制
+    const bool segmentation = (m_currentTask == TaskSelectionDialog::MRI_Segmentation);
+    m_outputView->setImage(m_input, false);
+    m_outputView->setOverlay(overlayBoxes(m_lastDets, segmentation), m_segmentationMask,
+                             segmentation ? OverlayLayer::Style::Segmentation : OverlayLayer::Style::Detection);
     if (m_inputView)
         m_outputView->setTransform(m_inputView->transform());
     if (focusOutput && m_viewTabs)
@@ -1074,6 +1614,7 @@ void MainWindow::loadPath(const QString &path)
             m_currentPath = path;
             setInputImage(img);
             updateMetaTable(meta);
+            m_seriesMeta = meta;
             log(QString("Loaded DICOM: %1").arg(path));
             setupDicomSeries(path, sliceInfo);
             if (m_currentTask == TaskSelectionDialog::MRI_Segmentation && m_mriModelReady)
@@ -1100,6 +1641,7 @@ void MainWindow::exportCurrent()
     {
         const bool hasDetections = !m_lastDets.empty();
         const bool hasSegMask = !m_segmentationMask.isNull();
+        renderOutputForExport();
         if (m_output.isNull() || (!hasDetections && !hasSegMask))
         {
             QString errorMsg = "No inference result to export.";
@@ -1108,6 +1650,9 @@ void MainWindow::exportCurrent()
             return;
         }
         QString defStem = m_currentPath.isEmpty() ? "result" : QFileInfo(m_currentPath).completeBaseName();
+        if (m_currentSliceIndex >= 0 && m_currentSliceIndex < m_dicomSeries.size() &&
+            m_dicomSeries[m_currentSliceIndex].frameIndex > 0)
+            defStem += QStringLiteral("_f%1").arg(m_dicomSeries[m_currentSliceIndex].frameIndex + 1, 4, 10, QLatin1Char('0'));
         QString defDir = m_currentPath.isEmpty() ? QDir::homePath() : QFileInfo(m_currentPath).absolutePath();
         QString outImg = QFileDialog::getSaveFileName(this, "Save Result Image",
                                                       defDir + "/" + defStem + "_pred.png",
@@ -1162,121 +1707,471 @@ void MainWindow::exportCurrent()
 
 void MainWindow::exportBatch()
 {
-    try
+    if (m_isInferenceRunning || m_isBatchRunning || m_isExportRunning)
+    {
+        statusBar()->showMessage("Inference already running...");
+        return;
+    }
+    if (!m_batchModel || m_batchModel->totalCount() == 0)
     {
-        if (!m_list || m_list->count() == 0)
+        QString errorMsg = "Batch list is empty.";
+        LOG_WARNING(errorMsg, "BatchExport", 4005);
+        QMessageBox::information(this, "Batch Export", errorMsg);
+        return;
+    }
+    if (!ensureBatchListReady(tr("Batch Export")))
+        return;
+
+    if (!ensureModelReadyForCurrentTask(tr("Batch Export")))
+        return;
+
+    QString outDir = QFileDialog::getExistingDirectory(this, "Select Output Folder");
+    if (outDir.isEmpty())
+        return;
+
+    const InferenceEngine::Task task = inferenceTaskForMode(m_currentTask);
+    const QStringList paths = m_batchModel->allPaths();
+
+    // 在 GUI 线程取缓存快照（隐式共享，不复制数据），帧展开与查找在工作线程进行
+    const auto cacheImg = m_cacheImg;
+    const auto cacheDets = m_cacheDets;
+    const auto cacheSegMasks = m_cacheSegMasks;
+    const auto cacheSizes = m_cacheSizes;
+    const auto cacheSpacings = m_cacheSpacings;
+    const auto cacheBase = m_cacheBase;
+
+    auto encoder = std::make_shared<const ExportEncoder>(ExportEncoder::optionsFromConfig());
+
+    // 预测记录默认写入单个 JSON Lines 文件，每图一行
+    const bool perImageJson = (AppConfig::instance().exportJsonLayout() == QLatin1String("per-image"));
+    const bool writeCoco = AppConfig::instance().exportWriteCoco();
+    std::shared_ptr<PredictionWriter> predictions;
+    if (!perImageJson)
+    {
+        predictions = std::make_shared<PredictionWriter>();
+        QString error;
+        if (!predictions->open(outDir + "/predictions.jsonl", &error))
         {
-            QString errorMsg = "Batch list is empty.";
-            LOG_WARNING(errorMsg, "BatchExport", 4005);
-            QMessageBox::information(this, "Batch Export", errorMsg);
+            LOG_ERROR(error, "BatchExport", 4009);
+            QMessageBox::warning(this, "Batch Export", error);
             return;
         }
+    }
 
-        if (!ensureModelReadyForCurrentTask(tr("Batch Export")))
-            return;
-
-        QString outDir = QFileDialog::getExistingDirectory(this, "Select Output Folder");
-        if (outDir.isEmpty())
-            return;
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_exportCancel = cancelled;
+    m_isExportRunning = true;
+    setBusyState(true, tr("Exporting batch results..."), static_cast<int>(paths.size()), true);
 
-        int ok = 0, fail = 0;
-        const InferenceEngine::Task task = inferenceTaskForMode(m_currentTask);
-        for (int i = 0; i < m_list->count(); ++i)
+    QPointer<MainWindow> guard(this);
+    auto future = QtConcurrent::run([this, guard, task, outDir, encoder, predictions, writeCoco, cancelled, paths,
+                                     cacheImg, cacheDets, cacheSegMasks, cacheSizes, cacheSpacings, cacheBase]()
+                                    {
+        QElapsedTimer wallClock;
+        wallClock.start();
+        const std::vector<BatchFrame> frames = expandBatchFrames(paths);
+        std::vector<ExportJob> jobs(frames.size());
+        int cachedCount = 0;
+        for (size_t i = 0; i < frames.size(); ++i)
         {
-            QString path = m_list->item(i)->text();
-            QImage in;
-            if (isDicomFile(path))
-            {
-#ifdef HAVE_GDCM
-                QMap<QString, QString> dummy;
-                if (!DicomUtils::loadDicomToQImage(path, in, &dummy))
-                {
-                    ++fail;
-                    continue;
-                }
-#else
-                ++fail;
+            ExportJob &job = jobs[i];
+            job.path = frames[i].path;
+            job.key = frames[i].key;
+            job.frameIndex = frames[i].frameIndex;
+            job.multiFrame = frames[i].multiFrame;
+            auto itD = cacheDets.constFind(job.key);
+            if (itD == cacheDets.constEnd() || !cacheImg.contains(job.key))
                 continue;
-#endif
-            }
-            else if (isImageFile(path))
-            {
-                if (!in.load(path))
+            job.cached = true;
+            job.result.dets = itD.value();
+            job.result.outputImage = cacheImg.value(job.key);
+            job.result.segmentationMask = cacheSegMasks.value(job.key);
+            job.imageSize = cacheSizes.value(job.key);
+            job.pixelSpacing = cacheSpacings.value(job.key);
+            job.base = cacheBase.value(job.key);
+            ++cachedCount;
+        }
+        const int total = static_cast<int>(jobs.size());
+        if (guard)
+        {
+            QMetaObject::invokeMethod(
+                guard,
+                [guard, total, cachedCount]()
                 {
-                    ++fail;
-                    continue;
-                }
-            }
-            else
+                    if (guard)
+                        guard->log(tr("Exporting %1 image(s), %2 from cached results").arg(total).arg(cachedCount));
+                },
+                Qt::QueuedConnection);
+        }
+        const bool segmentation = (task == InferenceEngine::Task::HipMRI_Seg);
+        std::atomic<int> ok{0};
+        std::atomic<int> fail{0};
+        std::atomic<int> done{0};
+
+        // 编码与写盘在独立线程池中并行，在途数量受限以约束内存
+        QThreadPool writers;
+        writers.setMaxThreadCount(std::max(1, QThread::idealThreadCount() / 2));
+        const size_t maxInFlight = static_cast<size_t>(writers.maxThreadCount()) * 2;
+        std::deque<QFuture<void>> inFlight;
+
+        auto finishItem = [&](bool success)
+        {
+            ++(success ? ok : fail);
+            const int d = ++done;
+            if (guard)
             {
-                ++fail;
-                continue;
+                QMetaObject::invokeMethod(
+                    guard,
+                    [guard, d, total]()
+                    {
+                        if (guard)
+                            guard->updateProgressValue(d, total);
+                    },
+                    Qt::QueuedConnection);
             }
+        };
 
-            auto itI = m_cacheImg.find(path);
-            auto itD = m_cacheDets.find(path);
-            auto itS = m_cacheSegMasks.find(path);
-            InferenceEngine::Result res;
-            if (itI != m_cacheImg.end() && itD != m_cacheDets.end())
+        struct ExportInput
+        {
+            QImage image;
+            QSizeF spacing;
+            bool inferred{false};
+            InferenceEngine::Result result;
+        };
+
+        // 只有未命中缓存的条目才解码源文件，解码与推理一起在解码线程池中并行；
+        // 缓存命中的条目由结果图或保留的底图补绘，不读取源文件
+        const InferenceEngine &engine = segmentation ? m_mriEngine : m_engine;
+        DicomUtils::SeriesDecoder::instance().run<ExportInput>(
+            total,
+            [&jobs, &engine, task, cancelled](int i)
             {
-                res.outputImage = itI.value();
-                res.dets = itD.value();
-                if (itS != m_cacheSegMasks.end())
-                    res.segmentationMask = itS.value();
-            }
-            else
+                ExportInput decoded;
+                const ExportJob &job = jobs[static_cast<size_t>(i)];
+                const bool needsSource = !job.cached || (job.result.outputImage.isNull() && job.base.isNull());
+                if (cancelled->load() || !needsSource)
+                    return decoded;
+                DicomUtils::SliceInfo info;
+                if (loadInputImage(job.path, decoded.image, nullptr, &info, job.frameIndex) && isDicomFile(job.path))
+                    decoded.spacing = QSizeF(info.spacingX, info.spacingY);
+                if (!job.cached && !decoded.image.isNull())
+                {
+                    // 先查磁盘结果缓存；结果回传 GUI 入缓存（不含结果图）
+                    decoded.result = ResultCache::instance().run(engine, decoded.image, task, false);
+                    decoded.inferred = true;
+                }
+                return decoded;
+            },
+            [&](int i, ExportInput &&decoded)
             {
-                if (task == InferenceEngine::Task::HipMRI_Seg)
-                    res = m_mriEngine.run(in, task);
-                else
-                    res = m_engine.run(in, task);
-                m_cacheImg[path] = res.outputImage;
-                m_cacheDets[path] = res.dets;
-                if (!res.segmentationMask.isNull())
-                    m_cacheSegMasks[path] = res.segmentationMask;
-                else
-                    m_cacheSegMasks.remove(path);
-            }
-
-            QString stem = QFileInfo(path).completeBaseName();
-            QString outPng = outDir + "/" + stem + "_pred.png";
-            QString outJs = outDir + "/" + stem + "_pred.json";
+                if (cancelled->load())
+                    return false;
+                ExportJob &job = jobs[static_cast<size_t>(i)];
+                QImage in = decoded.image.isNull() ? job.base : std::move(decoded.image);
+                if (!job.pixelSpacing.isValid() && decoded.spacing.isValid())
+                    job.pixelSpacing = decoded.spacing;
+                if (job.result.outputImage.isNull() && in.isNull())
+                {
+                    LOG_WARNING(QStringLiteral("Batch export failed to load: %1").arg(job.key), "BatchExport", 4008);
+                    finishItem(false);
+                    return true;
+                }
+                if (!job.imageSize.isValid())
+                    job.imageSize = in.isNull() ? job.result.outputImage.size() : in.size();
 
-            if (!res.outputImage.save(outPng))
-            {
-                ++fail;
-                continue;
-            }
-            const bool hasDetections = !res.dets.empty();
-            const bool hasSegMask = !res.segmentationMask.isNull();
-            if (hasDetections)
-            {
-                if (!saveJson(outJs, path, in.size(), res.dets))
+                if (decoded.inferred)
                 {
-                    ++fail;
-                    continue;
+                    job.result = std::move(decoded.result);
+                    if (guard)
+                    {
+                        InferenceEngine::Result cached = job.result;
+                        QMetaObject::invokeMethod(
+                            guard,
+                            [guard, path = job.key, size = job.imageSize, spacing = job.pixelSpacing, cached = std::move(cached), base = in]() mutable
+                            {
+                                if (guard)
+                                    guard->storeExportedResult(path, std::move(cached), size, spacing, base);
+                            },
+                            Qt::QueuedConnection);
+                    }
                 }
-            }
-            if (hasSegMask)
-            {
-                QString maskPath = outDir + "/" + stem + "_mask.png";
-                if (!res.segmentationMask.save(maskPath))
+
+                while (inFlight.size() >= maxInFlight)
                 {
-                    ++fail;
-                    continue;
+                    inFlight.front().waitForFinished();
+                    inFlight.pop_front();
                 }
-            }
-            ++ok;
+                inFlight.push_back(QtConcurrent::run(&writers, [&, job = std::move(job), in = std::move(in)]() mutable
+                                                     {
+                    if (job.result.outputImage.isNull())
+                        job.result.outputImage = InferenceEngine::renderResult(in, job.result, segmentation);
+                    QString error;
+                    QString maskFile;
+                    bool success = writeExportFiles(outDir, job.path, job.frameIndex, job.imageSize, job.result, *encoder,
+                                                    !predictions, &maskFile, &error);
+                    if (success && predictions)
+                    {
+                        success = predictions->append(predictionRecord(job, maskFile, segmentation));
+                        if (!success)
+                            error = QStringLiteral("Failed to append prediction record: %1").arg(job.key);
+                    }
+                    if (!success)
+                        LOG_WARNING(error, "BatchExport", 4006);
+                    finishItem(success); }));
+                return true;
+            });
+
+        for (QFuture<void> &f : inFlight)
+            f.waitForFinished();
+        writers.waitForDone();
+
+        if (predictions)
+        {
+            QString error;
+            const QString cocoPath = writeCoco ? outDir + "/predictions_coco.json" : QString();
+            if (!predictions->finish(cocoPath, &error))
+                LOG_ERROR(error, "BatchExport", 4010);
         }
+
+        ExportSummary summary;
+        summary.total = total;
+        summary.ok = ok.load();
+        summary.fail = fail.load();
+        summary.cancelled = cancelled->load();
+        summary.encoderReport = QStringLiteral("%1 in %2 s").arg(encoder->throughputSummary()).arg(wallClock.elapsed() / 1000.0, 0, 'f', 1);
+        return summary; });
+    m_exportWatcher.setFuture(future);
+}
+
+void MainWindow::handleBatchExportFinished()
+{
+    m_isExportRunning = false;
+    m_exportCancel.reset();
+    setBusyState(false, QString());
+    if (!m_exportWatcher.future().isFinished())
+        return;
+
+    const ExportSummary summary = m_exportWatcher.result();
+    LOG_INFO(QStringLiteral("Batch export encoders: %1").arg(summary.encoderReport), "BatchExport");
+    log(tr("Export encoders: %1").arg(summary.encoderReport));
+    if (summary.cancelled)
+    {
+        const int skipped = std::max(0, summary.total - summary.ok - summary.fail);
         QMessageBox::information(this, "Batch Export",
-                                 QString("Done. Success: %1, Failed: %2").arg(ok).arg(fail));
+                                 QString("Cancelled. Success: %1, Failed: %2, Skipped: %3").arg(summary.ok).arg(summary.fail).arg(skipped));
+        return;
     }
-    catch (const std::exception &e)
+    QMessageBox::information(this, "Batch Export",
+                             QString("Done. Success: %1, Failed: %2").arg(summary.ok).arg(summary.fail));
+}
+
+void MainWindow::runPrecisionReport()
+{
+    if (m_isInferenceRunning || m_isBatchRunning || m_isExportRunning || m_isReportRunning)
     {
-        QString errorMsg = QString("Batch export error: %1").arg(e.what());
-        LOG_ERROR(errorMsg, "BatchExport", 4007);
-        QMessageBox::critical(this, "Batch Export Error", errorMsg);
+        statusBar()->showMessage("Inference already running...");
+        return;
+    }
+    if (!ensureModelReadyForCurrentTask(tr("Precision Report")))
+        return;
+
+    // 参照为配置中的原模型（FP32），变体按 Models/Precision 解析；两者相同则由用户选择变体
+    const bool segmentation = (m_currentTask == TaskSelectionDialog::MRI_Segmentation);
+    const QString basePath = segmentation ? AppConfig::instance().getMriModelPath()
+                                          : AppConfig::instance().getFaiModelPath();
+    QString variantPath = InferenceEngine::resolveModelVariant(basePath);
+    if (QFileInfo(variantPath) == QFileInfo(basePath) &&
+        !promptForModelFile(variantPath, tr("Select FP16 / INT8 Model")))
+        return;
+    if (QFileInfo(variantPath) == QFileInfo(basePath))
+    {
+        QMessageBox::information(this, tr("Precision Report"), tr("The selected model is the FP32 reference itself."));
+        return;
+    }
+
+    const QString folder = QFileDialog::getExistingDirectory(this, tr("Select Validation Folder"));
+    if (folder.isEmpty())
+        return;
+    const QDir dir(folder);
+    QStringList images;
+    for (const QString &name : dir.entryList(QDir::Files, QDir::Name))
+    {
+        const QString path = dir.filePath(name);
+        if (isImageFile(path) || isDicomFile(path))
+            images << path;
+    }
+    if (images.isEmpty())
+    {
+        QMessageBox::information(this, tr("Precision Report"), tr("No images found in %1").arg(folder));
+        return;
+    }
+
+    const InferenceEngine::Task task = inferenceTaskForMode(m_currentTask);
+    const AppConfig::SnapshotPtr config = AppConfig::instance().current();
+    const float conf = config->confidenceThreshold;
+    const float iou = config->iouThreshold;
+    m_reportPath = dir.filePath(QStringLiteral("precision_report.json"));
+    auto cancelled = std::make_shared<std::atomic_bool>(false);
+    m_reportCancel = cancelled;
+    m_isReportRunning = true;
+    refreshActionStates();
+    log(tr("Precision report: %1 vs %2 on %3 image(s)").arg(QFileInfo(variantPath).fileName(), QFileInfo(basePath).fileName()).arg(images.size()));
+    setBusyState(true, tr("Comparing against FP32 on %1 image(s)...").arg(images.size()), 0, true);
+
+    auto future = QtConcurrent::run([basePath, variantPath, images, task, conf, iou, reportPath = m_reportPath, cancelled]()
+                                    {
+        PrecisionReport::Summary summary;
+        InferenceEngine reference;
+        InferenceEngine variant;
+        // 对比引擎与当前模型同族，不得覆盖界面正在使用的类别名与颜色
+        reference.setPublishLabels(false);
+        variant.setPublishLabels(false);
+        if (!reference.loadModel(basePath) || !variant.loadModel(variantPath))
+        {
+            summary.error = QStringLiteral("Failed to load the FP32 reference or the variant model");
+            return summary;
+        }
+        reference.setThresholds(conf, iou);
+        variant.setThresholds(conf, iou);
+        PrecisionReport::run(reference, variant, images, task,
+                             [](const QString &path, QImage &out)
+                             { return loadInputImage(path, out); },
+                             reportPath, summary, cancelled.get());
+        return summary; });
+    m_reportWatcher.setFuture(future);
+}
+
+void MainWindow::handlePrecisionReportFinished()
+{
+    m_isReportRunning = false;
+    m_reportCancel.reset();
+    setBusyState(false, QString());
+    refreshActionStates();
+    if (!m_reportWatcher.future().isFinished())
+        return;
+
+    const PrecisionReport::Summary summary = m_reportWatcher.result();
+    if (!summary.error.isEmpty())
+    {
+        LOG_WARNING(summary.error, "Inference", 5032);
+        QMessageBox::warning(this, tr("Precision Report"), summary.error);
+        return;
+    }
+    LOG_INFO(QStringLiteral("Precision report: %1").arg(summary.toText()), "Inference");
+    log(tr("Precision report: %1").arg(summary.toText()));
+    QString text = summary.toText();
+    if (summary.cancelled)
+        text.prepend(tr("Cancelled (partial report). "));
+    if (summary.failed > 0)
+        text += tr("\n%1 image(s) could not be loaded.").arg(summary.failed);
+    QMessageBox::information(this, tr("Precision Report"), tr("%1\n\nReport: %2").arg(text, m_reportPath));
+}
+
+void MainWindow::storeExportedResult(const QString &path, InferenceEngine::Result &&result,
+                                     const QSize &imageSize, const QSizeF &pixelSpacing, const QImage &baseImage)
+{
+    // 导出期间新推理的结果；已有缓存（例如用户期间单独推理过）不覆盖
+    if (m_cacheDets.contains(path))
+        return;
+    m_cacheImg[path] = QImage();
+    m_cacheDets[path] = std::move(result.dets);
+    m_cacheSizes[path] = imageSize;
+    if (pixelSpacing.isValid())
+        m_cacheSpacings[path] = pixelSpacing;
+    if (!result.segmentationMask.isNull())
+        m_cacheSegMasks[path] = std::move(result.segmentationMask);
+    storeBaseImage(path, baseImage);
+}
+
+PredictionWriter::Record MainWindow::predictionRecord(const ExportJob &job, const QString &maskFile, bool segmentationMode)
+{
+    PredictionWriter::Record record;
+    record.imagePath = job.path;
+    record.frameIndex = job.multiFrame ? job.frameIndex : -1;
+    record.imageSize = job.imageSize;
+    record.pixelSpacing = job.pixelSpacing;
+    record.maskFile = maskFile;
+    record.predictions.reserve(job.result.dets.size());
+    for (const auto &det : job.result.dets)
+    {
+        PredictionWriter::Prediction p;
+        p.classId = det.cls;
+        p.className = segmentationMode ? InferenceEngine::segmentationClassName(det.cls) : InferenceEngine::className(det.cls);
+        p.score = det.score;
+        p.bbox = QRectF(QPointF(det.x1, det.y1), QPointF(det.x2, det.y2));
+        p.areaPixels = det.hasMask ? det.maskAreaPixels : 0.0;
+        p.contours = det.contours;
+        p.polygonAreaPixels = det.contourAreaPixels;
+        record.predictions.push_back(std::move(p));
+    }
+    return record;
+}
+
+bool MainWindow::writeExportFiles(const QString &outDir,
+                                  const QString &path,
+                                  int frameIndex,
+                                  const QSize &imageSize,
+                                  const InferenceEngine::Result &res,
+                                  const ExportEncoder &encoder,
+                                  bool perImageJson,
+                                  QString *maskFile,
+                                  QString *error)
+{
+    QString stem = QFileInfo(path).completeBaseName();
+    if (frameIndex > 0)
+        stem += QStringLiteral("_f%1").arg(frameIndex + 1, 4, 10, QLatin1Char('0'));
+    const QString outImage = outDir + "/" + stem + "_pred." + encoder.imageSuffix();
+    if (!encoder.writeImage(res.outputImage, outImage, error))
+        return false;
+    if (perImageJson && !res.dets.empty())
+    {
+        const QString outJs = outDir + "/" + stem + "_pred.json";
+        if (!saveJson(outJs, path, imageSize, res.dets))
+        {
+            if (error)
+                *error = QStringLiteral("Failed to save JSON: %1").arg(outJs);
+            return false;
+        }
     }
+    if (!res.segmentationMask.isNull())
+    {
+        const QString maskName = stem + "_mask." + encoder.maskSuffix();
+        if (!encoder.writeMask(res.segmentationMask, outDir + "/" + maskName, error))
+            return false;
+        if (maskFile)
+            *maskFile = maskName;
+    }
+    return true;
+}
+
+bool MainWindow::loadInputImage(const QString &path, QImage &out, QString *error, DicomUtils::SliceInfo *info, int frameIndex)
+{
+    if (isImageFile(path))
+    {
+        if (out.load(path))
+            return true;
+        if (error)
+            *error = QStringLiteral("Failed to load image: %1").arg(path);
+        return false;
+    }
+    if (isDicomFile(path))
+    {
+#ifdef HAVE_GDCM
+        if (DicomUtils::loadDicomFrameToQImage(path, frameIndex, out, nullptr, info))
+            return true;
+        if (error)
+            *error = QStringLiteral("Failed to load DICOM: %1").arg(path);
+#else
+        Q_UNUSED(info);
+        Q_UNUSED(frameIndex);
+        if (error)
+            *error = QStringLiteral("Built without GDCM support");
+#endif
+        return false;
+    }
+    if (error)
+        *error = QStringLiteral("Unsupported file: %1").arg(path);
+    return false;
 }
 
 bool MainWindow::saveJson(const QString &jsonPath,
@@ -1306,6 +2201,24 @@ bool MainWindow::saveJson(const QString &jsonPath,
         b["w"] = d.x2 - d.x1;
         b["h"] = d.y2 - d.y1;
         o["bbox"] = b;
+        if (d.hasMask)
+            o["area_px"] = d.maskAreaPixels;
+        if (!d.contours.isEmpty())
+        {
+            QJsonArray contours;
+            for (const QPolygonF &poly : d.contours)
+            {
+                QJsonArray pts;
+                for (const QPointF &pt : poly)
+                {
+                    pts.append(std::round(pt.x() * 10.0) / 10.0);
+                    pts.append(std::round(pt.y() * 10.0) / 10.0);
+                }
+                contours.append(pts);
+            }
+            o["contours"] = contours;
+            o["polygon_area_px"] = d.contourAreaPixels;
+        }
         arr.append(o);
     }
     root["predictions"] = arr;
@@ -1323,6 +2236,16 @@ void MainWindow::handleSliceStep(int steps)
 {
     if (steps == 0 || m_dicomSeries.isEmpty())
         return;
+    if (m_viewAxis != DicomUtils::Volume::Axis::Axial && volumeCoversSeries())
+    {
+        const int count = m_volume->sliceCount(m_viewAxis);
+        const int next = std::clamp(m_reformatIndex + steps, 0, std::max(0, count - 1));
+        if (next == m_reformatIndex)
+            return;
+        m_reformatIndex = next;
+        displayReformattedSlice();
+        return;
+    }
     const int maxIndex = std::max(0, static_cast<int>(m_dicomSeries.size()) - 1);
     int newIndex = std::clamp(m_currentSliceIndex + steps, 0, maxIndex);
     if (newIndex == m_currentSliceIndex)
@@ -1338,17 +2261,41 @@ void MainWindow::displayDicomSlice(int index)
     QImage img;
     QMap<QString, QString> meta;
     DicomUtils::SliceInfo info;
-#ifdef HAVE_GDCM
-    if (!DicomUtils::loadDicomToQImage(m_dicomSeries[index].path, img, &meta, &info))
+    const DicomSliceEntry &entry = m_dicomSeries[index];
+    if (m_viewAxis != DicomUtils::Volume::Axis::Axial)
     {
-        statusBar()->showMessage(tr("Failed to load slice: %1").arg(m_dicomSeries[index].path), 5000);
-        return;
+        m_viewAxis = DicomUtils::Volume::Axis::Axial;
+        if (m_actAxial)
+            m_actAxial->setChecked(true);
     }
+    if (volumeCoversSeries())
+    {
+        // 体数据已就绪：直接取轴位切层，无需重新解码
+        img = m_volume->render(DicomUtils::Volume::Axis::Axial, index);
+        meta = m_seriesMeta;
+        meta.insert("Path", entry.path);
+        meta.insert("InstanceNumber", QString::number(entry.instanceNumber));
+        meta.insert("SliceLocation", QString::number(entry.sliceLocation, 'f', 3));
+        if (meta.contains("Frame"))
+            meta.insert("Frame", QString("%1 / %2").arg(entry.frameIndex + 1).arg(meta.value("NumberOfFrames")));
+        info.spacingX = m_volume->spacingX();
+        info.spacingY = m_volume->spacingY();
+    }
+    else
+    {
+#ifdef HAVE_GDCM
+        if (!DicomUtils::loadDicomFrameToQImage(entry.path, entry.frameIndex, img, &meta, &info))
+        {
+            statusBar()->showMessage(tr("Failed to load slice: %1").arg(entry.path), 5000);
+            return;
+        }
+        m_seriesMeta = meta;
 #else
-    Q_UNUSED(info);
-    statusBar()->showMessage(tr("Built without GDCM support"), 5000);
-    return;
+        Q_UNUSED(info);
+        statusBar()->showMessage(tr("Built without GDCM support"), 5000);
+        return;
 #endif
+    }
 
     if (info.spacingX > 0)
         m_spacingX = info.spacingX;
@@ -1368,17 +2315,15 @@ void MainWindow::displayDicomSlice(int index)
     updateMetaTable(meta);
     updateSliceIndicator();
 
-    if (m_cacheImg.contains(m_currentPath))
+    const QString cacheKey = currentCacheKey();
+    if (m_cacheImg.contains(cacheKey))
     {
-        m_output = m_cacheImg.value(m_currentPath);
-        m_lastDets = m_cacheDets.value(m_currentPath);
-        m_segmentationMask = m_cacheSegMasks.value(m_currentPath);
-        if (!m_output.isNull())
-        {
-            const bool focus = (m_currentTask != TaskSelectionDialog::MRI_Segmentation);
-            setOutputImage(m_output, focus);
-        }
-        annotateCachedSegmentationIfNeeded(m_currentPath);
+        m_output = m_cacheImg.value(cacheKey);
+        m_lastDets = m_cacheDets.value(cacheKey);
+        m_segmentationMask = m_cacheSegMasks.value(cacheKey);
+        const bool focus = (m_currentTask != TaskSelectionDialog::MRI_Segmentation);
+        showOutput(focus);
+        annotateCachedSegmentationIfNeeded(cacheKey);
     }
     else
     {
@@ -1404,7 +2349,19 @@ void MainWindow::setupDicomSeries(const QString &path, const DicomUtils::SliceIn
     m_dicomSeries.clear();
 
 #ifdef HAVE_GDCM
-    if (!m_currentSeriesUid.isEmpty())
+    if (info.frameCount > 1)
+    {
+        // 增强型多帧对象：整个序列在一个文件中，帧即切层，按帧序号排列
+        QVector<double> locations;
+        DicomUtils::probeFrameLocations(path, locations);
+        m_dicomSeries.reserve(info.frameCount);
+        for (int f = 0; f < info.frameCount; ++f)
+        {
+            const double location = (f < locations.size()) ? locations[f] : info.sliceLocation;
+            m_dicomSeries.push_back({path, f, f + 1, location});
+        }
+    }
+    else if (!m_currentSeriesUid.isEmpty())
     {
         const QFileInfo fi(path);
         QDir dir = fi.dir();
@@ -1419,7 +2376,7 @@ void MainWindow::setupDicomSeries(const QString &path, const DicomUtils::SliceIn
                 continue;
             if (!meta.seriesInstanceUID.isEmpty() && meta.seriesInstanceUID != m_currentSeriesUid)
                 continue;
-            entries.push_back({absolutePath, meta.instanceNumber, meta.sliceLocation});
+            entries.push_back({absolutePath, 0, meta.instanceNumber, meta.sliceLocation});
         }
         if (!entries.isEmpty())
         {
@@ -1434,11 +2391,11 @@ void MainWindow::setupDicomSeries(const QString &path, const DicomUtils::SliceIn
 #endif
 
     if (m_dicomSeries.isEmpty())
-        m_dicomSeries.append({path, info.instanceNumber, info.sliceLocation});
+        m_dicomSeries.append({path, 0, info.instanceNumber, info.sliceLocation});
 
     for (int i = 0; i < m_dicomSeries.size(); ++i)
     {
-        if (m_dicomSeries[i].path == path)
+        if (m_dicomSeries[i].path == path && m_dicomSeries[i].frameIndex == 0)
         {
             m_currentSliceIndex = i;
             break;
@@ -1449,11 +2406,18 @@ void MainWindow::setupDicomSeries(const QString &path, const DicomUtils::SliceIn
 
     updateSliceNavigationState();
     updateSliceIndicator();
+    startVolumeBuild();
 }
 
 void MainWindow::clearDicomSeries()
 {
     m_dicomSeries.clear();
+    m_volume.reset();
+    ++m_volumeGeneration;
+    m_viewAxis = DicomUtils::Volume::Axis::Axial;
+    m_reformatIndex = 0;
+    if (m_actAxial)
+        m_actAxial->setChecked(true);
     m_currentSliceIndex = -1;
     m_spacingX = 1.0;
     m_spacingY = 1.0;
@@ -1463,6 +2427,122 @@ void MainWindow::clearDicomSeries()
     updateSliceNavigationState();
 }
 
+std::vector<MainWindow::BatchFrame> MainWindow::expandBatchFrames(const QStringList &paths)
+{
+    std::vector<BatchFrame> frames;
+    frames.reserve(static_cast<size_t>(paths.size()));
+    for (const QString &path : paths)
+    {
+        int frameCount = 1;
+        DicomUtils::SliceInfo info;
+        if (isDicomFile(path) && DicomUtils::probeSliceInfo(path, info))
+            frameCount = std::max(1, info.frameCount);
+        for (int f = 0; f < frameCount; ++f)
+            frames.push_back({path, f, frameCacheKey(path, f), frameCount > 1});
+    }
+    return frames;
+}
+
+QString MainWindow::frameCacheKey(const QString &path, int frameIndex)
+{
+    // 单帧文件沿用路径作为缓存键，多帧对象的后续帧追加帧序号
+    return (frameIndex > 0) ? QStringLiteral("%1#%2").arg(path).arg(frameIndex) : path;
+}
+
+QString MainWindow::currentCacheKey() const
+{
+    if (m_currentSliceIndex >= 0 && m_currentSliceIndex < m_dicomSeries.size() &&
+        m_dicomSeries[m_currentSliceIndex].path == m_currentPath)
+        return frameCacheKey(m_currentPath, m_dicomSeries[m_currentSliceIndex].frameIndex);
+    return m_currentPath;
+}
+
+bool MainWindow::volumeCoversSeries() const
+{
+    return m_volume && m_volume->depth() == m_dicomSeries.size();
+}
+
+void MainWindow::startVolumeBuild()
+{
+    m_volume.reset();
+    const int generation = ++m_volumeGeneration;
+    if (m_dicomSeries.size() < 2 || m_currentTask != TaskSelectionDialog::MRI_Segmentation)
+        return;
+
+    QVector<DicomUtils::Volume::Source> sources;
+    sources.reserve(m_dicomSeries.size());
+    for (const DicomSliceEntry &entry : m_dicomSeries)
+        sources.push_back({entry.path, entry.frameIndex});
+
+    m_volumeBuildGeneration = generation;
+    auto future = QtConcurrent::run([sources]() -> std::shared_ptr<const DicomUtils::Volume>
+                                    {
+        auto volume = std::make_shared<DicomUtils::Volume>();
+        QString error;
+        if (!volume->build(sources, &error))
+        {
+            LOG_WARNING(QStringLiteral("Volume assembly failed: %1").arg(error), "Volume", 3005);
+            return nullptr;
+        }
+        return volume; });
+    m_volumeWatcher.setFuture(future);
+}
+
+void MainWindow::handleVolumeBuildFinished()
+{
+    if (m_volumeBuildGeneration != m_volumeGeneration || !m_volumeWatcher.future().isFinished())
+        return;
+    m_volume = m_volumeWatcher.result();
+    if (!volumeCoversSeries())
+    {
+        m_volume.reset();
+        return;
+    }
+    log(tr("Volume ready: %1 x %2 x %3, spacing %4 / %5 / %6 mm")
+            .arg(m_volume->width())
+            .arg(m_volume->height())
+            .arg(m_volume->depth())
+            .arg(m_volume->spacingX(), 0, 'f', 3)
+            .arg(m_volume->spacingY(), 0, 'f', 3)
+            .arg(m_volume->spacingZ(), 0, 'f', 3));
+    updateSliceNavigationState();
+}
+
+void MainWindow::setViewAxis(DicomUtils::Volume::Axis axis)
+{
+    if (axis == m_viewAxis)
+        return;
+    if (axis != DicomUtils::Volume::Axis::Axial && !volumeCoversSeries())
+    {
+        if (m_actAxial)
+            m_actAxial->setChecked(true);
+        return;
+    }
+
+    m_viewAxis = axis;
+    if (axis == DicomUtils::Volume::Axis::Axial)
+    {
+        displayDicomSlice(m_currentSliceIndex);
+        return;
+    }
+    m_reformatIndex = m_volume->sliceCount(axis) / 2;
+    displayReformattedSlice();
+}
+
+void MainWindow::displayReformattedSlice()
+{
+    if (!volumeCoversSeries())
+        return;
+    const QImage img = m_volume->render(m_viewAxis, m_reformatIndex);
+    if (img.isNull())
+        return;
+    setInputImage(img);
+    // 分割只在轴位进行，重建切面没有对应的输出
+    if (m_outputView)
+        m_outputView->clearImage();
+    updateSliceIndicator();
+}
+
 void MainWindow::updateSliceNavigationState()
 {
     const bool enable = (m_dicomSeries.size() > 1) && (m_currentTask == TaskSelectionDialog::MRI_Segmentation);
@@ -1470,6 +2550,12 @@ void MainWindow::updateSliceNavigationState()
         m_inputView->setSliceNavigationEnabled(enable);
     if (m_outputView)
         m_outputView->setSliceNavigationEnabled(enable);
+    const bool mpr = enable && volumeCoversSeries();
+    for (QAction *act : {m_actAxial, m_actCoronal, m_actSagittal})
+    {
+        if (act)
+            act->setEnabled(mpr);
+    }
     if (enable)
         updateSliceIndicator();
     else if (m_sliceIndicator)
@@ -1485,7 +2571,12 @@ void MainWindow::updateSliceIndicator()
         m_sliceIndicator->hide();
         return;
     }
-    m_sliceIndicator->setText(tr("Slice %1 / %2").arg(m_currentSliceIndex + 1).arg(m_dicomSeries.size()));
+    if (m_viewAxis == DicomUtils::Volume::Axis::Coronal && volumeCoversSeries())
+        m_sliceIndicator->setText(tr("Coronal %1 / %2").arg(m_reformatIndex + 1).arg(m_volume->sliceCount(m_viewAxis)));
+    else if (m_viewAxis == DicomUtils::Volume::Axis::Sagittal && volumeCoversSeries())
+        m_sliceIndicator->setText(tr("Sagittal %1 / %2").arg(m_reformatIndex + 1).arg(m_volume->sliceCount(m_viewAxis)));
+    else
+        m_sliceIndicator->setText(tr("Slice %1 / %2").arg(m_currentSliceIndex + 1).arg(m_dicomSeries.size()));
     m_sliceIndicator->adjustSize();
     m_sliceIndicator->show();
     positionSliceIndicator();
@@ -1573,7 +2664,7 @@ void MainWindow::postProcessSegmentationResult(InferenceEngine::Result &result)
 
 void MainWindow::annotateCachedSegmentationIfNeeded(const QString &path)
 {
-    if (m_currentTask != TaskSelectionDialog::MRI_Segmentation || m_output.isNull())
+    if (m_currentTask != TaskSelectionDialog::MRI_Segmentation || (m_lastDets.empty() && m_segmentationMask.isNull()))
         return;
     bool needsAnnotation = false;
     for (const auto &det : m_lastDets)
@@ -1606,7 +2697,52 @@ void MainWindow::annotateCachedSegmentationIfNeeded(const QString &path)
         m_cacheSegMasks.remove(path);
     statusBar()->showMessage(temp.summary, 5000);
     const bool focus = (m_currentTask != TaskSelectionDialog::MRI_Segmentation);
-    setOutputImage(m_output, focus);
+    showOutput(focus);
+}
+
+QVector<OverlayLayer::Box> MainWindow::overlayBoxes(const std::vector<InferenceEngine::Detection> &dets,
+                                                    bool segmentationMode) const
+{
+    QVector<OverlayLayer::Box> boxes;
+    boxes.reserve(static_cast<int>(dets.size()));
+    for (const auto &det : dets)
+    {
+        // 分割模式只标注有掩码的实例，与导出时的标注一致
+        if (segmentationMode && (!det.hasMask || det.maskAreaPixels <= 0))
+            continue;
+        OverlayLayer::Box box;
+        box.rect = QRectF(det.x1, det.y1, det.x2 - det.x1, det.y2 - det.y1);
+        box.cls = det.cls;
+        if (segmentationMode)
+        {
+            box.text = segmentationLabel(det.cls);
+            box.color = InferenceEngine::segmentationClassColor(det.cls);
+        }
+        else
+        {
+            box.text = QString("%1  %2%").arg(InferenceEngine::className(det.cls)).arg(int(std::round(det.score * 100)));
+            box.color = InferenceEngine::classColor(det.cls);
+        }
+        boxes.push_back(box);
+    }
+    return boxes;
+}
+
+void MainWindow::renderOutputForExport()
+{
+    // 显示走叠加层，只有导出时才把结果烧录到整幅图像上
+    if (!m_output.isNull() || m_input.isNull() || (m_lastDets.empty() && m_segmentationMask.isNull()))
+        return;
+    InferenceEngine::Result temp;
+    temp.dets = m_lastDets;
+    temp.segmentationMask = m_segmentationMask;
+    const bool segmentationMode = (m_currentTask == TaskSelectionDialog::MRI_Segmentation);
+    m_output = InferenceEngine::renderResult(m_input, temp, segmentationMode);
+    if (segmentationMode)
+        annotateSegmentationImage(m_output, m_lastDets, currentPixelArea());
+    const QString key = currentCacheKey();
+    if (m_cacheImg.contains(key))
+        m_cacheImg[key] = m_output;
 }
 
 void MainWindow::updateSegmentationStats(const std::vector<InferenceEngine::Detection> &dets)
@@ -7,23 +7,42 @@
 #include <QMainWindow>
 #include <QMap>
 #include <QStringList>
+#include <QSize>
+#include <QSizeF>
 #include <QVector>
+#include <atomic>
+#include <deque>
+#include <memory>
 
+#include "AppConfig.h"
+#include "BoundedQueue.h"
 #include "InferenceEngine.h"
+#include "OverlayLayer.h"
+#include "PrecisionReport.h"
+#include "PredictionWriter.h"
 #include "TaskSelectionDialog.h"
 #include "medical/DicomUtils.h"
+#include "medical/DicomVolume.h"
 
 class QAction;
+class ExportEncoder;
+class QCheckBox;
 class QLabel;
 class QDockWidget;
-class QPlainTextEdit;
+class QComboBox;
+class QTableView;
+class QTimer;
+class LogModel;
+class LogFilterModel;
 class QProgressBar;
 class QProgressDialog;
 class QTabWidget;
 class QTableWidget;
 class ImageView;
 class MetaTable;
-class QListWidget;
+class QListView;
+class BatchListModel;
+class FolderScanner;
 
 class MainWindow : public QMainWindow
 {
@@ -36,6 +55,13 @@ public:
     QMap<QString, QImage> m_cacheImg;
     QMap<QString, std::vector<InferenceEngine::Detection>> m_cacheDets;
     QMap<QString, QImage> m_cacheSegMasks;
+    QMap<QString, QSize> m_cacheSizes; // 原图尺寸，导出 JSON 时无需重新解码
+    QMap<QString, QSizeF> m_cacheSpacings; // DICOM 像素间距（毫米），用于导出 mm² 面积
+    // 批量结果的 8 位底图，总量受 Export/BaseImageCacheMB 限制、按写入顺序淘汰；导出据此补绘结果图
+    QMap<QString, QImage> m_cacheBase;
+    std::deque<QString> m_cacheBaseOrder;
+    qint64 m_cacheBaseBytes{0};
+    void storeBaseImage(const QString &key, const QImage &image);
 
 private slots:
     void openImage();
@@ -51,6 +77,7 @@ private slots:
     void runBatchInference();
     void switchTask();
     void toggleLogDock(bool checked);
+    void runPrecisionReport();
 
 private:
     void setupUi();
@@ -60,21 +87,34 @@ private:
     void createStatusBar();
     void applyPalette();
     void applyStyleSheet(const QString &resourcePath);
-    void appendLog(const QString &message);
     void log(const QString &s);
     void updateTaskUi(TaskSelectionDialog::TaskType taskType);
+    // 应用配置快照（启动时与配置热重载后）
+    void applyConfig(const AppConfig::Snapshot &config);
     void updateStatusSummary();
+    void rebuildLayerControls(TaskSelectionDialog::TaskType taskType);
     void setInputImage(const QImage &img);
-    void setOutputImage(const QImage &img, bool focusOutput = true);
+    void showOutput(bool focusOutput = true);
     void updateMetaTable(const QMap<QString, QString> &meta);
     void loadPath(const QString &path);
     bool promptForModelFile(QString &path, const QString &title) const;
     static bool isImageFile(const QString &path);
     static bool isDicomFile(const QString &path);
+    // 按扩展名加载普通图像或 DICOM（第一帧），可在工作线程中调用
+    static bool loadInputImage(const QString &path, QImage &out, QString *error = nullptr,
+                               DicomUtils::SliceInfo *info = nullptr, int frameIndex = 0);
     void refreshActionStates();
     void handleSingleInferenceFinished();
+    // 单图结果写入内存缓存并显示（推理完成或磁盘结果缓存命中）
+    void applySingleResult(InferenceEngine::Result &&result, const QString &cacheKey, InferenceEngine::Task task);
+    // 在工作线程中查磁盘结果缓存，命中且仍是当前输入时显示
+    void restorePersistedResult();
+    void handleRestoreFinished();
     void handleBatchInferenceFinished();
-    void setBusyState(bool busy, const QString &message, int maximum = 0);
+    void cancelBackgroundWork();
+    void handleBatchExportFinished();
+    void handlePrecisionReportFinished();
+    void setBusyState(bool busy, const QString &message, int maximum = 0, bool cancellable = false);
     void updateProgressValue(int value, int maximum);
     void updateSliceNavigationState();
     void updateSliceIndicator();
@@ -83,6 +123,13 @@ private:
     void displayDicomSlice(int index);
     void setupDicomSeries(const QString &path, const DicomUtils::SliceInfo &info);
     void clearDicomSeries();
+    QString currentCacheKey() const;
+    void startVolumeBuild();
+    void handleVolumeBuildFinished();
+    bool volumeCoversSeries() const;
+    void setViewAxis(DicomUtils::Volume::Axis axis);
+    void displayReformattedSlice();
+    static QString frameCacheKey(const QString &path, int frameIndex);
     void postProcessSegmentationResult(InferenceEngine::Result &result);
     double currentPixelArea() const;
     QString segmentationLabel(int cls) const;
@@ -90,6 +137,13 @@ private:
                                    const std::vector<InferenceEngine::Detection> &dets,
                                    double areaFactor) const;
     void annotateCachedSegmentationIfNeeded(const QString &path);
+    void handleFolderChunk(const QStringList &paths);
+    void handleFolderScanFinished(int total);
+    void selectBatchPath(const QString &path);
+    bool ensureBatchListReady(const QString &title);
+    QVector<OverlayLayer::Box> overlayBoxes(const std::vector<InferenceEngine::Detection> &dets,
+                                            bool segmentationMode) const;
+    void renderOutputForExport();
     void updateSegmentationStats(const std::vector<InferenceEngine::Detection> &dets);
     void clearSegmentationStats();
     bool isModelReadyForTask(TaskSelectionDialog::TaskType task) const;
@@ -104,14 +158,29 @@ private:
     ImageView *m_outputView{nullptr};
 
     MetaTable *m_meta{nullptr};
-    QListWidget *m_list{nullptr};
+    QListView *m_list{nullptr};
+    BatchListModel *m_batchModel{nullptr};
+    FolderScanner *m_folderScanner{nullptr};
     QLineEdit *m_batchFilter{nullptr};
-    QPlainTextEdit *m_logView{nullptr};
+    QTableView *m_logView{nullptr};
+    LogModel *m_logModel{nullptr};
+    LogFilterModel *m_logFilter{nullptr};
+    QComboBox *m_logLevelFilter{nullptr};
+    QComboBox *m_logModuleFilter{nullptr};
+    QTimer *m_logTimer{nullptr};
+    int m_configSubscription{0};
+    QStringList m_appliedClassNames;
+    static constexpr int kLogScrollback = 5000; // 日志面板最多保留的行数
+    static constexpr int kLogRefreshMs = 100;   // 日志面板刷新间隔
+    void drainLogEntries();
     QDockWidget *m_metadataDock{nullptr};
     QDockWidget *m_batchDock{nullptr};
     QDockWidget *m_logDock{nullptr};
     QDockWidget *m_segStatsDock{nullptr};
     QTableWidget *m_segStats{nullptr};
+    QDockWidget *m_layerDock{nullptr};
+    QTableWidget *m_layerTable{nullptr};
+    QCheckBox *m_showMasks{nullptr};
 
     QLabel *m_statusMode{nullptr};
     QLabel *m_statusModel{nullptr};
@@ -119,7 +188,6 @@ private:
 
     QImage m_input;
     QString m_currentPath;
-    QStringList m_batch;
     QString m_faiOnnxPath;
     QString m_mriOnnxPath;
 
@@ -127,20 +195,27 @@ private:
     bool m_mriModelReady{false};
     bool m_isInferenceRunning{false};
     bool m_isBatchRunning{false};
+    bool m_isExportRunning{false};
+    bool m_isReportRunning{false};
 
     QAction *m_actRun{nullptr};
     QAction *m_actBatch{nullptr};
     QAction *m_actExport{nullptr};
     QAction *m_actExportAll{nullptr};
+    QAction *m_actPrecisionReport{nullptr};
     QAction *m_actLoadFAI{nullptr};
     QAction *m_actLoadMRI{nullptr};
     QAction *m_actToggleLog{nullptr};
+    QAction *m_actAxial{nullptr};
+    QAction *m_actCoronal{nullptr};
+    QAction *m_actSagittal{nullptr};
 
     TaskSelectionDialog::TaskType m_currentTask{TaskSelectionDialog::FAI_XRay};
     InferenceEngine m_engine;
     InferenceEngine m_mriEngine;
     QImage m_output;
     std::vector<InferenceEngine::Detection> m_lastDets;
+    QString m_lastSummary;
     QImage m_segmentationMask;
     QProgressDialog *m_progressDialog{nullptr};
     QString m_pendingInferencePath;
@@ -150,6 +225,7 @@ private:
     struct DicomSliceEntry
     {
         QString path;
+        int frameIndex{0}; // 多帧对象中的帧序号，单帧文件恒为 0
         int instanceNumber{0};
         double sliceLocation{0.0};
     };
@@ -158,17 +234,97 @@ private:
     double m_spacingX{1.0};
     double m_spacingY{1.0};
     QString m_currentSeriesUid;
+    QMap<QString, QString> m_seriesMeta;
+
+    // 当前序列的连续体数据（后台组装），供轴位显示、MPR 与整序列分割复用
+    std::shared_ptr<const DicomUtils::Volume> m_volume;
+    QFutureWatcher<std::shared_ptr<const DicomUtils::Volume>> m_volumeWatcher;
+    int m_volumeGeneration{0};
+    int m_volumeBuildGeneration{0};
+    DicomUtils::Volume::Axis m_viewAxis{DicomUtils::Volume::Axis::Axial};
+    int m_reformatIndex{0};
 
     struct BatchItem
     {
         QString path;
         bool success{false};
         InferenceEngine::Result result;
+        QSize imageSize;
+        QSizeF pixelSpacing;
         QString error;
+        bool cached{false}; // 来自磁盘结果缓存
+        QImage baseImage;   // 导出补绘结果图用的 8 位底图（未保留时为空）
+    };
+
+    // 批量任务的一帧：多帧 DICOM 按帧展开，key 与内存结果缓存的键一致
+    struct BatchFrame
+    {
+        QString path;
+        int frameIndex{0};
+        QString key;
+        bool multiFrame{false};
+    };
+    // 在工作线程中调用：DICOM 只读取头部获得帧数
+    static std::vector<BatchFrame> expandBatchFrames(const QStringList &paths);
+
+    struct ExportJob
+    {
+        QString path;
+        QString key;        // 内存结果缓存的键（多帧对象的后续帧带帧序号）
+        int frameIndex{0};
+        bool multiFrame{false};
+        bool cached{false}; // 命中结果缓存，不再推理
+        InferenceEngine::Result result;
+        QImage base;        // 批量推理保留的底图，存在时不再解码源文件
+        QSize imageSize;
+        QSizeF pixelSpacing; // 无效表示未知
+    };
+
+    struct ExportSummary
+    {
+        int total{0};
+        int ok{0};
+        int fail{0};
+        bool cancelled{false};
+        QString encoderReport; // 编码吞吐统计
     };
 
     QFutureWatcher<InferenceEngine::Result> m_singleWatcher;
-    QFutureWatcher<std::vector<BatchItem>> m_batchWatcher;
+    // 磁盘结果缓存查询：键的引擎部分在 GUI 线程取得，工作线程只哈希图像并查表
+    QFutureWatcher<InferenceEngine::Result> m_restoreWatcher;
+    QString m_restoreKey;
+    QByteArray m_restoreContext;
+    InferenceEngine::Task m_restoreTask{InferenceEngine::Task::Auto};
+    QFutureWatcher<void> m_batchWatcher;
+    // 推理线程与 GUI 之间的结果队列，容量即背压窗口
+    static constexpr size_t kBatchQueueCapacity = 8;
+    std::shared_ptr<BoundedQueue<BatchItem>> m_batchQueue;
+    int m_batchTotal{0};
+    int m_batchOk{0};
+    int m_batchFail{0};
+    int m_batchCached{0};
+    void drainBatchResults();
+    void applyBatchItem(BatchItem &&item);
+
+    QFutureWatcher<ExportSummary> m_exportWatcher;
+    std::shared_ptr<std::atomic_bool> m_exportCancel;
+
+    // FP16 / INT8 变体相对 FP32 的精度报告（两个模型均在工作线程中独立加载）
+    QFutureWatcher<PrecisionReport::Summary> m_reportWatcher;
+    std::shared_ptr<std::atomic_bool> m_reportCancel;
+    QString m_reportPath;
+    void storeExportedResult(const QString &path, InferenceEngine::Result &&result,
+                             const QSize &imageSize, const QSizeF &pixelSpacing, const QImage &baseImage);
+    static PredictionWriter::Record predictionRecord(const ExportJob &job, const QString &maskFile, bool segmentationMode);
+    static bool writeExportFiles(const QString &outDir,
+                                 const QString &path,
+                                 int frameIndex,
+                                 const QSize &imageSize,
+                                 const InferenceEngine::Result &res,
+                                 const ExportEncoder &encoder,
+                                 bool perImageJson,
+                                 QString *maskFile,
+                                 QString *error);
 
     static bool saveJson(const QString &jsonPath,
                          const QString &srcPath,
@@ -0,0 +1,150 @@
+#include "OverlayLayer.h"
+#include "InferenceEngine.h"
+#include "TiledImageItem.h"
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+
+OverlayLayer::OverlayLayer(QGraphicsItem *parent) : QGraphicsItem(parent)
+{
+    m_maskItem = new TiledImageItem(this);
+    m_maskItem->setFlag(QGraphicsItem::ItemStacksBehindParent, true);
+}
+
+void OverlayLayer::setContent(const QVector<Box> &boxes, const QImage &labelMask, Style style)
+{
+    prepareGeometryChange();
+    m_boxes = boxes;
+    m_style = style;
+    m_labelMask = (labelMask.format() == QImage::Format_Indexed8) ? labelMask : QImage();
+
+    const QFontMetricsF fm(labelFont());
+    m_bounds = QRectF();
+    for (const Box &box : m_boxes)
+        m_bounds |= box.rect.adjusted(-2.0, -2.0, 2.0, 2.0) | labelRect(box, fm);
+    refreshMask();
+    update();
+}
+
+void OverlayLayer::clearContent()
+{
+    setContent({}, QImage(), m_style);
+}
+
+qreal OverlayLayer::classOpacity(int cls) const
+{
+    if (m_hiddenClasses.contains(cls))
+        return 0.0;
+    return m_classOpacity.value(cls, 1.0);
+}
+
+QFont OverlayLayer::labelFont() const
+{
+    if (m_style == Style::Detection)
+        return QFont("Sans", 12, QFont::Bold);
+    QFont font;
+    font.setPointSize(7);
+    font.setBold(true);
+    return font;
+}
+
+QRectF OverlayLayer::labelRect(const Box &box, const QFontMetricsF &fm) const
+{
+    const qreal pad = (m_style == Style::Segmentation) ? 12.0 : 10.0;
+    const QSizeF size(fm.horizontalAdvance(box.text) + pad, fm.height() + 6.0);
+    return QRectF(QPointF(box.rect.left(), std::max<qreal>(0.0, box.rect.top() - size.height())), size);
+}
+
+void OverlayLayer::setClassVisible(int cls, bool visible)
+{
+    if (visible == !m_hiddenClasses.contains(cls))
+        return;
+    if (visible)
+        m_hiddenClasses.remove(cls);
+    else
+        m_hiddenClasses.insert(cls);
+    refreshPalette();
+    update();
+}
+
+void OverlayLayer::setClassOpacity(int cls, qreal opacity)
+{
+    m_classOpacity[cls] = std::clamp<qreal>(opacity, 0.0, 1.0);
+    refreshPalette();
+    update();
+}
+
+void OverlayLayer::setMasksVisible(bool visible)
+{
+    m_masksVisible = visible;
+    m_maskItem->setVisible(visible && !m_labelMask.isNull());
+}
+
+void OverlayLayer::setBoxesVisible(bool visible)
+{
+    m_boxesVisible = visible;
+    update();
+}
+
+void OverlayLayer::refreshMask()
+{
+    if (m_labelMask.isNull())
+    {
+        m_maskItem->setImage(QImage());
+        m_maskItem->setVisible(false);
+        return;
+    }
+
+    m_maskItem->setImage(m_labelMask);
+    refreshPalette();
+    m_maskItem->setVisible(m_masksVisible);
+}
+
+void OverlayLayer::refreshPalette()
+{
+    if (m_labelMask.isNull())
+        return;
+    // 只替换 256 项调色板：瓦片与金字塔保持标签值，绘制时套用新颜色
+    QVector<qreal> opacity(255);
+    for (int cls = 0; cls < opacity.size(); ++cls)
+        opacity[cls] = classOpacity(cls);
+    m_maskItem->setColorTable(InferenceEngine::segmentationColorTable(200, opacity));
+}
+
+QRectF OverlayLayer::boundingRect() const
+{
+    return m_bounds;
+}
+
+void OverlayLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+    if (!m_boxesVisible || m_boxes.isEmpty())
+        return;
+
+    const bool segmentation = (m_style == Style::Segmentation);
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setRenderHint(QPainter::TextAntialiasing, true);
+    painter->setFont(labelFont());
+    const QFontMetricsF fm(painter->font());
+    const qreal baseOpacity = painter->opacity();
+
+    for (const Box &box : m_boxes)
+    {
+        const qreal opacity = classOpacity(box.cls);
+        if (opacity <= 0.0)
+            continue;
+        painter->setOpacity(baseOpacity * opacity);
+        painter->setPen(QPen(box.color, segmentation ? 2.2 : 3.5));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(box.rect);
+
+        const QRectF textRect = labelRect(box, fm);
+        painter->fillRect(textRect, QColor(0, 0, 0, 170));
+        painter->setPen(segmentation ? QColor(Qt::white) : QColor(Qt::yellow));
+        painter->drawText(textRect.adjusted(6, 0, -6, 0), Qt::AlignVCenter | Qt::AlignLeft, box.text);
+    }
+    painter->setOpacity(baseOpacity);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <QColor>
+#include <QFont>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QSet>
+#include <QImage>
+#include <QString>
+#include <QVector>
+
+class QFontMetricsF;
+class TiledImageItem;
+
+// 结果叠加层：检测框与分割标签图作为独立图元绘制在底图之上，
+// 按类别切换可见性/不透明度时不触碰底图像素
+class OverlayLayer : public QGraphicsItem
+{
+public:
+    enum class Style
+    {
+        Detection,   // 粗框 + 黄色标签（含置信度）
+        Segmentation // 细框 + 白色标签
+    };
+
+    struct Box
+    {
+        QRectF rect;
+        QString text;
+        QColor color;
+        int cls{0};
+    };
+
+    explicit OverlayLayer(QGraphicsItem *parent = nullptr);
+
+    void setContent(const QVector<Box> &boxes, const QImage &labelMask, Style style);
+    void clearContent();
+
+    void setClassVisible(int cls, bool visible);
+    void setClassOpacity(int cls, qreal opacity);
+    void setMasksVisible(bool visible);
+    void setBoxesVisible(bool visible);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    qreal classOpacity(int cls) const;
+    QFont labelFont() const;
+    QRectF labelRect(const Box &box, const QFontMetricsF &fm) const;
+    void refreshMask();
+    void refreshPalette();
+
+    QVector<Box> m_boxes;
+    QRectF m_bounds;
+    QImage m_labelMask; // Indexed8 标签图，只改调色板，不改像素
+    TiledImageItem *m_maskItem{nullptr};
+    Style m_style{Style::Detection};
+    QHash<int, qreal> m_classOpacity; // 不在表中的类别为 1
+    QSet<int> m_hiddenClasses;
+    bool m_masksVisible{true};
+    bool m_boxesVisible{true};
+};
@@ -0,0 +1,281 @@
+#include "TiledImageItem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Indexed8 按最近邻减半：各层仍是标签值，换调色板无需重建
+    QImage halveIndexed(const QImage &source, int w, int h)
+    {
+        QImage out(w, h, QImage::Format_Indexed8);
+        out.setColorTable(source.colorTable());
+        for (int y = 0; y < h; ++y)
+        {
+            const uchar *src = source.constScanLine(std::min(2 * y, source.height() - 1));
+            uchar *dst = out.scanLine(y);
+            for (int x = 0; x < w; ++x)
+                dst[x] = src[std::min(2 * x, source.width() - 1)];
+        }
+        return out;
+    }
+
+    // 逐级减半直到整层不超过一个瓦片
+    std::vector<QImage> buildPyramid(const QImage &source)
+    {
+        std::vector<QImage> levels;
+        QImage current = source;
+        const bool indexed = source.format() == QImage::Format_Indexed8;
+        while (std::max(current.width(), current.height()) > TiledImageItem::kTileSize)
+        {
+            const int w = std::max(1, (current.width() + 1) / 2);
+            const int h = std::max(1, (current.height() + 1) / 2);
+            current = indexed ? halveIndexed(current, w, h)
+                              : current.scaled(w, h, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+            levels.push_back(current);
+        }
+        return levels;
+    }
+}
+
+TiledImageItem::TiledImageItem(QGraphicsItem *parent) : QGraphicsObject(parent)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    m_tiles.setMaxCost(256 * 1024); // 约 256 MB
+    m_indexedTiles.setMaxCost(64 * 1024);
+    connect(&m_pyramidWatcher, &QFutureWatcher<Pyramid>::finished,
+            this, &TiledImageItem::handlePyramidReady);
+}
+
+TiledImageItem::~TiledImageItem()
+{
+    m_pyramidWatcher.waitForFinished();
+}
+
+TiledImageItem::Level TiledImageItem::makeLevel(const QImage &img, const QSize &sourceSize)
+{
+    Level level;
+    level.image = img;
+    level.scaleX = static_cast<double>(sourceSize.width()) / std::max(1, img.width());
+    level.scaleY = static_cast<double>(sourceSize.height()) / std::max(1, img.height());
+    level.cols = (img.width() + kTileSize - 1) / kTileSize;
+    level.rows = (img.height() + kTileSize - 1) / kTileSize;
+    return level;
+}
+
+quint64 TiledImageItem::tileKey(int level, int tx, int ty)
+{
+    return (quint64(level) << 48) | (quint64(ty) << 24) | quint64(tx);
+}
+
+QSet<quint64> TiledImageItem::changedTiles(const QImage &previous, const QImage &next) const
+{
+    // 逐行比较原图瓦片，变化向上逐级传播到父瓦片
+    QSet<quint64> changed;
+    const Level &base = m_levels.front();
+    const int bytesPerPixel = next.depth() / 8;
+    for (int ty = 0; ty < base.rows; ++ty)
+    {
+        for (int tx = 0; tx < base.cols; ++tx)
+        {
+            const int x0 = tx * kTileSize;
+            const int y0 = ty * kTileSize;
+            const int w = std::min(kTileSize, next.width() - x0);
+            const int h = std::min(kTileSize, next.height() - y0);
+            const size_t rowBytes = static_cast<size_t>(w) * static_cast<size_t>(bytesPerPixel);
+            for (int y = y0; y < y0 + h; ++y)
+            {
+                if (std::memcmp(previous.constScanLine(y) + x0 * bytesPerPixel,
+                                next.constScanLine(y) + x0 * bytesPerPixel, rowBytes) != 0)
+                {
+                    changed.insert(tileKey(0, tx, ty));
+                    break;
+                }
+            }
+        }
+    }
+
+    QSet<quint64> levelChanged = changed;
+    for (int level = 1; level < static_cast<int>(m_levels.size()) && !levelChanged.isEmpty(); ++level)
+    {
+        QSet<quint64> parents;
+        for (quint64 key : levelChanged)
+        {
+            const int tx = static_cast<int>(key & 0xFFFFFF);
+            const int ty = static_cast<int>((key >> 24) & 0xFFFFFF);
+            parents.insert(tileKey(level, tx / 2, ty / 2));
+        }
+        changed.unite(parents);
+        levelChanged = parents;
+    }
+    return changed;
+}
+
+void TiledImageItem::setImage(const QImage &img)
+{
+    if (!img.isNull() && img.cacheKey() == m_source.cacheKey())
+        return;
+    // Indexed8 瓦片保存标签值，调色板不同也可增量更新
+    const bool indexed = img.format() == QImage::Format_Indexed8;
+    const bool incremental = !m_source.isNull() && !img.isNull() &&
+                             img.size() == m_source.size() && img.format() == m_source.format() &&
+                             (indexed || img.colorTable() == m_source.colorTable()) && img.depth() >= 8 &&
+                             !m_levels.empty();
+    if (indexed)
+        setColorTable(img.colorTable());
+    if (incremental)
+    {
+        const QSet<quint64> changed = changedTiles(m_source, img);
+        if (changed.isEmpty())
+        {
+            m_source = img;
+            m_levels.front().image = img;
+            return;
+        }
+        for (quint64 key : changed)
+        {
+            m_tiles.remove(key);
+            m_indexedTiles.remove(key);
+            if ((key >> 48) > 0)
+                m_staleTiles.insert(key);
+        }
+        m_source = img;
+        m_levels.front().image = img;
+        startPyramidBuild();
+        update();
+        return;
+    }
+
+    prepareGeometryChange();
+    m_source = img;
+    m_tiles.clear();
+    m_indexedTiles.clear();
+    m_staleTiles.clear();
+    m_levels.clear();
+    ++m_generation; // 清空或换图后，仍在进行的旧金字塔构建结果作废
+    if (!img.isNull())
+    {
+        m_levels.push_back(makeLevel(img, img.size()));
+        startPyramidBuild();
+    }
+    update();
+}
+
+void TiledImageItem::setColorTable(const QVector<QRgb> &table)
+{
+    if (table == m_palette)
+        return;
+    m_palette = table;
+    update();
+}
+
+void TiledImageItem::startPyramidBuild()
+{
+    const QImage source = m_source;
+    const quint64 generation = ++m_generation;
+    m_pyramidWatcher.setFuture(QtConcurrent::run([source, generation]()
+                                                 { return Pyramid{generation, buildPyramid(source)}; }));
+}
+
+void TiledImageItem::handlePyramidReady()
+{
+    // 图像被清空或替换后才送达的旧结果按代数丢弃，避免旧图层级复活
+    if (m_pyramidWatcher.isCanceled())
+        return;
+    const Pyramid pyramid = m_pyramidWatcher.result();
+    if (pyramid.generation != m_generation || m_levels.empty())
+        return;
+    m_levels.resize(1);
+    for (const QImage &img : pyramid.levels)
+        m_levels.push_back(makeLevel(img, m_source.size()));
+    m_staleTiles.clear();
+    update();
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), QSizeF(m_source.size()));
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (m_levels.empty())
+        return;
+
+    // 选择分辨率不低于屏幕显示的最粗层级
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    int levelIndex = 0;
+    if (lod > 0.0 && lod < 1.0)
+        levelIndex = static_cast<int>(std::floor(std::log2(1.0 / lod)));
+    levelIndex = std::clamp(levelIndex, 0, static_cast<int>(m_levels.size()) - 1);
+    const Level &level = m_levels[static_cast<size_t>(levelIndex)];
+    // 放大到 2 倍以上时按最近邻显示，既省开销也便于看清原始像素
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, lod < 2.0);
+
+    const QRectF exposed = option->exposedRect.intersected(boundingRect());
+    if (exposed.isEmpty())
+        return;
+    const double tileW = kTileSize * level.scaleX;
+    const double tileH = kTileSize * level.scaleY;
+    const int tx0 = std::max(0, static_cast<int>(std::floor(exposed.left() / tileW)));
+    const int ty0 = std::max(0, static_cast<int>(std::floor(exposed.top() / tileH)));
+    const int tx1 = std::min(level.cols - 1, static_cast<int>(std::floor(exposed.right() / tileW)));
+    const int ty1 = std::min(level.rows - 1, static_cast<int>(std::floor(exposed.bottom() / tileH)));
+
+    const bool indexed = level.image.format() == QImage::Format_Indexed8;
+    for (int ty = ty0; ty <= ty1; ++ty)
+    {
+        for (int tx = tx0; tx <= tx1; ++tx)
+        {
+            const QRect src(tx * kTileSize, ty * kTileSize,
+                            std::min(kTileSize, level.image.width() - tx * kTileSize),
+                            std::min(kTileSize, level.image.height() - ty * kTileSize));
+            const QRectF target(src.x() * level.scaleX, src.y() * level.scaleY,
+                                src.width() * level.scaleX, src.height() * level.scaleY);
+            const quint64 key = tileKey(levelIndex, tx, ty);
+
+            if (indexed)
+            {
+                // 标签瓦片只切一次，调色板变化时原地替换缓存瓦片的颜色表
+                QImage stale;
+                QImage *tile = nullptr;
+                if (m_staleTiles.contains(key))
+                {
+                    stale = m_source.copy(target.toAlignedRect());
+                    tile = &stale;
+                }
+                else if (!(tile = m_indexedTiles.object(key)))
+                {
+                    tile = new QImage(level.image.copy(src));
+                    const int cost = std::max(1, static_cast<int>(static_cast<qint64>(tile->width()) * tile->height() / 1024));
+                    m_indexedTiles.insert(key, tile, cost);
+                }
+                if (tile->colorTable() != m_palette)
+                    tile->setColorTable(m_palette);
+                painter->drawImage(target, *tile, QRectF(QPointF(0, 0), QSizeF(tile->size())));
+                continue;
+            }
+
+            if (QPixmap *cached = m_tiles.object(key))
+            {
+                painter->drawPixmap(target, *cached, QRectF(QPointF(0, 0), QSizeF(cached->size())));
+                continue;
+            }
+            if (m_staleTiles.contains(key))
+            {
+                // 高层瓦片尚未重建：直接从原图绘制该区域，不进缓存
+                painter->drawImage(target, m_source, target);
+                continue;
+            }
+
+            auto *pixmap = new QPixmap(QPixmap::fromImage(level.image.copy(src)));
+            const int cost = std::max(1, static_cast<int>(static_cast<qint64>(pixmap->width()) * pixmap->height() * 4 / 1024));
+            painter->drawPixmap(target, *pixmap, QRectF(QPointF(0, 0), QSizeF(pixmap->size())));
+            m_tiles.insert(key, pixmap, cost);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <QCache>
+#include <QFutureWatcher>
+#include <QGraphicsObject>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <vector>
+
+// 分块多分辨率图像项：后台生成 mip 金字塔，只绘制可见瓦片，按当前缩放选择最接近的层级
+class TiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    static constexpr int kTileSize = 512;
+
+    explicit TiledImageItem(QGraphicsItem *parent = nullptr);
+    ~TiledImageItem() override;
+
+    // 尺寸与格式不变时只作废内容变化的瓦片（如仅叠加层更新）
+    void setImage(const QImage &img);
+    // 仅对 Indexed8 图像：原地替换调色板，瓦片与金字塔保持标签值不失效，绘制时套用
+    void setColorTable(const QVector<QRgb> &table);
+    const QImage &image() const { return m_source; }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    // 后台金字塔结果，带发起时的图像代数
+    struct Pyramid
+    {
+        quint64 generation{0};
+        std::vector<QImage> levels;
+    };
+
+    struct Level
+    {
+        QImage image;
+        double scaleX{1.0}; // 该层一个像素对应原图的像素数
+        double scaleY{1.0};
+        int cols{0};
+        int rows{0};
+    };
+
+    static Level makeLevel(const QImage &img, const QSize &sourceSize);
+    static quint64 tileKey(int level, int tx, int ty);
+    QSet<quint64> changedTiles(const QImage &previous, const QImage &next) const;
+    void startPyramidBuild();
+    void handlePyramidReady();
+
+    QImage m_source;
+    std::vector<Level> m_levels;      // [0] 为原图，其余由后台生成
+    QCache<quint64, QPixmap> m_tiles; // 已上传的瓦片，开销按 KB 计
+    QCache<quint64, QImage> m_indexedTiles; // Indexed8 图像的瓦片，保留标签值，调色板在绘制时套用
+    QVector<QRgb> m_palette;                // Indexed8 图像当前的调色板
+    QSet<quint64> m_staleTiles;       // 金字塔重建完成前内容已过期的高层瓦片
+    QFutureWatcher<Pyramid> m_pyramidWatcher;
+    quint64 m_generation{0}; // 每次像素内容变化或清空时递增，旧代数的金字塔结果直接丢弃
+};